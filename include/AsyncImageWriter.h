@@ -0,0 +1,352 @@
+#ifndef ASYNC_IMAGE_WRITER_H
+#define ASYNC_IMAGE_WRITER_H
+
+#include "BoundedQueue.h"
+#include "FrameFile.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief File format of AsyncImageWriter
+ */
+enum class ImageEncoding {
+    Jpeg,  // Lossy, small, fast to encode at moderate quality
+    Png,   // Lossless; compression level trades size for encode time
+    Raw    // Uncompressed raw frame file (FrameFile.h): no encode, mapped back without decode
+};
+
+/**
+ * @brief Format and speed/size settings of an image file
+ */
+struct EncodeOptions {
+    ImageEncoding encoding = ImageEncoding::Jpeg;
+    int jpegQuality = 95;       // 0-100: lower is smaller and slightly faster
+    bool jpegOptimize = false;  // Optimized Huffman tables: a few % smaller, slower
+    int pngCompression = 1;     // 0-9: 0 stores, 1 is fast, 9 is smallest and slowest
+
+    /**
+     * @brief Get the file extension of the encoding
+     * @return ".jpg", ".png" or ".frames"
+     */
+    std::string extension() const {
+        switch (encoding) {
+            case ImageEncoding::Png: return ".png";
+            case ImageEncoding::Raw: return ".frames";
+            default: return ".jpg";
+        }
+    }
+
+    /**
+     * @brief Get the cv::imencode() parameters
+     * @return Flag/value pairs
+     */
+    std::vector<int> params() const {
+        switch (encoding) {
+            case ImageEncoding::Jpeg:
+                return {cv::IMWRITE_JPEG_QUALITY, std::min(std::max(jpegQuality, 0), 100),
+                        cv::IMWRITE_JPEG_OPTIMIZE, jpegOptimize ? 1 : 0};
+            case ImageEncoding::Png:
+                return {cv::IMWRITE_PNG_COMPRESSION, std::min(std::max(pngCompression, 0), 9)};
+            default:
+                return {};
+        }
+    }
+};
+
+/**
+ * @brief Counters of an AsyncImageWriter
+ */
+struct WriterStats {
+    size_t written = 0;        // Files written
+    size_t failed = 0;         // Files that could not be encoded or written
+    size_t dropped = 0;        // Images refused by tryWrite() because the queue was full
+    size_t bytesWritten = 0;   // Size of the files written
+    size_t pixelsEncoded = 0;  // Pixels of the images written
+    double encodeMs = 0.0;     // Time spent encoding, all threads added up
+    double writeMs = 0.0;      // Time spent writing files, all threads added up
+    double elapsedSeconds = 0.0;  // From the first image queued to the last file written
+
+    /**
+     * @brief Files written per second of wall time
+     * @return Throughput of the whole writer (0 before the first file)
+     */
+    double imagesPerSecond() const {
+        return elapsedSeconds > 0.0 ? written / elapsedSeconds : 0.0;
+    }
+
+    /**
+     * @brief Encoding speed of one thread
+     * @return Megapixels encoded per second of encoding time
+     */
+    double megapixelsPerSecond() const {
+        return encodeMs > 0.0 ? pixelsEncoded / (encodeMs * 1000.0) : 0.0;
+    }
+};
+
+/**
+ * @brief Encodes and writes images on a pool of writer threads
+ *
+ * write() queues a copy of the image, so the caller can reuse or modify it
+ * right away. Passing it with std::move() hands it over without a copy: the
+ * caller then gives up the image, and nothing may write to its pixels until
+ * the file is written (a chain result nobody else refers to). The queue is
+ * bounded: write() waits for room, while tryWrite() drops the image instead,
+ * so a processing loop is never held back by a slow disk or encoder.
+ * Missing directories of the output paths are created.
+ */
+class AsyncImageWriter {
+private:
+    struct Job {
+        std::string path;
+        cv::Mat image;
+        EncodeOptions options;
+    };
+
+    BoundedQueue<Job> queue;
+    std::vector<std::thread> threads;
+
+    mutable std::mutex mutex;
+    std::condition_variable idle;
+    WriterStats stats;
+    size_t pending = 0;
+    std::vector<std::string> errors;
+    std::chrono::steady_clock::time_point firstQueued;
+    std::chrono::steady_clock::time_point lastWritten;
+
+    static double msSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void encodeAndWrite(const Job& job, size_t& bytes, double& encodeMs, double& writeMs) {
+        std::filesystem::path parent = std::filesystem::path(job.path).parent_path();
+        if (!parent.empty() && !createDirectories(parent.string())) {
+            throw std::runtime_error("Cannot create the directory of " + job.path);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (job.options.encoding == ImageEncoding::Raw) {
+            FrameFileWriter writer(job.path);
+            writer.write(job.image);
+            writer.close();
+            writeMs = msSince(start);
+            bytes = static_cast<size_t>(std::filesystem::file_size(job.path));
+            return;
+        }
+
+        std::vector<uchar> buffer;
+        if (!cv::imencode(job.options.extension(), job.image, buffer, job.options.params())) {
+            throw std::runtime_error("Cannot encode " + job.path);
+        }
+        encodeMs = msSince(start);
+
+        start = std::chrono::steady_clock::now();
+        std::ofstream file(job.path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Cannot write " + job.path);
+        }
+        writeMs = msSince(start);
+        bytes = buffer.size();
+    }
+
+    void work() {
+        Job job;
+        while (queue.pop(job)) {
+            size_t bytes = 0;
+            double encodeMs = 0.0, writeMs = 0.0;
+            std::string error;
+            try {
+                encodeAndWrite(job, bytes, encodeMs, writeMs);
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (error.empty()) {
+                ++stats.written;
+                stats.bytesWritten += bytes;
+                stats.pixelsEncoded += job.image.total();
+            } else {
+                ++stats.failed;
+                errors.push_back(error);
+            }
+            stats.encodeMs += encodeMs;
+            stats.writeMs += writeMs;
+            lastWritten = std::chrono::steady_clock::now();
+            if (--pending == 0) {
+                idle.notify_all();
+            }
+        }
+    }
+
+    Job makeJob(const std::string& path, cv::Mat image, const EncodeOptions& options) {
+        if (image.empty()) {
+            throw std::invalid_argument("Cannot write an empty image");
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stats.written + stats.failed + pending == 0) {
+            firstQueued = std::chrono::steady_clock::now();
+        }
+        ++pending;
+        return Job{path, std::move(image), options};
+    }
+
+    void unqueued() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) {
+            idle.notify_all();
+        }
+    }
+
+public:
+    /**
+     * @brief Start the writer threads
+     * @param threadCount Number of writer threads (encoding is CPU-bound: 2 to 4 keep up with most chains)
+     * @param queueSize Images waiting to be written at most
+     */
+    explicit AsyncImageWriter(size_t threadCount = 2, size_t queueSize = 16) : queue(queueSize) {
+        for (size_t i = 0; i < std::max<size_t>(threadCount, 1); ++i) {
+            threads.emplace_back(&AsyncImageWriter::work, this);
+        }
+    }
+
+    AsyncImageWriter(const AsyncImageWriter&) = delete;
+    AsyncImageWriter& operator=(const AsyncImageWriter&) = delete;
+
+    /**
+     * @brief Write the queued images, then stop the threads
+     */
+    ~AsyncImageWriter() {
+        queue.close();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    /**
+     * @brief Create a directory and its parents, without a shell
+     * @param path Directory path
+     * @return true if it exists afterwards
+     */
+    static bool createDirectories(const std::string& path) {
+        std::error_code error;
+        std::filesystem::create_directories(path, error);
+        return std::filesystem::is_directory(path, error);
+    }
+
+    /**
+     * @brief Queue a copy of an image, waiting while the queue is full
+     * @param path Output file (its extension should match the encoding, see EncodeOptions::extension())
+     * @param image The image (copied: the caller keeps it)
+     * @param options Format and speed/size settings
+     */
+    void write(const std::string& path, const cv::Mat& image, const EncodeOptions& options = EncodeOptions()) {
+        write(path, image.clone(), options);
+    }
+
+    /**
+     * @brief Queue an image without copying it, waiting while the queue is full
+     * @param path Output file
+     * @param image The image, handed over: nothing may write to its pixels afterwards
+     * @param options Format and speed/size settings
+     */
+    void write(const std::string& path, cv::Mat&& image, const EncodeOptions& options = EncodeOptions()) {
+        if (!queue.push(makeJob(path, std::move(image), options))) {
+            unqueued();
+            throw std::runtime_error("The writer is stopped");
+        }
+    }
+
+    /**
+     * @brief Queue a copy of an image only if there is room, never waiting
+     * @param path Output file
+     * @param image The image (copied: the caller keeps it)
+     * @param options Format and speed/size settings
+     * @return false if the queue was full (the image is dropped and counted)
+     */
+    bool tryWrite(const std::string& path, const cv::Mat& image, const EncodeOptions& options = EncodeOptions()) {
+        // Copy only once a place is held: a dropped image costs no clone
+        if (!queue.tryReserve()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++stats.dropped;
+            return false;
+        }
+        Job job;
+        try {
+            job = makeJob(path, image.clone(), options);
+        } catch (...) {
+            queue.cancelReservation();
+            throw;
+        }
+        if (queue.pushReserved(std::move(job))) {
+            return true;
+        }
+        unqueued();
+        std::lock_guard<std::mutex> lock(mutex);
+        ++stats.dropped;
+        return false;
+    }
+
+    /**
+     * @brief Queue an image without copying it only if there is room, never waiting
+     * @param path Output file
+     * @param image The image, handed over: nothing may write to its pixels afterwards
+     * @param options Format and speed/size settings
+     * @return false if the queue was full (the image is dropped and counted)
+     */
+    bool tryWrite(const std::string& path, cv::Mat&& image, const EncodeOptions& options = EncodeOptions()) {
+        if (queue.tryPush(makeJob(path, std::move(image), options))) {
+            return true;
+        }
+        unqueued();
+        std::lock_guard<std::mutex> lock(mutex);
+        ++stats.dropped;
+        return false;
+    }
+
+    /**
+     * @brief Wait until every queued image is written
+     */
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this]() { return pending == 0; });
+    }
+
+    /**
+     * @brief Get a snapshot of the counters
+     * @return Files written, bytes, encode and write times, throughput
+     */
+    WriterStats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        WriterStats snapshot = stats;
+        if (stats.written + stats.failed > 0) {
+            snapshot.elapsedSeconds = std::chrono::duration<double>(lastWritten - firstQueued).count();
+        }
+        return snapshot;
+    }
+
+    /**
+     * @brief Get and clear the messages of the failed files
+     * @return One message per failure
+     */
+    std::vector<std::string> takeErrors() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::string> taken;
+        taken.swap(errors);
+        return taken;
+    }
+};
+
+#endif // ASYNC_IMAGE_WRITER_H
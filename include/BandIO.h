@@ -0,0 +1,397 @@
+#ifndef BAND_IO_H
+#define BAND_IO_H
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Reads an image by horizontal bands, without loading it whole
+ */
+class BandReader {
+public:
+    virtual ~BandReader() = default;
+
+    /**
+     * @brief Get the size of the whole image
+     * @return Width and height
+     */
+    virtual cv::Size getSize() const = 0;
+
+    /**
+     * @brief Get the type of the image
+     * @return cv::Mat type (e.g. CV_8UC3)
+     */
+    virtual int getType() const = 0;
+
+    /**
+     * @brief Read consecutive rows
+     * @param y First row
+     * @param rows Number of rows
+     * @return A rows x width image
+     */
+    virtual cv::Mat readRows(int y, int rows) = 0;
+};
+
+/**
+ * @brief Writes an image band after band, top to bottom
+ */
+class BandWriter {
+public:
+    virtual ~BandWriter() = default;
+
+    /**
+     * @brief Start an image
+     * @param size Size of the whole image
+     * @param type cv::Mat type of the image
+     */
+    virtual void open(const cv::Size& size, int type) = 0;
+
+    /**
+     * @brief Append rows below the previous ones
+     * @param rows A band of the image (full width, image type)
+     */
+    virtual void writeRows(const cv::Mat& rows) = 0;
+
+    /**
+     * @brief Finish the image
+     */
+    virtual void close() = 0;
+};
+
+namespace detail {
+
+/**
+ * @brief Binary file of rows of fixed length after a header
+ */
+class RowFile {
+protected:
+    std::string path;
+    cv::Size size;
+    int type = CV_8UC1;
+    std::streamoff dataOffset = 0;
+
+    size_t rowBytes() const {
+        return static_cast<size_t>(size.width) * CV_ELEM_SIZE(type);
+    }
+};
+
+/**
+ * @brief Convert a row between OpenCV order (BGR, native endianness) and PNM order (RGB, big endian)
+ * @param maxValue Samples above it are clamped (the maxval of the file)
+ */
+inline void pnmRowOrder(const uint8_t* src, uint8_t* dst, int width, int type, int maxValue) {
+    const int cn = CV_MAT_CN(type);
+    const int bytes = static_cast<int>(CV_ELEM_SIZE1(type));
+    for (int x = 0; x < width; ++x) {
+        for (int c = 0; c < cn; ++c) {
+            const uint8_t* s = src + (x * cn + (cn == 3 ? 2 - c : c)) * bytes;
+            uint8_t* d = dst + (x * cn + c) * bytes;
+            if (bytes == 2) {
+                uint16_t v;
+                std::memcpy(&v, s, 2);
+                v = static_cast<uint16_t>(std::min<int>(v, maxValue));
+                d[0] = static_cast<uint8_t>(v >> 8);  // PNM samples are big endian
+                d[1] = static_cast<uint8_t>(v & 0xFF);
+            } else {
+                d[0] = static_cast<uint8_t>(std::min<int>(s[0], maxValue));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Inverse of pnmRowOrder()
+ */
+inline void pnmRowToMat(const uint8_t* src, uint8_t* dst, int width, int type) {
+    const int cn = CV_MAT_CN(type);
+    const int bytes = static_cast<int>(CV_ELEM_SIZE1(type));
+    for (int x = 0; x < width; ++x) {
+        for (int c = 0; c < cn; ++c) {
+            const uint8_t* s = src + (x * cn + c) * bytes;
+            uint8_t* d = dst + (x * cn + (cn == 3 ? 2 - c : c)) * bytes;
+            if (bytes == 2) {
+                uint16_t v = static_cast<uint16_t>((s[0] << 8) | s[1]);
+                std::memcpy(d, &v, 2);
+            } else {
+                d[0] = s[0];
+            }
+        }
+    }
+}
+
+inline bool isPnmType(int type) {
+    return type == CV_8UC1 || type == CV_8UC3 || type == CV_16UC1 || type == CV_16UC3;
+}
+
+} // namespace detail
+
+/**
+ * @brief Band reader for headerless raw files (rows of pixels, OpenCV layout)
+ */
+class RawBandReader : public BandReader, private detail::RowFile {
+private:
+    std::ifstream file;
+
+public:
+    /**
+     * @brief Open a raw file
+     * @param filepath Path of the file
+     * @param imageSize Size of the image it holds
+     * @param imageType cv::Mat type of its pixels (interleaved channels, native endianness)
+     * @param headerBytes Bytes to skip before the first row
+     */
+    RawBandReader(const std::string& filepath, const cv::Size& imageSize, int imageType, size_t headerBytes = 0)
+        : file(filepath, std::ios::binary) {
+        if (!file) {
+            throw std::runtime_error("Cannot open " + filepath);
+        }
+        path = filepath;
+        size = imageSize;
+        type = imageType;
+        dataOffset = static_cast<std::streamoff>(headerBytes);
+
+        file.seekg(0, std::ios::end);
+        std::streamoff length = file.tellg();
+        if (length < dataOffset + static_cast<std::streamoff>(rowBytes()) * size.height) {
+            throw std::runtime_error(filepath + " is smaller than a " + std::to_string(size.width) + "x" +
+                                     std::to_string(size.height) + " image");
+        }
+    }
+
+    cv::Size getSize() const override {
+        return size;
+    }
+
+    int getType() const override {
+        return type;
+    }
+
+    cv::Mat readRows(int y, int rows) override {
+        if (y < 0 || rows < 1 || y + rows > size.height) {
+            throw std::out_of_range("Rows out of range");
+        }
+        cv::Mat band(rows, size.width, type);
+        file.seekg(dataOffset + static_cast<std::streamoff>(rowBytes()) * y);
+        file.read(reinterpret_cast<char*>(band.data), static_cast<std::streamsize>(rowBytes() * rows));
+        if (!file) {
+            throw std::runtime_error("Cannot read " + path);
+        }
+        return band;
+    }
+};
+
+/**
+ * @brief Band writer for headerless raw files
+ */
+class RawBandWriter : public BandWriter, private detail::RowFile {
+private:
+    std::ofstream file;
+    int rowsWritten = 0;
+
+public:
+    /**
+     * @brief Create a writer
+     * @param filepath Path of the file to write (replaced)
+     */
+    explicit RawBandWriter(const std::string& filepath) {
+        path = filepath;
+    }
+
+    void open(const cv::Size& imageSize, int imageType) override {
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Cannot create " + path);
+        }
+        size = imageSize;
+        type = imageType;
+        rowsWritten = 0;
+    }
+
+    void writeRows(const cv::Mat& rows) override {
+        if (rows.cols != size.width || rows.type() != type || rowsWritten + rows.rows > size.height) {
+            throw std::invalid_argument("Band does not match the image being written");
+        }
+        for (int y = 0; y < rows.rows; ++y) {
+            file.write(reinterpret_cast<const char*>(rows.ptr(y)), static_cast<std::streamsize>(rowBytes()));
+        }
+        if (!file) {
+            throw std::runtime_error("Cannot write " + path);
+        }
+        rowsWritten += rows.rows;
+    }
+
+    void close() override {
+        file.close();
+        if (rowsWritten != size.height) {
+            throw std::runtime_error(path + " is incomplete: " + std::to_string(rowsWritten) + " of " +
+                                     std::to_string(size.height) + " rows written");
+        }
+    }
+};
+
+/**
+ * @brief Band reader for binary PGM/PPM files (P5/P6, 8 or 16 bits)
+ *
+ * Netpbm files are rows of pixels after a short text header, so any band
+ * can be read with one seek. OpenCV reads and writes them too.
+ */
+class PnmBandReader : public BandReader, private detail::RowFile {
+private:
+    std::ifstream file;
+    std::vector<uint8_t> rowBuffer;
+    int maxValue = 255;  // maxval of the header
+
+    int readHeaderValue() {
+        int c = file.get();
+        while (c == '#' || std::isspace(c)) {
+            if (c == '#') {
+                while (c != '\n' && c != EOF) {
+                    c = file.get();
+                }
+            }
+            c = file.get();
+        }
+        int value = 0;
+        if (!std::isdigit(c)) {
+            throw std::runtime_error(path + " is not a binary PGM/PPM file");
+        }
+        while (std::isdigit(c)) {
+            value = value * 10 + (c - '0');
+            c = file.get();
+        }
+        return value;  // The single whitespace after the value is consumed
+    }
+
+public:
+    /**
+     * @brief Open a PGM (P5) or PPM (P6) file and read its header
+     * @param filepath Path of the file
+     */
+    explicit PnmBandReader(const std::string& filepath) : file(filepath, std::ios::binary) {
+        path = filepath;
+        char magic[2] = {0, 0};
+        if (!file.read(magic, 2) || magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6')) {
+            throw std::runtime_error(filepath + " is not a binary PGM/PPM file");
+        }
+        size.width = readHeaderValue();
+        size.height = readHeaderValue();
+        maxValue = readHeaderValue();
+        if (size.width < 1 || size.height < 1 || maxValue < 1 || maxValue > 65535) {
+            throw std::runtime_error(filepath + " has an invalid header");
+        }
+        int depth = maxValue > 255 ? CV_16U : CV_8U;
+        type = CV_MAKETYPE(depth, magic[1] == '6' ? 3 : 1);
+        dataOffset = file.tellg();
+        rowBuffer.resize(rowBytes());
+    }
+
+    cv::Size getSize() const override {
+        return size;
+    }
+
+    int getType() const override {
+        return type;
+    }
+
+    /**
+     * @brief Get the largest sample value declared in the header
+     * @return maxval (1-255 for 8-bit files, 256-65535 for 16-bit files)
+     */
+    int getMaxValue() const {
+        return maxValue;
+    }
+
+    cv::Mat readRows(int y, int rows) override {
+        if (y < 0 || rows < 1 || y + rows > size.height) {
+            throw std::out_of_range("Rows out of range");
+        }
+        cv::Mat band(rows, size.width, type);
+        file.seekg(dataOffset + static_cast<std::streamoff>(rowBytes()) * y);
+        for (int r = 0; r < rows; ++r) {
+            if (!file.read(reinterpret_cast<char*>(rowBuffer.data()), static_cast<std::streamsize>(rowBytes()))) {
+                throw std::runtime_error("Cannot read " + path);
+            }
+            detail::pnmRowToMat(rowBuffer.data(), band.ptr(r), size.width, type);
+        }
+        return band;
+    }
+};
+
+/**
+ * @brief Band writer for binary PGM/PPM files (CV_8UC1/3, CV_16UC1/3)
+ */
+class PnmBandWriter : public BandWriter, private detail::RowFile {
+private:
+    std::ofstream file;
+    std::vector<uint8_t> rowBuffer;
+    int rowsWritten = 0;
+    int requestedMax;  // maxval asked for, 0 for the full range of the depth
+    int maxValue = 255;  // maxval of the image being written
+
+public:
+    /**
+     * @brief Create a writer
+     * @param filepath Path of the file to write (replaced)
+     * @param maxSample maxval of the header, e.g. PnmBandReader::getMaxValue() to keep
+     *                  the range of the input (samples above it are clamped); 0 for the
+     *                  full range of the image depth (255 or 65535)
+     */
+    explicit PnmBandWriter(const std::string& filepath, int maxSample = 0)
+        : requestedMax(maxSample) {
+        path = filepath;
+    }
+
+    void open(const cv::Size& imageSize, int imageType) override {
+        if (!detail::isPnmType(imageType)) {
+            throw std::invalid_argument("PGM/PPM files hold 8 or 16-bit images with 1 or 3 channels");
+        }
+        const bool wide = CV_MAT_DEPTH(imageType) == CV_16U;
+        if (requestedMax != 0 && (wide ? requestedMax < 256 || requestedMax > 65535
+                                       : requestedMax < 1 || requestedMax > 255)) {
+            throw std::invalid_argument("maxval " + std::to_string(requestedMax) + " does not match a " +
+                                        (wide ? "16" : "8") + "-bit image");
+        }
+        maxValue = requestedMax != 0 ? requestedMax : (wide ? 65535 : 255);
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Cannot create " + path);
+        }
+        size = imageSize;
+        type = imageType;
+        rowsWritten = 0;
+        rowBuffer.resize(rowBytes());
+        file << (CV_MAT_CN(type) == 3 ? "P6" : "P5") << "\n" << size.width << " " << size.height << "\n"
+             << maxValue << "\n";
+    }
+
+    void writeRows(const cv::Mat& rows) override {
+        if (rows.cols != size.width || rows.type() != type || rowsWritten + rows.rows > size.height) {
+            throw std::invalid_argument("Band does not match the image being written");
+        }
+        for (int y = 0; y < rows.rows; ++y) {
+            detail::pnmRowOrder(rows.ptr(y), rowBuffer.data(), size.width, type, maxValue);
+            file.write(reinterpret_cast<const char*>(rowBuffer.data()), static_cast<std::streamsize>(rowBytes()));
+        }
+        if (!file) {
+            throw std::runtime_error("Cannot write " + path);
+        }
+        rowsWritten += rows.rows;
+    }
+
+    void close() override {
+        file.close();
+        if (rowsWritten != size.height) {
+            throw std::runtime_error(path + " is incomplete: " + std::to_string(rowsWritten) + " of " +
+                                     std::to_string(size.height) + " rows written");
+        }
+    }
+};
+
+#endif // BAND_IO_H
@@ -0,0 +1,151 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+
+/**
+ * @brief FIFO queue between threads, holding at most a fixed number of items
+ *
+ * push() waits while the queue is full, so a fast producer is held back by
+ * a slow consumer instead of piling up frames in memory. close() ends the
+ * stream: pop() then drains what is left and returns false. tryReserve()
+ * holds a place before the item exists, so a producer that must copy its
+ * item only pays for the copy when it will be queued.
+ */
+template <typename T>
+class BoundedQueue {
+private:
+    std::deque<T> items;
+    size_t capacity;
+    size_t reserved = 0;  // Places held by tryReserve(), not yet filled
+    bool closed = false;
+    mutable std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+
+public:
+    /**
+     * @brief Create a queue
+     * @param maxItems Capacity (at least 1)
+     */
+    explicit BoundedQueue(size_t maxItems) : capacity(maxItems) {
+        if (capacity < 1) {
+            throw std::invalid_argument("Queue capacity must be at least 1");
+        }
+    }
+
+    /**
+     * @brief Append an item, waiting for room
+     * @param item The item
+     * @return false if the queue was closed (the item is dropped)
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]() { return closed || items.size() + reserved < capacity; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Append an item only if there is room, without waiting
+     * @param item The item
+     * @return false if the queue is full or closed (the item is dropped)
+     */
+    bool tryPush(T item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed || items.size() + reserved >= capacity) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Hold a place for an item, without waiting
+     *
+     * A successful call must be followed by exactly one pushReserved() or
+     * cancelReservation().
+     *
+     * @return false if the queue is full or closed
+     */
+    bool tryReserve() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed || items.size() + reserved >= capacity) {
+            return false;
+        }
+        ++reserved;
+        return true;
+    }
+
+    /**
+     * @brief Append an item in the place held by tryReserve()
+     * @param item The item
+     * @return false if the queue was closed meanwhile (the item is dropped)
+     */
+    bool pushReserved(T item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        --reserved;
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Give back the place held by tryReserve()
+     */
+    void cancelReservation() {
+        std::lock_guard<std::mutex> lock(mutex);
+        --reserved;
+        notFull.notify_one();
+    }
+
+    /**
+     * @brief Take the oldest item, waiting for one
+     * @param item Receives the item
+     * @return false once the queue is closed and empty
+     */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]() { return closed || !items.empty(); });
+        if (items.empty()) {
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief End the stream: wake every waiting thread, refuse new items
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    /**
+     * @brief Get the number of items waiting
+     * @return Item count
+     */
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.size();
+    }
+};
+
+#endif // BOUNDED_QUEUE_H
@@ -0,0 +1,242 @@
+#ifndef CHAIN_SPEC_H
+#define CHAIN_SPEC_H
+
+#include "TreatmentChain.h"
+#include "treatments/GrayscaleTreatment.h"
+#include "treatments/GaussianBlurTreatment.h"
+#include "treatments/MedianBlurTreatment.h"
+#include "treatments/CannyEdgeTreatment.h"
+#include "treatments/ThresholdTreatment.h"
+#include "treatments/BrightnessTreatment.h"
+#include "treatments/SharpenTreatment.h"
+#include "treatments/ErosionTreatment.h"
+#include "treatments/DilationTreatment.h"
+#include "treatments/MosaicTreatment.h"
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Text form of a treatment chain, to store it or send it to another process
+ *
+ * A spec lists the stages in order, separated by '|'. Each stage is the
+ * treatment name (Treatment::getName()) with its parameters in parentheses;
+ * omitted parameters keep their default values:
+ *
+ *   Grayscale | Gaussian Blur(kernelSize=5, sigmaX=1.5) | Canny Edge Detection(threshold1=50, threshold2=150)
+ *
+ * Treatments are built by name from a registry holding the single-input
+ * treatments of this library; registerTreatment() adds others.
+ */
+class ChainSpec {
+public:
+    using Factory = std::function<std::unique_ptr<Treatment>()>;
+
+private:
+    struct Registry {
+        std::mutex mutex;
+        std::map<std::string, Factory> factories;
+
+        Registry() {
+            add(*this, []() { return std::make_unique<GrayscaleTreatment>(); });
+            add(*this, []() { return std::make_unique<GaussianBlurTreatment>(); });
+            add(*this, []() { return std::make_unique<MedianBlurTreatment>(); });
+            add(*this, []() { return std::make_unique<CannyEdgeTreatment>(); });
+            add(*this, []() { return std::make_unique<ThresholdTreatment>(); });
+            add(*this, []() { return std::make_unique<BrightnessTreatment>(); });
+            add(*this, []() { return std::make_unique<SharpenTreatment>(); });
+            add(*this, []() { return std::make_unique<ErosionTreatment>(); });
+            add(*this, []() { return std::make_unique<DilationTreatment>(); });
+            add(*this, []() { return std::make_unique<MosaicTreatment>(); });
+        }
+    };
+
+    static Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    static void add(Registry& target, Factory factory) {
+        std::string name = factory()->getName();
+        target.factories[name] = std::move(factory);
+    }
+
+    static std::string trim(const std::string& text) {
+        size_t first = text.find_first_not_of(" \t\r\n");
+        if (first == std::string::npos) {
+            return "";
+        }
+        size_t last = text.find_last_not_of(" \t\r\n");
+        return text.substr(first, last - first + 1);
+    }
+
+    static std::vector<std::string> split(const std::string& text, char separator) {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        for (size_t end; (end = text.find(separator, start)) != std::string::npos; start = end + 1) {
+            parts.push_back(text.substr(start, end - start));
+        }
+        parts.push_back(text.substr(start));
+        return parts;
+    }
+
+    /**
+     * @brief Format a parameter so that setParameter() gets back its exact value
+     *
+     * getParameters() rounds doubles to 6 decimals: a numeric value is written
+     * from getParameterValues() with max_digits10 digits instead, which
+     * std::stod() reads back bit for bit (integers still print plainly).
+     */
+    static std::string formatParameter(const std::string& text, const std::map<std::string, double>& values,
+                                       const std::string& name) {
+        auto value = values.find(name);
+        if (value == values.end()) {
+            return text;
+        }
+        try {
+            size_t used = 0;
+            std::stod(text, &used);
+            if (used != text.size()) {
+                return text;  // Numeric prefix only ("3x3"): not the value
+            }
+        } catch (const std::exception&) {
+            return text;
+        }
+        std::ostringstream out;
+        out << std::setprecision(std::numeric_limits<double>::max_digits10) << value->second;
+        return out.str();
+    }
+
+    static std::unique_ptr<Treatment> parseStage(const std::string& stage) {
+        std::string name = stage;
+        std::string arguments;
+        size_t open = stage.find('(');
+        if (open != std::string::npos) {
+            if (stage.back() != ')') {
+                throw std::invalid_argument("Missing ')' in chain stage: " + stage);
+            }
+            name = stage.substr(0, open);
+            arguments = stage.substr(open + 1, stage.size() - open - 2);
+        }
+        name = trim(name);
+
+        std::unique_ptr<Treatment> treatment = create(name);
+        if (trim(arguments).empty()) {
+            return treatment;
+        }
+        for (const std::string& argument : split(arguments, ',')) {
+            size_t equals = argument.find('=');
+            if (equals == std::string::npos) {
+                throw std::invalid_argument("Expected name=value in chain stage " + name + ": " + trim(argument));
+            }
+            std::string parameter = trim(argument.substr(0, equals));
+            std::string value = trim(argument.substr(equals + 1));
+            if (!treatment->setParameter(parameter, value)) {
+                throw std::invalid_argument("Invalid parameter of " + name + ": " + parameter + "=" + value);
+            }
+        }
+        return treatment;
+    }
+
+public:
+    /**
+     * @brief Make a treatment available to parse() under its name
+     * @param factory Creates the treatment with its default parameters
+     */
+    static void registerTreatment(Factory factory) {
+        if (!factory) {
+            throw std::invalid_argument("Treatment factory cannot be empty");
+        }
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        add(shared, std::move(factory));
+    }
+
+    /**
+     * @brief Create a registered treatment with its default parameters
+     * @param name Treatment name, as returned by getName()
+     * @return The new treatment
+     */
+    static std::unique_ptr<Treatment> create(const std::string& name) {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        auto it = shared.factories.find(name);
+        if (it == shared.factories.end()) {
+            throw std::invalid_argument("Unknown treatment in chain spec: " + name);
+        }
+        return it->second();
+    }
+
+    /**
+     * @brief Get the names parse() accepts
+     * @return Registered treatment names, sorted
+     */
+    static std::vector<std::string> getTreatmentNames() {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        std::vector<std::string> names;
+        for (const auto& entry : shared.factories) {
+            names.push_back(entry.first);
+        }
+        return names;
+    }
+
+    /**
+     * @brief Write the spec of a chain
+     * @param chain The chain
+     * @return Stages with all their parameters ("" for an empty chain);
+     *         parse() rebuilds the same chain, floating-point values included
+     */
+    static std::string toString(const TreatmentChain& chain) {
+        std::string spec;
+        for (size_t i = 0; i < chain.getTreatmentCount(); ++i) {
+            const Treatment* treatment = chain.getTreatment(i);
+            if (i > 0) {
+                spec += " | ";
+            }
+            spec += treatment->getName();
+            std::map<std::string, std::string> parameters = treatment->getParameters();
+            if (parameters.empty()) {
+                continue;
+            }
+            std::map<std::string, double> values = treatment->getParameterValues();
+            spec += "(";
+            for (auto it = parameters.begin(); it != parameters.end(); ++it) {
+                spec += (it == parameters.begin() ? "" : ", ") + it->first + "=" +
+                        formatParameter(it->second, values, it->first);
+            }
+            spec += ")";
+        }
+        return spec;
+    }
+
+    /**
+     * @brief Build the chain a spec describes
+     * @param spec The spec (see the class description)
+     * @return The chain (empty for a blank spec)
+     * @throws std::invalid_argument for an unknown treatment or an invalid parameter
+     */
+    static TreatmentChain parse(const std::string& spec) {
+        TreatmentChain chain;
+        if (trim(spec).empty()) {
+            return chain;
+        }
+        for (const std::string& stage : split(spec, '|')) {
+            std::string trimmed = trim(stage);
+            if (trimmed.empty()) {
+                throw std::invalid_argument("Empty stage in chain spec: " + spec);
+            }
+            chain.addTreatment(parseStage(trimmed));
+        }
+        return chain;
+    }
+};
+
+#endif // CHAIN_SPEC_H
@@ -0,0 +1,128 @@
+#ifndef FORMAT_PLANNER_H
+#define FORMAT_PLANNER_H
+
+#include "TreatmentChain.h"
+#include "treatments/GrayscaleTreatment.h"
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Result of FormatPlanner::plan()
+ */
+struct FormatPlan {
+    TreatmentChain chain;               // Planned chain (clones of the original treatments)
+    std::vector<ImageFormat> formats;   // Format entering each stage, then the chain output
+    std::vector<std::string> changes;   // One line per rewrite, for logs
+};
+
+/**
+ * @brief Rewrites a chain so a color frame is converted to gray exactly once
+ *
+ * Treatments declare the formats they accept with getFormatTraits(). Luma-only
+ * treatments (Threshold, Canny...) convert a color input themselves, and a
+ * Grayscale stage on a gray image is a no-op. For a given input format the
+ * planner:
+ * - inserts a single Grayscale stage before the first luma-only treatment,
+ *   so every later stage receives a gray image and converts nothing;
+ * - with setHoistConversion(true), moves that conversion ahead of the linear
+ *   per-channel filters (Gaussian Blur, Mosaic) just before it, since only
+ *   the luma of their result is used: they then run on one channel instead
+ *   of three;
+ * - drops every other Grayscale stage;
+ * - checks that each stage accepts the format it receives.
+ *
+ * Moving the conversion changes where results are rounded to 8 bits, so
+ * outputs may differ by one gray level: it is off by default, so the planned
+ * chain gives results identical to the original one.
+ */
+class FormatPlanner {
+private:
+    bool hoistConversion = false;
+
+    static bool isGrayscale(const Treatment& treatment) {
+        return treatment.getName() == "Grayscale";
+    }
+
+public:
+    /**
+     * @brief Choose whether the conversion may move ahead of linear filters
+     * @param hoist true to run the filters on one channel, false (default) for
+     *              results identical to the original chain
+     */
+    void setHoistConversion(bool hoist) {
+        hoistConversion = hoist;
+    }
+
+    /**
+     * @brief Plan a chain for an input format
+     * @param chain The chain to rewrite (left unchanged)
+     * @param inputSize Size of the frames the chain will receive
+     * @param inputType Type of those frames (e.g. CV_8UC3)
+     * @return The planned chain, the format at each stage and the rewrites made
+     */
+    FormatPlan plan(const TreatmentChain& chain, const cv::Size& inputSize, int inputType) const {
+        std::vector<std::unique_ptr<Treatment>> stages;
+        for (size_t i = 0; i < chain.getTreatmentCount(); ++i) {
+            stages.push_back(chain.getTreatment(i)->clone());
+        }
+
+        FormatPlan result;
+        const int channels = CV_MAT_CN(inputType);
+
+        // First stage that only needs the luma of a color input
+        size_t lumaStage = stages.size();
+        if (channels == 3 || channels == 4) {
+            for (size_t i = 0; i < stages.size(); ++i) {
+                if (stages[i]->getFormatTraits().lumaOnly) {
+                    lumaStage = i;
+                    break;
+                }
+            }
+        }
+
+        // Drop the Grayscale stages; the single conversion is reinserted below
+        std::vector<std::unique_ptr<Treatment>> kept;
+        size_t convertAt = stages.size();
+        for (size_t i = 0; i < stages.size(); ++i) {
+            if (i == lumaStage) {
+                convertAt = kept.size();
+            }
+            if (isGrayscale(*stages[i])) {
+                result.changes.push_back("Removed Grayscale (stage " + std::to_string(i) + ")");
+            } else {
+                kept.push_back(std::move(stages[i]));
+            }
+        }
+
+        if (lumaStage < stages.size()) {
+            size_t target = convertAt;
+            while (hoistConversion && target > 0 && kept[target - 1]->getFormatTraits().linear) {
+                --target;
+                result.changes.push_back("Moved the gray conversion ahead of " + kept[target]->getName());
+            }
+            kept.insert(kept.begin() + target, std::make_unique<GrayscaleTreatment>());
+            result.changes.push_back("Inserted Grayscale at stage " + std::to_string(target));
+        }
+
+        ImageFormat format{inputSize, inputType};
+        for (size_t i = 0; i < kept.size(); ++i) {
+            if (!kept[i]->getFormatTraits().accepts(format.type)) {
+                throw std::invalid_argument("Stage " + std::to_string(i) + " (" + kept[i]->getName() +
+                                            ") does not accept " + std::to_string(CV_MAT_CN(format.type)) +
+                                            "-channel images of depth " + std::to_string(CV_MAT_DEPTH(format.type)));
+            }
+            result.formats.push_back(format);
+            format = kept[i]->prepare(format.size, format.type);
+            result.chain.addTreatment(std::move(kept[i]));
+        }
+        result.formats.push_back(format);
+        if (result.chain.getTreatmentNames() == chain.getTreatmentNames()) {
+            result.changes.clear();  // Removed and reinserted at the same place
+        }
+        return result;
+    }
+};
+
+#endif // FORMAT_PLANNER_H
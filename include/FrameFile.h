@@ -0,0 +1,478 @@
+#ifndef FRAME_FILE_H
+#define FRAME_FILE_H
+
+#include "ImageSource.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Raw frame files (.frames) hold decoded frames exactly as they are in
+ * memory, so reading one back is a memory mapping instead of a decode:
+ *
+ *   file header   64 bytes  "ITFRAMES", version, header size, frame count
+ *   frame header  64 bytes  "FRAM", rows, cols, cv::Mat type, row stride, timestamp (us)
+ *   pixel rows    rows * stride bytes
+ *   ...           next frame header, at the next multiple of 64 bytes
+ *
+ * Fields are little endian. Every header and every frame starts on a 64-byte
+ * boundary of the file, hence of the mapping.
+ */
+namespace frame_file {
+
+constexpr uint32_t VERSION = 1;
+constexpr size_t ALIGNMENT = 64;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerBytes;
+    uint64_t frameCount;  // 0 if the writer was not closed: frames are then counted on reading
+    uint8_t reserved[40];
+};
+
+struct FrameHeader {
+    char magic[4];
+    int32_t rows;
+    int32_t cols;
+    int32_t type;
+    uint64_t step;
+    int64_t timestampUs;
+    uint8_t reserved[32];
+};
+
+static_assert(sizeof(FileHeader) == 64 && sizeof(FrameHeader) == 64, "Frame file headers are 64 bytes");
+
+inline uint64_t aligned(uint64_t offset) {
+    return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+/**
+ * @brief Read-only view of a whole file, mapped copy-on-write
+ *
+ * Pages are loaded on first access. Writing to them (a treatment working in
+ * place) copies the page for this process only; the file is never modified,
+ * but the mapping now holds the written pixels for the rest of its life.
+ */
+class MappedFile {
+private:
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER fileSize;
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+            unmap();
+            throw std::runtime_error("Cannot open " + path);
+        }
+        length = static_cast<size_t>(fileSize.QuadPart);
+        if (length > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+            void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0) : nullptr;
+            if (view == nullptr) {
+                unmap();
+                throw std::runtime_error("Cannot map " + path);
+            }
+            base = static_cast<const uint8_t*>(view);
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            throw std::runtime_error("Cannot open " + path);
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            void* view = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (view == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map " + path);
+            }
+            base = static_cast<const uint8_t*>(view);
+        }
+        ::close(fd);  // The mapping keeps the file open
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        unmap();
+    }
+
+    const uint8_t* data() const {
+        return base;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+private:
+    void unmap() {
+#ifdef _WIN32
+        if (base != nullptr) {
+            UnmapViewOfFile(base);
+        }
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (base != nullptr) {
+            munmap(const_cast<uint8_t*>(base), length);
+        }
+#endif
+        base = nullptr;
+    }
+};
+
+/**
+ * @brief Owner of the Mats that point into a MappedFile
+ *
+ * Each such Mat carries a reference to its mapping, so the frames stay valid
+ * after the source that returned them is destroyed; the file is unmapped
+ * when the last one is released.
+ */
+class MappedFrameAllocator : public cv::MatAllocator {
+public:
+    static MappedFrameAllocator& instance() {
+        static MappedFrameAllocator* allocator = new MappedFrameAllocator();  // Outlives every Mat
+        return *allocator;
+    }
+
+    /**
+     * @brief Make a Mat header over pixels of a mapping
+     */
+    cv::Mat wrap(const std::shared_ptr<MappedFile>& file, const uint8_t* pixels, int rows, int cols, int type,
+                 size_t step) const {
+        uint8_t* data = const_cast<uint8_t*>(pixels);
+        cv::Mat frame(rows, cols, type, data, step);
+        cv::UMatData* u = new cv::UMatData(this);
+        u->data = u->origdata = data;
+        u->size = step * rows;
+        u->userdata = new std::shared_ptr<MappedFile>(file);
+        u->refcount = 1;
+        frame.u = u;
+        return frame;
+    }
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(cv::UMatData* u, cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return u != nullptr;
+    }
+
+    void deallocate(cv::UMatData* u) const override {
+        if (u == nullptr) {
+            return;
+        }
+        delete static_cast<std::shared_ptr<MappedFile>*>(u->userdata);
+        delete u;
+    }
+};
+
+} // namespace frame_file
+
+/**
+ * @brief Appends frames to a raw frame file
+ *
+ * Frames of any size and type can follow each other (a chain's intermediate
+ * results, a recorded sequence...). Rows are stored without padding.
+ */
+class FrameFileWriter {
+private:
+    std::string path;
+    std::ofstream file;
+    uint64_t offset = 0;
+    uint64_t frameCount = 0;
+
+    void writeBytes(const void* bytes, size_t count) {
+        file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(count));
+        offset += count;
+    }
+
+    void pad() {
+        static const char zeros[frame_file::ALIGNMENT] = {};
+        writeBytes(zeros, static_cast<size_t>(frame_file::aligned(offset) - offset));
+    }
+
+public:
+    /**
+     * @brief Create a file
+     * @param filepath Path of the file to write (replaced)
+     */
+    explicit FrameFileWriter(const std::string& filepath)
+        : path(filepath), file(filepath, std::ios::binary | std::ios::trunc) {
+        if (!file) {
+            throw std::runtime_error("Cannot create " + path);
+        }
+        frame_file::FileHeader header = {};
+        std::memcpy(header.magic, "ITFRAMES", 8);
+        header.version = frame_file::VERSION;
+        header.headerBytes = sizeof(frame_file::FrameHeader);
+        writeBytes(&header, sizeof(header));
+    }
+
+    FrameFileWriter(const FrameFileWriter&) = delete;
+    FrameFileWriter& operator=(const FrameFileWriter&) = delete;
+
+    ~FrameFileWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    /**
+     * @brief Append a frame
+     * @param frame A non-empty 2D image of any type
+     * @param timestampUs Capture time in microseconds (0 if unknown)
+     */
+    void write(const cv::Mat& frame, int64_t timestampUs = 0) {
+        if (frame.empty() || frame.dims != 2) {
+            throw std::invalid_argument("Only non-empty 2D frames can be written");
+        }
+        if (!file.is_open()) {
+            throw std::runtime_error(path + " is closed");
+        }
+        const size_t rowBytes = frame.cols * frame.elemSize();
+
+        frame_file::FrameHeader header = {};
+        std::memcpy(header.magic, "FRAM", 4);
+        header.rows = frame.rows;
+        header.cols = frame.cols;
+        header.type = frame.type();
+        header.step = rowBytes;
+        header.timestampUs = timestampUs;
+        writeBytes(&header, sizeof(header));
+
+        if (frame.isContinuous()) {
+            writeBytes(frame.data, rowBytes * frame.rows);
+        } else {
+            for (int y = 0; y < frame.rows; ++y) {
+                writeBytes(frame.ptr(y), rowBytes);
+            }
+        }
+        pad();
+        if (!file) {
+            throw std::runtime_error("Cannot write " + path);
+        }
+        ++frameCount;
+    }
+
+    /**
+     * @brief Get the number of frames written
+     * @return Frame count
+     */
+    size_t getFrameCount() const {
+        return static_cast<size_t>(frameCount);
+    }
+
+    /**
+     * @brief Record the frame count and close the file (done by the destructor too)
+     */
+    void close() {
+        if (!file.is_open()) {
+            return;
+        }
+        file.seekp(offsetof(frame_file::FileHeader, frameCount));
+        file.write(reinterpret_cast<const char*>(&frameCount), sizeof(frameCount));
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Cannot write " + path);
+        }
+    }
+};
+
+/**
+ * @brief Image source reading a raw frame file through a memory mapping
+ *
+ * The returned frames are Mat headers over the mapping: nothing is decoded
+ * or copied, and a frame costs the page faults of the rows actually read.
+ * They stay valid after the source is destroyed, and writing to them never
+ * modifies the file. Every call for the same frame shares the same pixels,
+ * though: writing into a frame (an overlay, an in-place treatment) changes
+ * what later getFrame() calls, and getImage() after a loop, return for as
+ * long as the file stays mapped. clone() a frame before modifying it.
+ * setAllocator() does not apply to them.
+ */
+class FrameFileImageSource : public ImageSource {
+private:
+    struct FrameEntry {
+        frame_file::FrameHeader header;
+        uint64_t dataOffset;
+    };
+
+    std::string filepath;
+    std::shared_ptr<frame_file::MappedFile> mapping;
+    std::vector<FrameEntry> frames;
+    size_t next = 0;
+    bool loop;
+
+    void index() {
+        const uint8_t* base = mapping->data();
+        const uint64_t size = mapping->size();
+
+        frame_file::FileHeader header;
+        if (size < sizeof(header)) {
+            throw std::runtime_error(filepath + " is not a frame file");
+        }
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, "ITFRAMES", 8) != 0 || header.version != frame_file::VERSION ||
+            header.headerBytes != sizeof(frame_file::FrameHeader)) {
+            throw std::runtime_error(filepath + " is not a frame file (version " +
+                                     std::to_string(frame_file::VERSION) + ")");
+        }
+
+        // Walk the frame headers; a file whose writer was not closed is read up to its last whole frame
+        uint64_t offset = sizeof(header);
+        while (offset + sizeof(frame_file::FrameHeader) <= size &&
+               (header.frameCount == 0 || frames.size() < header.frameCount)) {
+            FrameEntry entry;
+            std::memcpy(&entry.header, base + offset, sizeof(entry.header));
+            entry.dataOffset = offset + sizeof(entry.header);
+            const frame_file::FrameHeader& h = entry.header;
+            const uint64_t rowBytes = static_cast<uint64_t>(std::max(h.cols, 0)) * CV_ELEM_SIZE(h.type);
+            if (std::memcmp(h.magic, "FRAM", 4) != 0 || h.rows < 1 || h.cols < 1 || h.step < rowBytes ||
+                h.step % CV_ELEM_SIZE1(h.type) != 0) {
+                throw std::runtime_error(filepath + " has an invalid frame header at byte " + std::to_string(offset));
+            }
+            // Bounds are divided instead of multiplied: a huge step would wrap around in 64 bits
+            const uint64_t available = size - entry.dataOffset;
+            const uint64_t rows = static_cast<uint64_t>(h.rows);
+            if (rowBytes > available || (rows > 1 && h.step > (available - rowBytes) / (rows - 1))) {
+                break;
+            }
+            frames.push_back(entry);
+            // The last row may lack its padding: then the frame ends the file
+            offset = h.step > available / rows ? size : frame_file::aligned(entry.dataOffset + h.step * rows);
+        }
+        if (header.frameCount != 0 && frames.size() != header.frameCount) {
+            throw std::runtime_error(filepath + " is truncated: " + std::to_string(frames.size()) + " of " +
+                                     std::to_string(header.frameCount) + " frames");
+        }
+    }
+
+public:
+    /**
+     * @brief Map a raw frame file
+     * @param path Path of the file
+     * @param loop Restart from the first frame after the last one (otherwise getImage() returns an empty Mat)
+     */
+    explicit FrameFileImageSource(const std::string& path, bool loop = false)
+        : filepath(path), mapping(std::make_shared<frame_file::MappedFile>(path)), loop(loop) {
+        index();
+    }
+
+    /**
+     * @brief Get the next frame of the file
+     * @return A frame pointing into the mapping, or an empty Mat after the last frame
+     */
+    cv::Mat getImage() override {
+        if (next == frames.size() && loop) {
+            next = 0;
+        }
+        if (next == frames.size()) {
+            return cv::Mat();
+        }
+        return getFrame(next++);
+    }
+
+    /**
+     * @brief Get a frame by index
+     * @param index Frame index
+     * @return A frame pointing into the mapping
+     */
+    cv::Mat getFrame(size_t index) const {
+        if (index >= frames.size()) {
+            throw std::out_of_range("Frame index out of range");
+        }
+        const FrameEntry& entry = frames[index];
+        return frame_file::MappedFrameAllocator::instance().wrap(mapping, mapping->data() + entry.dataOffset,
+                                                                 entry.header.rows, entry.header.cols,
+                                                                 entry.header.type, entry.header.step);
+    }
+
+    /**
+     * @brief Get the timestamp stored with a frame
+     * @param index Frame index
+     * @return Capture time in microseconds (0 if unknown)
+     */
+    int64_t getTimestamp(size_t index) const {
+        if (index >= frames.size()) {
+            throw std::out_of_range("Frame index out of range");
+        }
+        return frames[index].header.timestampUs;
+    }
+
+    /**
+     * @brief Get the number of frames in the file
+     * @return Frame count
+     */
+    size_t getFrameCount() const {
+        return frames.size();
+    }
+
+    /**
+     * @brief Choose the frame getImage() returns next
+     * @param index Frame index
+     */
+    void seek(size_t index) {
+        if (index > frames.size()) {
+            throw std::out_of_range("Frame index out of range");
+        }
+        next = index;
+    }
+
+    bool isAvailable() const override {
+        return !frames.empty();
+    }
+
+    std::string getDescription() const override {
+        return "Frame file: " + filepath + " (" + std::to_string(frames.size()) + " frames)";
+    }
+};
+
+#endif // FRAME_FILE_H
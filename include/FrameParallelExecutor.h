@@ -0,0 +1,357 @@
+#ifndef FRAME_PARALLEL_EXECUTOR_H
+#define FRAME_PARALLEL_EXECUTOR_H
+
+#include "BoundedQueue.h"
+#include "TreatmentChain.h"
+#include "VideoIO.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs a chain on several frames at once and returns the results in order
+ *
+ * Each of the N workers owns a clone of the chain (Treatment::clone()), so
+ * consecutive frames are processed concurrently without sharing treatment
+ * state. Results wait in a reorder buffer until every earlier frame is done
+ * and leave next() in submission order.
+ *
+ * Treatments that keep state from one frame to the next
+ * (Treatment::isStateful()) cannot see frames out of order: the chain is
+ * split before the first of them, and that stage and all later ones run on
+ * a single ordered lane that takes the frames in sequence from the reorder
+ * buffer. Only the stages before it run in parallel.
+ *
+ * At most maxInFlight frames are between submit() and next(): submit()
+ * waits when that many are queued, processing or waiting for an earlier
+ * frame, which bounds the reorder buffer and the memory held. submit() and
+ * next() must therefore be called from different threads (run() does so).
+ */
+class FrameParallelExecutor {
+private:
+    struct Job {
+        uint64_t sequence = 0;
+        TimedFrame frame;
+    };
+
+    /**
+     * @brief Sets OpenCV's thread count for a scope, restores the previous one on every exit
+     */
+    class OpenCvThreadLimit {
+    private:
+        int previous;
+
+    public:
+        explicit OpenCvThreadLimit(int threads) : previous(cv::getNumThreads()) {
+            cv::setNumThreads(threads);
+        }
+        ~OpenCvThreadLimit() {
+            cv::setNumThreads(previous);
+        }
+        OpenCvThreadLimit(const OpenCvThreadLimit&) = delete;
+        OpenCvThreadLimit& operator=(const OpenCvThreadLimit&) = delete;
+    };
+
+    std::vector<TreatmentChain> workerChains;  // Stages before the first stateful one, one copy per worker
+    TreatmentChain orderedChain;               // The first stateful stage and the ones after it
+    size_t workerCount;
+    size_t maxInFlight;
+
+    BoundedQueue<Job> input;
+    BoundedQueue<TimedFrame> output;
+    std::vector<std::thread> threads;
+    std::thread orderedLane;
+
+    std::mutex mutex;
+    std::condition_variable reorderReady;
+    std::condition_variable slotFree;
+    std::map<uint64_t, TimedFrame> reorder;  // Worker results waiting for earlier frames
+    size_t activeWorkers = 0;
+    size_t inFlight = 0;
+    uint64_t submitted = 0;
+    bool finished = false;
+
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};
+    std::atomic<int64_t> busyMicroseconds{0};
+
+    static size_t resolveWorkers(size_t requested) {
+        return requested != 0 ? requested : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /**
+     * @brief Stop every thread and make submit() and next() throw
+     */
+    void fail(std::exception_ptr cause) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!failed) {
+            error = cause;
+            failed = true;
+        }
+        input.close();
+        output.close();
+        reorderReady.notify_all();
+        slotFree.notify_all();
+    }
+
+    void work(size_t worker) {
+        try {
+            Job job;
+            while (input.pop(job)) {
+                auto start = std::chrono::steady_clock::now();
+                if (workerChains[worker].getTreatmentCount() > 0) {
+                    job.frame.image = workerChains[worker].processChain(job.frame.image);
+                }
+                busyMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+                                        std::chrono::steady_clock::now() - start).count();
+                std::lock_guard<std::mutex> lock(mutex);
+                reorder.emplace(job.sequence, std::move(job.frame));
+                reorderReady.notify_all();
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        --activeWorkers;
+        reorderReady.notify_all();
+    }
+
+    void runOrderedLane() {
+        try {
+            for (uint64_t sequence = 0;; ++sequence) {
+                TimedFrame frame;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    reorderReady.wait(lock, [&]() {
+                        return failed || reorder.count(sequence) > 0 || activeWorkers == 0;
+                    });
+                    auto it = reorder.find(sequence);
+                    if (failed || it == reorder.end()) {
+                        break;  // Workers done and every frame delivered (or an error)
+                    }
+                    frame = std::move(it->second);
+                    reorder.erase(it);
+                }
+                if (orderedChain.getTreatmentCount() > 0) {
+                    auto start = std::chrono::steady_clock::now();
+                    frame.image = orderedChain.processChain(frame.image);
+                    busyMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+                                            std::chrono::steady_clock::now() - start).count();
+                }
+                output.push(std::move(frame));
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        output.close();
+    }
+
+public:
+    /**
+     * @brief Start the workers
+     * @param chain The chain to run (cloned; later changes to it are not seen)
+     * @param workers Number of workers (0 = one per hardware thread)
+     * @param maxFramesInFlight Frames between submit() and next() at most (0 = twice the workers)
+     */
+    explicit FrameParallelExecutor(const TreatmentChain& chain, size_t workers = 0, size_t maxFramesInFlight = 0)
+        : workerCount(resolveWorkers(workers)),
+          maxInFlight(maxFramesInFlight != 0 ? maxFramesInFlight : 2 * workerCount),
+          input(maxInFlight), output(maxInFlight) {
+        size_t split = chain.getTreatmentCount();
+        for (size_t i = 0; i < chain.getTreatmentCount(); ++i) {
+            if (chain.getTreatment(i)->isStateful()) {
+                split = i;
+                break;
+            }
+        }
+        for (size_t w = 0; w < workerCount; ++w) {
+            TreatmentChain copy;
+            for (size_t i = 0; i < split; ++i) {
+                copy.addTreatment(chain.getTreatment(i)->clone());
+            }
+            copy.setRecordIntermediates(false);
+            copy.setMemoryBudget(chain.getMemoryBudget());
+            workerChains.push_back(std::move(copy));
+        }
+        for (size_t i = split; i < chain.getTreatmentCount(); ++i) {
+            orderedChain.addTreatment(chain.getTreatment(i)->clone());
+        }
+        orderedChain.setRecordIntermediates(false);
+        orderedChain.setMemoryBudget(chain.getMemoryBudget());
+
+        activeWorkers = workerCount;
+        for (size_t w = 0; w < workerCount; ++w) {
+            threads.emplace_back(&FrameParallelExecutor::work, this, w);
+        }
+        orderedLane = std::thread(&FrameParallelExecutor::runOrderedLane, this);
+    }
+
+    FrameParallelExecutor(const FrameParallelExecutor&) = delete;
+    FrameParallelExecutor& operator=(const FrameParallelExecutor&) = delete;
+
+    ~FrameParallelExecutor() {
+        finish();
+        output.close();  // Results nobody will read
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            slotFree.notify_all();
+        }
+        for (std::thread& worker : threads) {
+            worker.join();
+        }
+        orderedLane.join();
+    }
+
+    /**
+     * @brief Queue a frame, waiting while maxInFlight frames are pending
+     * @param frame The frame (its index and timestamp are passed through)
+     */
+    void submit(TimedFrame frame) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            slotFree.wait(lock, [this]() { return failed || inFlight < maxInFlight; });
+            if (failed) {
+                std::rethrow_exception(error);
+            }
+            if (finished) {
+                throw std::runtime_error("Frames submitted after finish()");
+            }
+            ++inFlight;
+            job.sequence = submitted++;
+        }
+        job.frame = std::move(frame);
+        if (!input.push(std::move(job)) && failed) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * @brief Declare that no more frames will be submitted
+     */
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished = true;
+        }
+        input.close();
+    }
+
+    /**
+     * @brief Get the next result in submission order, waiting for it
+     * @param frame Receives the processed frame
+     * @return false once finish() was called and every result was returned
+     */
+    bool next(TimedFrame& frame) {
+        if (!output.pop(frame)) {
+            if (failed) {
+                std::rethrow_exception(error);
+            }
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        --inFlight;
+        slotFree.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Get the number of workers
+     * @return Worker count
+     */
+    size_t getWorkerCount() const {
+        return workerChains.size();
+    }
+
+    /**
+     * @brief Get the number of stages run on the ordered lane
+     * @return 0 when no treatment is stateful
+     */
+    size_t getOrderedStageCount() const {
+        return orderedChain.getTreatmentCount();
+    }
+
+    /**
+     * @brief Get the time spent in treatments, all threads added up
+     * @return Milliseconds
+     */
+    double getBusyMs() const {
+        return busyMicroseconds / 1000.0;
+    }
+
+    /**
+     * @brief Process every frame of a video with frame parallelism
+     *
+     * A feeder thread decodes and submits, the calling thread writes the
+     * results in order. OpenCV's own threads are limited to one per call
+     * meanwhile, since the frames already occupy every core; the previous
+     * setting is restored on return, also when an exception is thrown.
+     *
+     * @param source The decoded video
+     * @param chain The chain applied to each frame
+     * @param sink The output video (closed on return)
+     * @param workerCount Number of workers (0 = one per hardware thread)
+     * @return Frame count and timings (processMs adds up all workers)
+     */
+    static VideoPipelineStats run(VideoFileImageSource& source, const TreatmentChain& chain, VideoFileSink& sink,
+                                  size_t workerCount = 0) {
+        using Clock = std::chrono::steady_clock;
+        OpenCvThreadLimit singleThreaded(1);
+
+        VideoPipelineStats stats;
+        auto start = Clock::now();
+        std::exception_ptr feedError;
+        {
+            FrameParallelExecutor executor(chain, workerCount);
+            std::thread feeder([&]() {
+                try {
+                    TimedFrame frame;
+                    for (;;) {
+                        auto t0 = Clock::now();
+                        if (!source.getTimedFrame(frame)) {
+                            break;
+                        }
+                        stats.decodeWaitMs += std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+                        executor.submit(std::move(frame));
+                    }
+                } catch (...) {
+                    feedError = std::current_exception();
+                }
+                executor.finish();
+            });
+
+            TimedFrame result;
+            try {
+                while (executor.next(result)) {
+                    auto t0 = Clock::now();
+                    sink.write(std::move(result));  // Refilled by next(): no copy
+                    stats.encodeWaitMs += std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+                    ++stats.frames;
+                }
+            } catch (...) {
+                executor.fail(std::current_exception());  // Let the feeder's submit() return
+                feeder.join();
+                throw;
+            }
+            feeder.join();
+            if (feedError) {
+                std::rethrow_exception(feedError);
+            }
+            sink.close();
+            stats.processMs = executor.getBusyMs();
+        }
+        stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return stats;
+    }
+};
+
+#endif // FRAME_PARALLEL_EXECUTOR_H
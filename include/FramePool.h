@@ -0,0 +1,312 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+/**
+ * @brief Counters of a FramePool
+ */
+struct FramePoolStats {
+    size_t requests = 0;           // Pooled allocations requested
+    size_t hits = 0;               // Requests served by a buffer already held
+    size_t systemAllocations = 0;  // Buffers obtained from the system
+    size_t bytesInUse = 0;         // Bytes of the buffers owned by live Mats
+    size_t bytesHeld = 0;          // Bytes of the free buffers kept for reuse
+    size_t highWaterMark = 0;      // Peak of bytesInUse + bytesHeld
+
+    /**
+     * @brief Fraction of requests served without a system allocation
+     * @return Hit rate in [0, 1] (0 before the first request)
+     */
+    double hitRate() const {
+        return requests == 0 ? 0.0 : static_cast<double>(hits) / requests;
+    }
+};
+
+/**
+ * @brief Frame buffer pool usable as a cv::MatAllocator
+ *
+ * Frame-sized buffers (at least minPooledBytes) are rounded up to a size
+ * class (four classes per power of two, so at most 25% slack) and kept on a
+ * free list when their last Mat is released; the next frame of the same
+ * geometry reuses them instead of going back to the heap, so a steady stream
+ * neither fragments the heap nor page-faults its buffers in again. Smaller
+ * and user-provided buffers are handed to OpenCV's standard allocator.
+ *
+ * On Linux, hugePages backs the buffers of 2 MB and more with huge pages
+ * (MAP_HUGETLB, or transparent huge pages when none are reserved), which
+ * cuts TLB misses on 4K frames. It is ignored on other systems.
+ *
+ * A pool is used by a Mat either explicitly (mat.allocator = &pool before
+ * create(), see ImageSource::setAllocator() and
+ * TreatmentChain::setAllocator()) or for every Mat of the process with
+ * install(). The pool must outlive every Mat it allocated; global() never
+ * dies. All methods are thread-safe.
+ */
+class FramePool : public cv::MatAllocator {
+private:
+    static constexpr size_t HUGE_PAGE = size_t(2) << 20;
+
+    size_t minPooledBytes;
+    size_t maxBytesHeld;
+    bool hugePages;
+
+    mutable std::mutex mutex;
+    mutable std::map<size_t, std::vector<void*>> freeBuffers;  // By size class
+    mutable FramePoolStats stats;
+    cv::MatAllocator* previousDefault = nullptr;
+
+    size_t classSize(size_t bytes) const {
+        size_t power = 1;
+        while (power * 2 <= bytes) {
+            power *= 2;
+        }
+        size_t step = std::max<size_t>(power / 4, 1);
+        size_t size = (bytes + step - 1) / step * step;
+        if (useHugePages(size)) {
+            size = (size + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+        }
+        return size;
+    }
+
+    bool useHugePages(size_t size) const {
+#ifdef __linux__
+        return hugePages && size >= HUGE_PAGE;
+#else
+        return false;
+#endif
+    }
+
+    void* systemAllocate(size_t size) const {
+#ifdef __linux__
+        if (useHugePages(size)) {
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p == MAP_FAILED) {
+                // No reserved huge pages: ask for transparent ones instead
+                p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (p == MAP_FAILED) {
+                    throw std::bad_alloc();
+                }
+                madvise(p, size, MADV_HUGEPAGE);
+            }
+            return p;
+        }
+#endif
+        return cv::fastMalloc(size);
+    }
+
+    void systemFree(void* p, size_t size) const {
+#ifdef __linux__
+        if (useHugePages(size)) {
+            munmap(p, size);
+            return;
+        }
+#endif
+        cv::fastFree(p);
+    }
+
+    void updateHighWater() const {
+        stats.highWaterMark = std::max(stats.highWaterMark, stats.bytesInUse + stats.bytesHeld);
+    }
+
+    /**
+     * @brief Take a buffer of a size class, from the free list if possible
+     */
+    void* acquire(size_t size) const {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++stats.requests;
+            auto it = freeBuffers.find(size);
+            if (it != freeBuffers.end() && !it->second.empty()) {
+                void* p = it->second.back();
+                it->second.pop_back();
+                ++stats.hits;
+                stats.bytesHeld -= size;
+                stats.bytesInUse += size;
+                return p;
+            }
+        }
+        void* p = systemAllocate(size);  // Outside the lock: may page-fault for a while
+        std::lock_guard<std::mutex> lock(mutex);
+        ++stats.systemAllocations;
+        stats.bytesInUse += size;
+        updateHighWater();
+        return p;
+    }
+
+public:
+    /**
+     * @brief Create a pool
+     * @param hugePages Back buffers of 2 MB and more with huge pages (Linux)
+     * @param maxBytesHeld Free buffers beyond this are returned to the system
+     * @param minPooledBytes Smaller buffers use the standard allocator
+     */
+    explicit FramePool(bool hugePages = false, size_t maxBytesHeld = size_t(1) << 30,
+                       size_t minPooledBytes = size_t(64) << 10)
+        : minPooledBytes(minPooledBytes), maxBytesHeld(maxBytesHeld), hugePages(hugePages) {}
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    ~FramePool() override {
+        uninstall();
+        trim();
+    }
+
+    /**
+     * @brief Process-wide pool, never destroyed
+     * @return The shared pool (no huge pages, 1 GB held at most)
+     */
+    static FramePool& global() {
+        static FramePool* pool = new FramePool();
+        return *pool;
+    }
+
+    /**
+     * @brief Make this pool the allocator of every Mat that does not choose one
+     */
+    void install() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (previousDefault == nullptr) {
+            previousDefault = cv::Mat::getDefaultAllocator();
+            cv::Mat::setDefaultAllocator(this);
+        }
+    }
+
+    /**
+     * @brief Restore the allocator that was the default before install()
+     */
+    void uninstall() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (previousDefault != nullptr) {
+            cv::Mat::setDefaultAllocator(previousDefault);
+            previousDefault = nullptr;
+        }
+    }
+
+    /**
+     * @brief Preallocate buffers so the first frames are served from the pool too
+     * @param size Frame size
+     * @param type Frame type (e.g. CV_8UC3)
+     * @param count Number of buffers of that geometry to hold
+     */
+    void reserve(const cv::Size& size, int type, size_t count) {
+        size_t bytes = static_cast<size_t>(size.width) * size.height * CV_ELEM_SIZE(type);
+        if (bytes < minPooledBytes) {
+            return;
+        }
+        size_t sizeClass = classSize(bytes);
+        std::vector<void*> buffers;
+        for (size_t i = 0; i < count; ++i) {
+            buffers.push_back(systemAllocate(sizeClass));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<void*>& list = freeBuffers[sizeClass];
+        list.insert(list.end(), buffers.begin(), buffers.end());
+        stats.systemAllocations += count;
+        stats.bytesHeld += count * sizeClass;
+        updateHighWater();
+    }
+
+    /**
+     * @brief Return every free buffer to the system
+     */
+    void trim() {
+        std::map<size_t, std::vector<void*>> released;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            released.swap(freeBuffers);
+            stats.bytesHeld = 0;
+        }
+        for (const auto& sizeClass : released) {
+            for (void* p : sizeClass.second) {
+                systemFree(p, sizeClass.first);
+            }
+        }
+    }
+
+    /**
+     * @brief Get a snapshot of the counters
+     * @return Requests, hits, bytes in use and held, high-water mark
+     */
+    FramePoolStats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+    /**
+     * @brief Reset the request and hit counters (bytes are kept)
+     */
+    void resetCounters() {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.requests = stats.hits = stats.systemAllocations = 0;
+        stats.highWaterMark = stats.bytesInUse + stats.bytesHeld;
+    }
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; --i) {
+            total *= sizes[i];
+        }
+        if (data != nullptr || total < minPooledBytes) {
+            return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+        }
+
+        // Continuous layout, as the standard allocator
+        size_t bytes = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; --i) {
+            if (step != nullptr) {
+                step[i] = bytes;
+            }
+            bytes *= sizes[i];
+        }
+
+        // Held until the buffer is acquired, so a throwing acquire() does not leak it
+        std::unique_ptr<cv::UMatData> u(new cv::UMatData(this));
+        u->data = u->origdata = static_cast<uchar*>(acquire(classSize(bytes)));
+        u->size = bytes;
+        return u.release();
+    }
+
+    bool allocate(cv::UMatData* u, cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return u != nullptr;
+    }
+
+    void deallocate(cv::UMatData* u) const override {
+        if (u == nullptr) {
+            return;
+        }
+        void* p = u->origdata;
+        size_t sizeClass = classSize(u->size);
+        delete u;
+
+        bool keep;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.bytesInUse -= sizeClass;
+            keep = stats.bytesHeld + sizeClass <= maxBytesHeld;
+            if (keep) {
+                freeBuffers[sizeClass].push_back(p);
+                stats.bytesHeld += sizeClass;
+            }
+        }
+        if (!keep) {
+            systemFree(p, sizeClass);
+        }
+    }
+};
+
+#endif // FRAME_POOL_H
@@ -0,0 +1,225 @@
+#ifndef FRAME_RECORDING_H
+#define FRAME_RECORDING_H
+
+#include "FrameFile.h"
+#include "ImageSource.h"
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Image source that records the frames of another source while passing them on
+ *
+ * Each frame is appended to a raw frame file (see FrameFileWriter) with the
+ * time elapsed since the first one, so ReplayImageSource can play the
+ * sequence back with its original pacing.
+ */
+class RecordingImageSource : public ImageSource {
+private:
+    ImageSource& source;
+    FrameFileWriter writer;
+    std::string filepath;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    /**
+     * @brief Record a source
+     * @param recorded The source to read frames from (must outlive the recorder)
+     * @param path Path of the recording (replaced)
+     */
+    RecordingImageSource(ImageSource& recorded, const std::string& path)
+        : source(recorded), writer(path), filepath(path) {}
+
+    cv::Mat getImage() override {
+        cv::Mat frame = source.getImage();
+        if (frame.empty()) {
+            return frame;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (writer.getFrameCount() == 0) {
+            start = now;
+        }
+        writer.write(frame, std::chrono::duration_cast<std::chrono::microseconds>(now - start).count());
+        return frame;
+    }
+
+    /**
+     * @brief Get the number of frames recorded so far
+     * @return Frame count
+     */
+    size_t getFrameCount() const {
+        return writer.getFrameCount();
+    }
+
+    /**
+     * @brief Finish the recording (done by the destructor too)
+     */
+    void close() {
+        writer.close();
+    }
+
+    bool isAvailable() const override {
+        return source.isAvailable();
+    }
+
+    std::string getDescription() const override {
+        return "Recording: " + source.getDescription() + " -> " + filepath;
+    }
+};
+
+/**
+ * @brief How ReplayImageSource delivers frames
+ */
+enum class ReplayPacing {
+    Unpaced,   // Every frame as soon as it is asked for (throughput)
+    RealTime   // Each frame at its recorded time (latency, as with the camera)
+};
+
+/**
+ * @brief Image source replaying a recording made by RecordingImageSource
+ *
+ * Frames come from a memory-mapped raw frame file, so replay costs no
+ * decode: measured times are those of the pipeline alone, and identical
+ * from one run to the next. In RealTime mode getImage() waits for the
+ * recorded time of the next frame; a consumer that falls behind may skip
+ * the frames it missed, as it would with a live camera
+ * (setDropLateFrames()).
+ */
+class ReplayImageSource : public ImageSource {
+private:
+    FrameFileImageSource frames;
+    std::string filepath;
+    ReplayPacing pacing;
+    bool loop;
+    double speed = 1.0;
+    bool dropLateFrames = false;
+
+    size_t next = 0;
+    size_t droppedFrames = 0;
+    bool started = false;
+    std::chrono::steady_clock::time_point start;  // When the frame startFrame was delivered
+    size_t startFrame = 0;
+
+    std::chrono::steady_clock::time_point dueTime(size_t index) const {
+        double offsetUs = static_cast<double>(frames.getTimestamp(index) - frames.getTimestamp(startFrame)) / speed;
+        return start + std::chrono::microseconds(static_cast<int64_t>(offsetUs));
+    }
+
+public:
+    /**
+     * @brief Open a recording
+     * @param path Path of the recording
+     * @param replayPacing Unpaced or RealTime
+     * @param loop Restart from the first frame after the last one (otherwise getImage() returns an empty Mat)
+     */
+    explicit ReplayImageSource(const std::string& path, ReplayPacing replayPacing = ReplayPacing::Unpaced,
+                               bool loop = false)
+        : frames(path), filepath(path), pacing(replayPacing), loop(loop) {}
+
+    /**
+     * @brief Get the next frame, at its recorded time in RealTime mode
+     * @return A frame pointing into the recording, or an empty Mat after the last frame
+     */
+    cv::Mat getImage() override {
+        if (next == frames.getFrameCount() && loop) {
+            next = 0;
+            started = false;
+        }
+        if (next == frames.getFrameCount()) {
+            return cv::Mat();
+        }
+        if (pacing == ReplayPacing::RealTime) {
+            auto now = std::chrono::steady_clock::now();
+            if (!started) {
+                start = now;
+                startFrame = next;
+                started = true;
+            }
+            // Skip to the last frame already due
+            while (dropLateFrames && next + 1 < frames.getFrameCount() && dueTime(next + 1) <= now) {
+                ++next;
+                ++droppedFrames;
+            }
+            std::this_thread::sleep_until(dueTime(next));
+        }
+        return frames.getFrame(next++);
+    }
+
+    /**
+     * @brief Choose how frames are delivered
+     * @param replayPacing Unpaced or RealTime
+     */
+    void setPacing(ReplayPacing replayPacing) {
+        pacing = replayPacing;
+        started = false;
+    }
+
+    /**
+     * @brief Replay faster or slower than recorded (RealTime mode)
+     * @param factor 2.0 plays twice as fast
+     */
+    void setSpeed(double factor) {
+        if (factor <= 0.0) {
+            throw std::invalid_argument("Replay speed must be positive");
+        }
+        speed = factor;
+        started = false;
+    }
+
+    /**
+     * @brief Skip the frames whose time has passed before they were asked for (RealTime mode)
+     * @param drop true to drop them as a live camera would, false to deliver every frame late
+     */
+    void setDropLateFrames(bool drop) {
+        dropLateFrames = drop;
+    }
+
+    /**
+     * @brief Get the number of frames skipped because the consumer was late
+     * @return Dropped frame count
+     */
+    size_t getDroppedFrames() const {
+        return droppedFrames;
+    }
+
+    /**
+     * @brief Get the number of frames in the recording
+     * @return Frame count
+     */
+    size_t getFrameCount() const {
+        return frames.getFrameCount();
+    }
+
+    /**
+     * @brief Get the recorded duration, from the first frame to the last
+     * @return Duration in seconds
+     */
+    double getDuration() const {
+        if (frames.getFrameCount() == 0) {
+            return 0.0;
+        }
+        return (frames.getTimestamp(frames.getFrameCount() - 1) - frames.getTimestamp(0)) / 1e6;
+    }
+
+    /**
+     * @brief Restart from the first frame
+     */
+    void rewind() {
+        next = 0;
+        droppedFrames = 0;
+        started = false;
+    }
+
+    bool isAvailable() const override {
+        return frames.isAvailable();
+    }
+
+    std::string getDescription() const override {
+        return "Replay: " + filepath + " (" + std::to_string(frames.getFrameCount()) + " frames, " +
+               (pacing == ReplayPacing::RealTime ? "real time" : "unpaced") + ")";
+    }
+};
+
+#endif // FRAME_RECORDING_H
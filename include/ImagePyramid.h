@@ -0,0 +1,203 @@
+#ifndef IMAGE_PYRAMID_H
+#define IMAGE_PYRAMID_H
+
+#include "kernels/AreaDownsample.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief Downscaled versions of an image, built on demand and shared by its consumers
+ *
+ * Level k is the image halved k times by 2x2 area averaging
+ * (kernels::halveArea()), so each level costs a quarter of the previous one
+ * and is built once, from the level above it, the first time a consumer
+ * asks for it or for a smaller one. getScaled() returns the smallest cached
+ * level at least as large as the request, plus a final area resize of at
+ * most a factor of 2, instead of a resize from full resolution per consumer.
+ *
+ * A pyramid can be attached to a frame (attach()): every consumer that
+ * later looks the frame up (find(), or attach() again) gets the same
+ * pyramid and its cached levels, for as long as one of them holds it. The
+ * pyramid keeps a reference to the frame, so the frame must not be modified
+ * meanwhile. Levels are built under a lock: consumers on several threads
+ * may share a pyramid.
+ */
+class ImagePyramid {
+private:
+    const cv::Mat base;           // The image itself (not copied), readable without the lock
+    std::vector<cv::Mat> levels;  // levels[0] is base; the others are built by getLevel()
+    mutable std::mutex mutex;
+
+    struct Registry {
+        std::mutex mutex;
+        std::map<const uchar*, std::weak_ptr<ImagePyramid>> pyramids;  // By first pixel address
+    };
+
+    static Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    bool isOf(const cv::Mat& image) const {
+        return base.data == image.data && base.size() == image.size() && base.type() == image.type() &&
+               base.step == image.step;
+    }
+
+    /**
+     * @brief Size of the image scaled by a factor (rounded up: never smaller than asked)
+     */
+    static cv::Size scaledSize(const cv::Size& size, double scale) {
+        return cv::Size(std::max(1, static_cast<int>(std::ceil(size.width * scale - 1e-9))),
+                        std::max(1, static_cast<int>(std::ceil(size.height * scale - 1e-9))));
+    }
+
+public:
+    /**
+     * @brief Create the pyramid of an image (only level 0 exists until asked for)
+     * @param image The full-resolution image (shared, not copied)
+     */
+    explicit ImagePyramid(const cv::Mat& image) : base(image) {
+        if (base.empty()) {
+            throw std::invalid_argument("Cannot build the pyramid of an empty image");
+        }
+        levels.push_back(base);
+    }
+
+    ImagePyramid(const ImagePyramid&) = delete;
+    ImagePyramid& operator=(const ImagePyramid&) = delete;
+
+    /**
+     * @brief Get the pyramid attached to a frame, attaching a new one if there is none
+     * @param image The frame
+     * @return The shared pyramid (attached while a holder of it exists)
+     */
+    static std::shared_ptr<ImagePyramid> attach(const cv::Mat& image) {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (auto it = shared.pyramids.begin(); it != shared.pyramids.end();) {
+            it = it->second.expired() ? shared.pyramids.erase(it) : std::next(it);
+        }
+        auto it = shared.pyramids.find(image.data);
+        if (it != shared.pyramids.end()) {
+            std::shared_ptr<ImagePyramid> pyramid = it->second.lock();
+            if (pyramid && pyramid->isOf(image)) {
+                return pyramid;
+            }
+        }
+        auto pyramid = std::make_shared<ImagePyramid>(image);
+        shared.pyramids[image.data] = pyramid;
+        return pyramid;
+    }
+
+    /**
+     * @brief Get the pyramid attached to a frame
+     * @param image The frame
+     * @return The pyramid, or nullptr if none is attached
+     */
+    static std::shared_ptr<ImagePyramid> find(const cv::Mat& image) {
+        if (image.empty()) {
+            return nullptr;
+        }
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        auto it = shared.pyramids.find(image.data);
+        if (it == shared.pyramids.end()) {
+            return nullptr;
+        }
+        std::shared_ptr<ImagePyramid> pyramid = it->second.lock();
+        return pyramid && pyramid->isOf(image) ? pyramid : nullptr;
+    }
+
+    /**
+     * @brief Get the full-resolution image
+     * @return Level 0
+     */
+    const cv::Mat& getImage() const {
+        return base;
+    }
+
+    /**
+     * @brief Get a level, building it and the ones above it if needed
+     * @param level 0 for the image, k for the image halved k times (ceil(size / 2^k))
+     * @return The level (shared: do not modify it)
+     */
+    cv::Mat getLevel(int level) {
+        if (level < 0) {
+            throw std::out_of_range("Pyramid level cannot be negative");
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        while (static_cast<int>(levels.size()) <= level) {
+            const cv::Mat& last = levels.back();
+            if (last.cols == 1 && last.rows == 1) {
+                break;  // Smallest level reached
+            }
+            cv::Mat halved;
+            kernels::halveArea(last, halved);
+            levels.push_back(halved);
+        }
+        return levels[std::min<size_t>(level, levels.size() - 1)];
+    }
+
+    /**
+     * @brief Get the number of levels built so far
+     * @return 1 until a smaller scale is asked for
+     */
+    int getLevelCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return static_cast<int>(levels.size());
+    }
+
+    /**
+     * @brief Get the image scaled by a factor
+     * @param scale Fraction of the full width and height (0 < scale <= 1)
+     * @return The image at ceil(size * scale): a cached level when the scale is a power of two,
+     *         otherwise the next larger level area-resized (a new image)
+     */
+    cv::Mat getScaled(double scale) {
+        if (!(scale > 0.0 && scale <= 1.0)) {
+            throw std::invalid_argument("Pyramid scale must be in (0, 1]");
+        }
+        const cv::Size target = scaledSize(base.size(), scale);
+
+        // Smallest level still at least as large as the target
+        int level = 0;
+        for (cv::Size size = base.size();;) {
+            cv::Size halved = kernels::halvedSize(size);
+            if (halved == size || halved.width < target.width || halved.height < target.height) {
+                break;
+            }
+            size = halved;
+            ++level;
+        }
+
+        cv::Mat source = getLevel(level);
+        if (source.size() == target) {
+            return source;
+        }
+        cv::Mat resized;
+        cv::resize(source, resized, target, 0, 0, cv::INTER_AREA);
+        return resized;
+    }
+
+    /**
+     * @brief Get the image scaled down to fit in a size, aspect ratio kept
+     * @param maxSize Largest width and height (e.g. the screen)
+     * @return The image itself if it already fits, otherwise its scaled version
+     */
+    cv::Mat fitTo(const cv::Size& maxSize) {
+        if (base.cols <= maxSize.width && base.rows <= maxSize.height) {
+            return base;
+        }
+        double scale = std::min(static_cast<double>(maxSize.width) / base.cols,
+                                static_cast<double>(maxSize.height) / base.rows);
+        return getScaled(std::max(scale, 1e-9));
+    }
+};
+
+#endif // IMAGE_PYRAMID_H
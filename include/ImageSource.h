@@ -6,6 +6,10 @@
 #include <memory>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
 
 /**
  * @brief Abstract base class for image sources
@@ -31,31 +35,211 @@ public:
      * @return Description string
      */
     virtual std::string getDescription() const = 0;
+
+    /**
+     * @brief Allocate the returned frames with a given allocator (e.g. a FramePool)
+     * @param frameAllocator The allocator, or nullptr for OpenCV's default
+     */
+    void setAllocator(cv::MatAllocator* frameAllocator) {
+        allocator = frameAllocator;
+    }
+
+    /**
+     * @brief Tell the source that its frames are only needed at a fraction of the full resolution
+     *
+     * A hint: sources that can produce smaller frames cheaply (decoder-level
+     * downscaling) return frames of about scale times the full width and
+     * height, never smaller; the others keep returning full-size frames.
+     * @param scale Fraction of the full width and height (0 < scale <= 1)
+     */
+    void setScaleHint(double scale) {
+        if (!(scale > 0.0 && scale <= 1.0)) {
+            throw std::invalid_argument("Scale hint must be in (0, 1]");
+        }
+        scaleHint = scale;
+        hintChanged();
+    }
+
+    /**
+     * @brief Tell the source the size its frames will be shown or processed at
+     * @param maxSize Frames only need to fit in this size, aspect ratio kept (empty = no limit)
+     */
+    void setTargetSizeHint(const cv::Size& maxSize) {
+        targetSizeHint = maxSize;
+        hintChanged();
+    }
+
+protected:
+    cv::MatAllocator* allocator = nullptr;  // Allocator of the returned frames
+    double scaleHint = 1.0;                 // See setScaleHint()
+    cv::Size targetSizeHint;                // See setTargetSizeHint()
+
+    /**
+     * @brief Called after a hint changed
+     */
+    virtual void hintChanged() {}
+
+    /**
+     * @brief Get the scale the hints ask for
+     * @param fullSize Full size of the frames
+     * @return Fraction of the full width and height (1 = full resolution)
+     */
+    double hintedScale(const cv::Size& fullSize) const {
+        double scale = scaleHint;
+        if (!targetSizeHint.empty() && !fullSize.empty()) {
+            scale = std::min({scale, static_cast<double>(targetSizeHint.width) / fullSize.width,
+                              static_cast<double>(targetSizeHint.height) / fullSize.height});
+        }
+        return std::min(scale, 1.0);
+    }
 };
 
 /**
  * @brief Image source from a file
+ *
+ * The file is decoded on first use, at the resolution the hints ask for
+ * (setScaleHint(), setTargetSizeHint()). JPEG files are scaled down by the
+ * decoder itself (DCT scaling by 1/2, 1/4 or 1/8), which skips most of the
+ * decoding work; the remaining factor, and every other format, is resampled
+ * with area averaging. A 24 MP photo loaded for a 1280x720 preview is thus
+ * decoded at 1/4 and only the last step is resampled.
  */
 class FileImageSource : public ImageSource {
 private:
     std::string filepath;
-    cv::Mat image;
+    mutable cv::Mat image;
+    mutable cv::Size fullSize;  // Size at full resolution (known after the first decode)
+    mutable bool decoded = false;
+
+    /**
+     * @brief Read the size of a JPEG file from its frame header, without decoding
+     * @return Width and height, or an empty size if the file is not a JPEG
+     */
+    static cv::Size readJpegSize(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (file.get() != 0xFF || file.get() != 0xD8) {
+            return cv::Size();
+        }
+        for (;;) {
+            int byte = file.get();
+            while (byte == 0xFF) {
+                byte = file.get();  // Marker, possibly after fill bytes
+            }
+            if (!file || byte == 0xD9 || byte == 0xDA) {
+                return cv::Size();  // End of image or start of scan before any frame header
+            }
+            if (byte == 0x01 || (byte >= 0xD0 && byte <= 0xD7)) {
+                continue;  // Markers without a segment
+            }
+            unsigned char segment[7];
+            if (!file.read(reinterpret_cast<char*>(segment), 2)) {
+                return cv::Size();
+            }
+            int length = (segment[0] << 8) | segment[1];
+            // SOF0-SOF15, except DHT (C4), JPG (C8) and DAC (CC)
+            if (byte >= 0xC0 && byte <= 0xCF && byte != 0xC4 && byte != 0xC8 && byte != 0xCC) {
+                if (!file.read(reinterpret_cast<char*>(segment + 2), 5)) {
+                    return cv::Size();
+                }
+                return cv::Size((segment[5] << 8) | segment[6], (segment[3] << 8) | segment[4]);
+            }
+            file.seekg(length - 2, std::ios::cur);
+        }
+    }
+
+    /**
+     * @brief Size of a frame decoded at a given scale (rounded up: never smaller than asked)
+     */
+    static cv::Size scaledSize(const cv::Size& size, double scale) {
+        return cv::Size(std::max(1, static_cast<int>(std::ceil(size.width * scale - 1e-9))),
+                        std::max(1, static_cast<int>(std::ceil(size.height * scale - 1e-9))));
+    }
+
+    void decode() const {
+        decoded = true;
+        cv::Size jpegSize = readJpegSize(filepath);
+        double scale = jpegSize.empty() ? 1.0 : hintedScale(jpegSize);
+
+        // Largest decoder reduction that keeps the image at least as large as asked
+        int flags = cv::IMREAD_COLOR;
+        if (scale <= 1.0 / 8) {
+            flags = cv::IMREAD_REDUCED_COLOR_8;
+        } else if (scale <= 1.0 / 4) {
+            flags = cv::IMREAD_REDUCED_COLOR_4;
+        } else if (scale <= 1.0 / 2) {
+            flags = cv::IMREAD_REDUCED_COLOR_2;
+        }
+
+        cv::Mat loaded = cv::imread(filepath, flags);
+        if (loaded.empty()) {
+            image.release();
+            fullSize = cv::Size();
+            return;
+        }
+        if (jpegSize.empty()) {
+            fullSize = loaded.size();
+        } else {
+            fullSize = jpegSize;
+            if ((loaded.cols > loaded.rows) != (fullSize.width > fullSize.height)) {
+                std::swap(fullSize.width, fullSize.height);  // Rotated by its EXIF orientation
+            }
+        }
+
+        cv::Size target = scaledSize(fullSize, hintedScale(fullSize));
+        if (loaded.size() != target && loaded.cols >= target.width && loaded.rows >= target.height) {
+            cv::resize(loaded, image, target, 0, 0, cv::INTER_AREA);  // Rest of the factor, or not a JPEG
+        } else {
+            image = loaded;
+        }
+    }
+
+    void ensureDecoded() const {
+        if (!decoded) {
+            decode();
+        }
+    }
+
+    void hintChanged() override {
+        // Decode again on next use if the hints now ask for another size
+        if (decoded && !fullSize.empty() && scaledSize(fullSize, hintedScale(fullSize)) != image.size()) {
+            decoded = false;
+        }
+    }
 
 public:
     explicit FileImageSource(const std::string& path) : filepath(path) {
-        image = cv::imread(filepath);
     }
 
     cv::Mat getImage() override {
-        return image.clone();
+        ensureDecoded();
+        cv::Mat copy;
+        copy.allocator = allocator;
+        image.copyTo(copy);
+        return copy;
+    }
+
+    /**
+     * @brief Get the size of the image at full resolution, whatever the hints
+     * @return Width and height (empty if the file cannot be loaded)
+     */
+    cv::Size getFullSize() const {
+        ensureDecoded();
+        return fullSize;
     }
 
     bool isAvailable() const override {
+        ensureDecoded();
         return !image.empty();
     }
 
     std::string getDescription() const override {
-        return "File: " + filepath;
+        ensureDecoded();
+        std::string description = "File: " + filepath;
+        if (!image.empty() && image.size() != fullSize) {
+            description += " (decoded at " + std::to_string(image.cols) + "x" + std::to_string(image.rows) +
+                           " of " + std::to_string(fullSize.width) + "x" + std::to_string(fullSize.height) + ")";
+        }
+        return description;
     }
 };
 
@@ -80,6 +264,7 @@ public:
 
     cv::Mat getImage() override {
         cv::Mat frame;
+        frame.allocator = allocator;
         if (capture.isOpened()) {
             // Try to read a frame
             capture >> frame;
@@ -112,6 +297,7 @@ public:
      */
     cv::Mat getImageWithRetry(int skipFrames = 5, int retries = 15, bool validateNonBlack = true) {
         cv::Mat frame;
+        frame.allocator = allocator;
         if (!capture.isOpened()) {
             return frame;
         }
@@ -0,0 +1,220 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Image bytes held now and at the worst moment
+ */
+struct MemoryUsage {
+    size_t current = 0;  // Bytes held now
+    size_t peak = 0;     // Largest number of bytes held
+};
+
+/**
+ * @brief Thrown when a request cannot run within its memory budget
+ */
+class MemoryBudgetExceeded : public std::runtime_error {
+public:
+    MemoryBudgetExceeded(size_t required, size_t available)
+        : std::runtime_error("Memory budget exceeded: " + megabytes(required) + " needed, " +
+                             megabytes(available) + " available"),
+          required(required), available(available) {}
+
+    size_t required;   // Smallest working set the request could run with
+    size_t available;  // Budget left when it was rejected
+
+private:
+    static std::string megabytes(size_t bytes) {
+        size_t tenths = (bytes * 10 + (1 << 20) - 1) >> 20;  // Rounded up
+        return std::to_string(tenths / 10) + "." + std::to_string(tenths % 10) + " MB";
+    }
+};
+
+/**
+ * @brief Process-wide account of the image bytes held by chains
+ *
+ * Chains reserve their working set before processing a frame and keep a
+ * reservation for the intermediate results they record, so concurrent
+ * workers share one budget. Reservations are estimates made from the frame
+ * formats (see TreatmentChain::setMemoryBudget()); the bytes actually
+ * allocated are reported by FramePool::getStats() when it is installed.
+ */
+class MemoryAccount {
+private:
+    static std::atomic<size_t>& live() {
+        static std::atomic<size_t> bytes{0};
+        return bytes;
+    }
+    static std::atomic<size_t>& peak() {
+        static std::atomic<size_t> bytes{0};
+        return bytes;
+    }
+    static std::atomic<size_t>& budget() {
+        static std::atomic<size_t> bytes{0};
+        return bytes;
+    }
+
+    static void updatePeak(size_t value) {
+        size_t seen = peak().load();
+        while (value > seen && !peak().compare_exchange_weak(seen, value)) {
+        }
+    }
+
+public:
+    /**
+     * @brief Limit the bytes all chains of the process may reserve together
+     * @param bytes The budget, or 0 for no limit
+     */
+    static void setProcessBudget(size_t bytes) {
+        budget() = bytes;
+    }
+
+    /**
+     * @brief Get the process-wide budget
+     * @return Budget in bytes (0 = no limit)
+     */
+    static size_t getProcessBudget() {
+        return budget();
+    }
+
+    /**
+     * @brief Bytes that can still be reserved
+     * @return Budget minus live bytes (SIZE_MAX without a budget)
+     */
+    static size_t available() {
+        size_t limit = budget();
+        if (limit == 0) {
+            return std::numeric_limits<size_t>::max();
+        }
+        size_t used = live();
+        return used >= limit ? 0 : limit - used;
+    }
+
+    /**
+     * @brief Reserve bytes if the process budget allows it
+     * @param bytes Bytes to reserve
+     * @return true if reserved, false if it would exceed the budget
+     */
+    static bool tryAcquire(size_t bytes) {
+        size_t used = live().load();
+        do {
+            size_t limit = budget();
+            if (limit != 0 && used + bytes > limit) {
+                return false;
+            }
+        } while (!live().compare_exchange_weak(used, used + bytes));
+        updatePeak(used + bytes);
+        return true;
+    }
+
+    /**
+     * @brief Reserve bytes regardless of the budget
+     * @param bytes Bytes to reserve
+     */
+    static void acquire(size_t bytes) {
+        updatePeak(live().fetch_add(bytes) + bytes);
+    }
+
+    /**
+     * @brief Give back reserved bytes
+     * @param bytes Bytes previously reserved
+     */
+    static void release(size_t bytes) {
+        live().fetch_sub(bytes);
+    }
+
+    /**
+     * @brief Get the process-wide usage
+     * @return Live reserved bytes and their peak since startup (or resetPeak())
+     */
+    static MemoryUsage getUsage() {
+        MemoryUsage usage;
+        usage.current = live();
+        usage.peak = peak();
+        return usage;
+    }
+
+    /**
+     * @brief Restart peak tracking from the current live bytes
+     */
+    static void resetPeak() {
+        peak() = live().load();
+    }
+};
+
+/**
+ * @brief Bytes reserved in the MemoryAccount, given back on destruction
+ */
+class MemoryReservation {
+private:
+    size_t bytes = 0;
+
+public:
+    MemoryReservation() = default;
+
+    MemoryReservation(MemoryReservation&& other) noexcept : bytes(other.bytes) {
+        other.bytes = 0;
+    }
+
+    MemoryReservation& operator=(MemoryReservation&& other) noexcept {
+        if (this != &other) {
+            release();
+            bytes = other.bytes;
+            other.bytes = 0;
+        }
+        return *this;
+    }
+
+    ~MemoryReservation() {
+        release();
+    }
+
+    /**
+     * @brief Reserve bytes if the process budget allows it (releases the previous reservation first)
+     * @param size Bytes to reserve
+     * @return true if reserved
+     */
+    bool tryReserve(size_t size) {
+        release();
+        if (!MemoryAccount::tryAcquire(size)) {
+            return false;
+        }
+        bytes = size;
+        return true;
+    }
+
+    /**
+     * @brief Reserve bytes regardless of the budget (releases the previous reservation first)
+     * @param size Bytes to reserve
+     */
+    void reserve(size_t size) {
+        release();
+        MemoryAccount::acquire(size);
+        bytes = size;
+    }
+
+    /**
+     * @brief Give the bytes back
+     */
+    void release() {
+        if (bytes != 0) {
+            MemoryAccount::release(bytes);
+            bytes = 0;
+        }
+    }
+
+    /**
+     * @brief Get the reserved bytes
+     * @return Bytes held by this reservation
+     */
+    size_t size() const {
+        return bytes;
+    }
+};
+
+#endif // MEMORY_BUDGET_H
@@ -0,0 +1,59 @@
+#ifndef MERGE_TREATMENT_H
+#define MERGE_TREATMENT_H
+
+#include "Treatment.h"
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief Base class for treatments that combine several images into one
+ *
+ * Merge treatments are nodes of a ProcessingGraph with more than one input
+ * (e.g. an image and a mask). They cannot be used in a TreatmentChain:
+ * validateInput() rejects a single image unless the treatment takes one input.
+ */
+class MergeTreatment : public Treatment {
+public:
+    /**
+     * @brief Combine the input images
+     * @param inputs The input images, in the order the graph edges were given
+     * @return The merged image
+     */
+    virtual cv::Mat merge(const std::vector<cv::Mat>& inputs) = 0;
+
+    /**
+     * @brief Get the number of images merge() expects
+     * @return Input count
+     */
+    virtual size_t getInputCount() const = 0;
+
+    /**
+     * @brief Check if the treatment can merge the given inputs
+     * @param inputs The input images
+     * @return true if there are getInputCount() non-empty images of the same size
+     */
+    virtual bool validateInputs(const std::vector<cv::Mat>& inputs) const {
+        if (inputs.size() != getInputCount()) {
+            return false;
+        }
+        for (const cv::Mat& input : inputs) {
+            if (input.empty() || input.size() != inputs[0].size()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    cv::Mat process(const cv::Mat& input) override {
+        if (getInputCount() != 1) {
+            throw std::logic_error(getName() + " needs " + std::to_string(getInputCount()) + " inputs");
+        }
+        return merge({input});
+    }
+
+    bool validateInput(const cv::Mat& input) const override {
+        return validateInputs({input});
+    }
+};
+
+#endif // MERGE_TREATMENT_H
@@ -0,0 +1,297 @@
+#ifndef PARAMETER_SWEEP_H
+#define PARAMETER_SWEEP_H
+
+#include "TreatmentChain.h"
+#include "treatments/CannyEdgeTreatment.h"
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One parameter value applied to one stage of a sweep
+ */
+struct SweepSetting {
+    size_t stage;           // Index of the treatment in the chain
+    std::string parameter;  // Name accepted by Treatment::setParameter()
+    std::string value;
+};
+
+/**
+ * @brief Output of one point of the parameter grid
+ */
+struct SweepResult {
+    std::vector<SweepSetting> settings;  // Value of every axis for this output
+    cv::Mat output;
+};
+
+/**
+ * @brief Runs an image through every combination of a parameter grid
+ *
+ * Each axis lists values for one parameter of one stage of a chain. The
+ * combinations form a tree of shared prefixes: level i holds one node per
+ * distinct configuration of stages 0..i, and each node runs its stage once
+ * on its parent's output. Levels are computed one after the other, and the
+ * nodes of a level run in parallel, each on its own clone of the stage.
+ *
+ * Stage executions = sum over stages of the number of distinct prefixes,
+ * so sweeping the last stage of a chain costs one run of the other stages.
+ * A Canny stage whose axes only vary threshold1/threshold2 computes its
+ * gradient once per parent and only reruns hysteresis per threshold pair
+ * (CannyEdgeTreatment::processThresholds()); with a single parent the
+ * gradient stays cached between run() calls on the same image.
+ * Values of an axis that the treatment normalizes to the same setting
+ * (kernelSize 4 and 5) are kept once.
+ */
+class ParameterSweep {
+private:
+    struct Axis {
+        size_t stage;
+        std::string parameter;
+        std::vector<std::string> values;
+    };
+
+    /**
+     * @brief Node of the prefix tree: output of stages 0..level for one configuration
+     */
+    struct Node {
+        std::vector<SweepSetting> settings;
+        cv::Mat output;
+    };
+
+    std::vector<std::unique_ptr<Treatment>> stages;
+    std::vector<Axis> axes;
+    size_t stageRuns = 0;
+    std::vector<std::unique_ptr<CannyEdgeTreatment>> gradientCaches;  // Per stage, for threshold sweeps
+
+    /**
+     * @brief Canny stage whose axes only vary the thresholds, or nullptr
+     */
+    const CannyEdgeTreatment* thresholdOnlyCanny(size_t stage) const {
+        const auto* canny = dynamic_cast<const CannyEdgeTreatment*>(stages[stage].get());
+        for (const Axis& axis : axes) {
+            if (axis.stage == stage && axis.parameter != "threshold1" && axis.parameter != "threshold2") {
+                return nullptr;
+            }
+        }
+        return canny;
+    }
+
+    /**
+     * @brief Identity of the setting a value gives, after the treatment's own normalization
+     */
+    static std::string settingKey(const Treatment& stage, const std::string& parameter, const std::string& value) {
+        std::unique_ptr<Treatment> probe = stage.clone();
+        probe->setParameter(parameter, value);
+        std::string key = probe->getParameters()[parameter];
+        if (key.find_first_not_of("-0123456789") != std::string::npos) {
+            // Not an integer: the text form keeps 6 decimals, so tell apart values it rounds together
+            std::ostringstream exact;
+            try {
+                exact << std::hexfloat << std::stod(value);
+            } catch (const std::logic_error&) {
+                exact << value;
+            }
+            key += "|" + exact.str();
+        }
+        return key;
+    }
+
+    /**
+     * @brief Run a threshold-only Canny stage: one gradient per parent, hysteresis per configuration
+     */
+    void runThresholds(size_t stage, const std::vector<Node>& level,
+                       const std::vector<std::vector<SweepSetting>>& configs, std::vector<Node>& next,
+                       std::vector<std::string>& errors) {
+        std::vector<std::pair<double, double>> thresholds;
+        for (const auto& config : configs) {
+            std::unique_ptr<Treatment> configured = stages[stage]->clone();
+            for (const SweepSetting& setting : config) {
+                configured->setParameter(setting.parameter, setting.value);
+            }
+            const auto& canny = static_cast<const CannyEdgeTreatment&>(*configured);
+            thresholds.emplace_back(canny.getThreshold1(), canny.getThreshold2());
+        }
+
+        if (gradientCaches.size() != stages.size()) {
+            gradientCaches.resize(stages.size());
+        }
+        cv::parallel_for_(cv::Range(0, static_cast<int>(level.size())), [&](const cv::Range& range) {
+            for (int p = range.start; p < range.end; ++p) {
+                std::unique_ptr<CannyEdgeTreatment> perParent;
+                CannyEdgeTreatment* canny;
+                if (level.size() == 1) {
+                    if (!gradientCaches[stage]) {
+                        gradientCaches[stage].reset(static_cast<CannyEdgeTreatment*>(stages[stage]->clone().release()));
+                        gradientCaches[stage]->setParameter("cacheGradient", "1");
+                    }
+                    canny = gradientCaches[stage].get();
+                } else {
+                    perParent.reset(static_cast<CannyEdgeTreatment*>(stages[stage]->clone().release()));
+                    canny = perParent.get();
+                }
+                try {
+                    std::vector<cv::Mat> edges = canny->processThresholds(level[p].output, thresholds);
+                    for (size_t c = 0; c < configs.size(); ++c) {
+                        next[p * configs.size() + c].output = edges[c];
+                    }
+                } catch (const std::exception& e) {
+                    errors[p * configs.size()] = e.what();
+                }
+            }
+        }, static_cast<double>(level.size()));
+    }
+
+    /**
+     * @brief All value combinations of the axes of one stage
+     */
+    std::vector<std::vector<SweepSetting>> stageConfigurations(size_t stage) const {
+        std::vector<std::vector<SweepSetting>> configs(1);
+        for (const Axis& axis : axes) {
+            if (axis.stage != stage) {
+                continue;
+            }
+            std::vector<std::vector<SweepSetting>> expanded;
+            for (const auto& config : configs) {
+                for (const std::string& value : axis.values) {
+                    expanded.push_back(config);
+                    expanded.back().push_back({axis.stage, axis.parameter, value});
+                }
+            }
+            configs.swap(expanded);
+        }
+        return configs;
+    }
+
+public:
+    /**
+     * @brief Create a sweep over a copy of a chain's treatments
+     * @param chain The chain to sweep (later changes to it are not seen)
+     */
+    explicit ParameterSweep(const TreatmentChain& chain) {
+        for (size_t i = 0; i < chain.getTreatmentCount(); ++i) {
+            stages.push_back(chain.getTreatment(i)->clone());
+        }
+    }
+
+    /**
+     * @brief Add a parameter axis
+     * @param stage Index of the treatment in the chain
+     * @param parameter Parameter name, as for Treatment::setParameter()
+     * @param values Values to try (values giving the same setting are kept once)
+     * @throws std::out_of_range if the stage does not exist
+     * @throws std::invalid_argument if a value is rejected by the treatment
+     */
+    void addAxis(size_t stage, const std::string& parameter, const std::vector<std::string>& values) {
+        if (stage >= stages.size()) {
+            throw std::out_of_range("Index out of range");
+        }
+        if (values.empty()) {
+            throw std::invalid_argument("Sweep axis " + parameter + " has no values");
+        }
+        std::unique_ptr<Treatment> probe = stages[stage]->clone();
+        std::vector<std::string> distinct;
+        std::set<std::string> seen;
+        for (const std::string& value : values) {
+            if (!probe->setParameter(parameter, value)) {
+                throw std::invalid_argument("Treatment " + std::to_string(stage) + " rejects " +
+                                            parameter + " = " + value);
+            }
+            if (seen.insert(settingKey(*stages[stage], parameter, value)).second) {
+                distinct.push_back(value);
+            }
+        }
+        axes.push_back({stage, parameter, distinct});
+    }
+
+    /**
+     * @brief Number of grid points, i.e. of outputs run() returns
+     * @return Product of the axis sizes
+     */
+    size_t getCombinationCount() const {
+        size_t count = 1;
+        for (const Axis& axis : axes) {
+            count *= axis.values.size();
+        }
+        return count;
+    }
+
+    /**
+     * @brief Number of treatment executions during the last run()
+     * @return Stage runs (one per node of the prefix tree, one per parent for a threshold-only Canny stage)
+     */
+    size_t getStageRunCount() const {
+        return stageRuns;
+    }
+
+    /**
+     * @brief Run the image through every combination
+     * @param input The input image
+     * @return One result per combination; axes of earlier stages vary slowest,
+     *         then axes in the order they were added
+     */
+    std::vector<SweepResult> run(const cv::Mat& input) {
+        if (input.empty()) {
+            throw std::invalid_argument("Input image is empty");
+        }
+
+        std::vector<Node> level(1);
+        level[0].output = input;
+        stageRuns = 0;
+
+        for (size_t stage = 0; stage < stages.size(); ++stage) {
+            std::vector<std::vector<SweepSetting>> configs = stageConfigurations(stage);
+            std::vector<Node> next(level.size() * configs.size());
+            for (size_t p = 0; p < level.size(); ++p) {
+                for (size_t c = 0; c < configs.size(); ++c) {
+                    Node& node = next[p * configs.size() + c];
+                    node.settings = level[p].settings;
+                    node.settings.insert(node.settings.end(), configs[c].begin(), configs[c].end());
+                }
+            }
+
+            std::vector<std::string> errors(next.size());
+            if (configs.size() > 1 && thresholdOnlyCanny(stage) != nullptr) {
+                runThresholds(stage, level, configs, next, errors);
+                stageRuns += level.size();
+            } else {
+                cv::parallel_for_(cv::Range(0, static_cast<int>(next.size())), [&](const cv::Range& range) {
+                    for (int n = range.start; n < range.end; ++n) {
+                        const cv::Mat& parentOutput = level[n / configs.size()].output;
+                        std::unique_ptr<Treatment> treatment = stages[stage]->clone();
+                        for (const SweepSetting& setting : configs[n % configs.size()]) {
+                            treatment->setParameter(setting.parameter, setting.value);
+                        }
+                        try {
+                            if (!treatment->validateInput(parentOutput)) {
+                                throw std::runtime_error("cannot process the current image");
+                            }
+                            next[n].output = treatment->process(parentOutput);
+                        } catch (const std::exception& e) {
+                            errors[n] = e.what();
+                        }
+                    }
+                }, static_cast<double>(next.size()));
+                stageRuns += next.size();
+            }
+
+            for (const std::string& error : errors) {
+                if (!error.empty()) {
+                    throw std::runtime_error("Treatment " + std::to_string(stage) + " " + error);
+                }
+            }
+            level.swap(next);
+        }
+
+        std::vector<SweepResult> results;
+        results.reserve(level.size());
+        for (Node& node : level) {
+            results.push_back({std::move(node.settings), node.output});
+        }
+        return results;
+    }
+};
+
+#endif // PARAMETER_SWEEP_H
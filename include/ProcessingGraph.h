@@ -0,0 +1,319 @@
+#ifndef PROCESSING_GRAPH_H
+#define PROCESSING_GRAPH_H
+
+#include "MergeTreatment.h"
+#include "TreatmentChain.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Runs an image through a directed acyclic graph of treatments
+ *
+ * Node 0 (INPUT) holds the image given to run(). Every other node applies a
+ * treatment to the results of earlier nodes: one input for a Treatment, several
+ * for a MergeTreatment (mask, blend, channel merge...). A TreatmentChain is the
+ * special case of a path, see addChain().
+ *
+ * Before each run, nodes with the same treatment name, the same parameters and
+ * the same (deduplicated) inputs are collapsed, so a shared prefix such as
+ * Grayscale -> Gaussian Blur feeding both a Threshold and a Canny node is
+ * computed once even if it was added twice. Treatments are therefore expected
+ * to be deterministic functions of their parameters.
+ *
+ * Nodes are grouped by depth (longest path from INPUT); the nodes of a level
+ * are independent and run in parallel. A level with a single node runs on the
+ * calling thread so the treatment keeps its own internal parallelism.
+ */
+class ProcessingGraph {
+public:
+    using NodeId = size_t;
+    static constexpr NodeId INPUT = 0;  // Node holding the image given to run()
+
+private:
+    struct Node {
+        std::unique_ptr<Treatment> treatment;  // Null for INPUT
+        MergeTreatment* merge = nullptr;       // Same object when it takes several inputs
+        std::vector<NodeId> inputs;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<cv::Mat> results;
+    size_t nodeRuns = 0;
+
+    void checkNode(NodeId id) const {
+        if (id >= nodes.size()) {
+            throw std::out_of_range("Node " + std::to_string(id) + " does not exist");
+        }
+    }
+
+    /**
+     * @brief Map every node to the first node computing the same thing
+     * @return canonical[i] <= i; nodes are deduplicated in id order, which is topological
+     */
+    std::vector<NodeId> canonicalNodes() const {
+        std::vector<NodeId> canonical(nodes.size());
+        std::map<std::string, NodeId> seen;
+        canonical[INPUT] = INPUT;
+        for (NodeId i = 1; i < nodes.size(); ++i) {
+            // Exact values: printed parameters round doubles to 6 decimals
+            std::ostringstream key;
+            key << std::hexfloat << nodes[i].treatment->getName() << '\x1f';
+            for (const auto& param : nodes[i].treatment->getParameters()) {
+                key << param.first << '=' << param.second << '\x1f';
+            }
+            for (const auto& value : nodes[i].treatment->getParameterValues()) {
+                key << value.first << '=' << value.second << '\x1f';
+            }
+            for (NodeId input : nodes[i].inputs) {
+                key << canonical[input] << ',';
+            }
+            canonical[i] = seen.emplace(key.str(), i).first->second;
+        }
+        return canonical;
+    }
+
+    /**
+     * @brief Run one node on the results of its (canonical) inputs
+     */
+    cv::Mat runNode(NodeId id, const std::vector<NodeId>& canonical) {
+        Node& node = nodes[id];
+        if (node.merge != nullptr) {
+            std::vector<cv::Mat> inputs;
+            inputs.reserve(node.inputs.size());
+            for (NodeId input : node.inputs) {
+                inputs.push_back(results[canonical[input]]);
+            }
+            if (!node.merge->validateInputs(inputs)) {
+                throw std::runtime_error("cannot merge its inputs");
+            }
+            return node.merge->merge(inputs);
+        }
+        const cv::Mat& input = results[canonical[node.inputs[0]]];
+        if (!node.treatment->validateInput(input)) {
+            throw std::runtime_error("cannot process the current image");
+        }
+        return node.treatment->process(input);
+    }
+
+public:
+    ProcessingGraph() {
+        nodes.emplace_back();
+    }
+
+    /**
+     * @brief Add a single-input node
+     * @param treatment The treatment to apply
+     * @param input Node whose result is processed
+     * @return Id of the new node
+     */
+    NodeId addNode(std::unique_ptr<Treatment> treatment, NodeId input) {
+        if (!treatment) {
+            throw std::invalid_argument("Treatment is null");
+        }
+        checkNode(input);
+        auto* merge = dynamic_cast<MergeTreatment*>(treatment.get());
+        if (merge != nullptr && merge->getInputCount() != 1) {
+            throw std::invalid_argument(treatment->getName() + " needs " +
+                                        std::to_string(merge->getInputCount()) + " inputs");
+        }
+        Node node;
+        node.treatment = std::move(treatment);
+        node.inputs.push_back(input);
+        nodes.push_back(std::move(node));
+        return nodes.size() - 1;
+    }
+
+    /**
+     * @brief Add a node combining several results
+     * @param treatment The merge treatment to apply
+     * @param inputs Nodes whose results are merged, in the order merge() expects them
+     * @return Id of the new node
+     */
+    NodeId addMergeNode(std::unique_ptr<MergeTreatment> treatment, const std::vector<NodeId>& inputs) {
+        if (!treatment) {
+            throw std::invalid_argument("Treatment is null");
+        }
+        if (inputs.size() != treatment->getInputCount()) {
+            throw std::invalid_argument(treatment->getName() + " needs " +
+                                        std::to_string(treatment->getInputCount()) + " inputs");
+        }
+        for (NodeId input : inputs) {
+            checkNode(input);
+        }
+        Node node;
+        node.merge = treatment.get();
+        node.treatment = std::move(treatment);
+        node.inputs = inputs;
+        nodes.push_back(std::move(node));
+        return nodes.size() - 1;
+    }
+
+    /**
+     * @brief Append a copy of a chain as a path of nodes
+     * @param chain The chain whose treatments are cloned
+     * @param input Node feeding the first treatment
+     * @return Id of the node holding the chain's output (input if the chain is empty)
+     */
+    NodeId addChain(const TreatmentChain& chain, NodeId input = INPUT) {
+        NodeId last = input;
+        for (size_t i = 0; i < chain.getTreatmentCount(); ++i) {
+            last = addNode(chain.getTreatment(i)->clone(), last);
+        }
+        return last;
+    }
+
+    /**
+     * @brief Get the number of nodes, INPUT included
+     * @return Node count
+     */
+    size_t getNodeCount() const {
+        return nodes.size();
+    }
+
+    /**
+     * @brief Get the treatment of a node (e.g. to change its parameters)
+     * @param id Node id (not INPUT)
+     * @return Pointer to the treatment
+     */
+    Treatment* getTreatment(NodeId id) {
+        checkNode(id);
+        if (id == INPUT) {
+            throw std::invalid_argument("The input node has no treatment");
+        }
+        return nodes[id].treatment.get();
+    }
+
+    /**
+     * @brief Get the inputs of a node
+     * @param id Node id
+     * @return Input node ids (empty for INPUT)
+     */
+    const std::vector<NodeId>& getInputs(NodeId id) const {
+        checkNode(id);
+        return nodes[id].inputs;
+    }
+
+    /**
+     * @brief Number of treatment executions during the last run()
+     * @return Nodes actually computed, after deduplication
+     */
+    size_t getNodeRunCount() const {
+        return nodeRuns;
+    }
+
+    /**
+     * @brief Process an image and compute the requested nodes
+     * @param input The input image
+     * @param outputs Nodes to compute; only their ancestors are run
+     * @return The result of each requested node, in the same order
+     */
+    std::vector<cv::Mat> run(const cv::Mat& input, const std::vector<NodeId>& outputs) {
+        if (input.empty()) {
+            throw std::invalid_argument("Input image is empty");
+        }
+        for (NodeId id : outputs) {
+            checkNode(id);
+        }
+
+        std::vector<NodeId> canonical = canonicalNodes();
+        std::vector<bool> needed(nodes.size(), false);
+        for (NodeId id : outputs) {
+            needed[canonical[id]] = true;
+        }
+        std::vector<size_t> depth(nodes.size(), 0);
+        for (NodeId i = nodes.size(); i-- > 1;) {
+            if (needed[i] && canonical[i] == i) {
+                for (NodeId in : nodes[i].inputs) {
+                    needed[canonical[in]] = true;
+                }
+            }
+        }
+
+        std::vector<std::vector<NodeId>> levels;
+        for (NodeId i = 1; i < nodes.size(); ++i) {
+            if (!needed[i] || canonical[i] != i) {
+                continue;
+            }
+            for (NodeId in : nodes[i].inputs) {
+                depth[i] = std::max(depth[i], depth[canonical[in]] + 1);
+            }
+            if (levels.size() < depth[i]) {
+                levels.resize(depth[i]);
+            }
+            levels[depth[i] - 1].push_back(i);
+        }
+
+        results.assign(nodes.size(), cv::Mat());
+        results[INPUT] = input;
+        nodeRuns = 0;
+
+        for (const std::vector<NodeId>& level : levels) {
+            std::vector<std::string> errors(level.size());
+            auto runRange = [&](const cv::Range& range) {
+                for (int n = range.start; n < range.end; ++n) {
+                    try {
+                        results[level[n]] = runNode(level[n], canonical);
+                    } catch (const std::exception& e) {
+                        errors[n] = e.what();
+                    }
+                }
+            };
+            if (level.size() == 1) {
+                runRange(cv::Range(0, 1));
+            } else {
+                cv::parallel_for_(cv::Range(0, static_cast<int>(level.size())), runRange,
+                                  static_cast<double>(level.size()));
+            }
+
+            for (size_t n = 0; n < level.size(); ++n) {
+                if (!errors[n].empty()) {
+                    throw std::runtime_error("Node " + std::to_string(level[n]) + " " + errors[n]);
+                }
+            }
+            nodeRuns += level.size();
+        }
+
+        for (NodeId i = 1; i < nodes.size(); ++i) {
+            if (canonical[i] != i) {
+                results[i] = results[canonical[i]];
+            }
+        }
+
+        std::vector<cv::Mat> outputImages;
+        outputImages.reserve(outputs.size());
+        for (NodeId id : outputs) {
+            outputImages.push_back(results[id]);
+        }
+        return outputImages;
+    }
+
+    /**
+     * @brief Process an image and compute one node
+     * @param input The input image
+     * @param output Node to compute
+     * @return The result of that node
+     */
+    cv::Mat run(const cv::Mat& input, NodeId output) {
+        return run(input, std::vector<NodeId>{output}).front();
+    }
+
+    /**
+     * @brief Get the result of a node computed by the last run()
+     * @param id Node id
+     * @return The image (empty if the node was not needed by that run)
+     */
+    cv::Mat getResult(NodeId id) const {
+        checkNode(id);
+        if (id >= results.size()) {
+            return cv::Mat();
+        }
+        return results[id];
+    }
+};
+
+#endif // PROCESSING_GRAPH_H
@@ -0,0 +1,993 @@
+#ifndef SHARED_FRAME_TRANSPORT_H
+#define SHARED_FRAME_TRANSPORT_H
+
+// POSIX shared memory only: IT_SHM_TRANSPORT is 0 elsewhere and nothing is declared
+#if defined(__unix__) || defined(__APPLE__)
+#define IT_SHM_TRANSPORT 1
+#else
+#define IT_SHM_TRANSPORT 0
+#endif
+
+#if IT_SHM_TRANSPORT
+
+#include "ChainSpec.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+/**
+ * Frames exchanged with a processing daemon (FrameDaemon) through POSIX
+ * shared memory, without copying pixels from one process to the other.
+ *
+ * The daemon publishes a control segment under a well-known name. Each
+ * client creates its own session segment, posts its name in a free entry of
+ * the control segment and waits for the daemon to accept the chain spec
+ * (ChainSpec) written in it:
+ *
+ *   session header   spec, state, ring counters, statistics written by the daemon
+ *   request slots    slotCount x (64-byte slot header + pixels), client -> daemon
+ *   result slots     slotCount x (64-byte slot header + pixels), daemon -> client
+ *
+ * slotCount is a power of two, so a free-running 32-bit counter maps to the
+ * same slot before and after it wraps around.
+ *
+ * Both rings are single producer, single consumer: the producer writes a
+ * slot, then advances head; the consumer reads it in place, then advances
+ * tail. A client writes (or captures) a frame directly into a request slot,
+ * the daemon runs its chain on the slot as it is, its last stage writes the
+ * result into a result slot, and the client reads the result where it is.
+ * The daemon copies each slot header before validating it and never reads
+ * the client's values again.
+ * Clients must be trusted: segments are created with mode 0600, so only
+ * processes of the daemon's user can connect, and one of them can still
+ * crash the daemon (see FrameDaemon).
+ * Counters are 32-bit atomics that waiting processes sleep on with a shared
+ * futex on Linux (a short sleep-and-poll loop on other systems).
+ */
+namespace shm_transport {
+
+constexpr uint32_t VERSION = 1;
+constexpr size_t ALIGNMENT = 64;
+constexpr size_t SPEC_BYTES = 4096;
+constexpr size_t ERROR_BYTES = 512;
+constexpr size_t NAME_BYTES = 64;
+constexpr int MAX_CLIENTS = 32;
+constexpr const char* DEFAULT_DAEMON_NAME = "/imgtreat-daemon";
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free &&
+              std::atomic<int64_t>::is_always_lock_free,
+              "Counters shared between processes must be lock-free");
+
+enum SessionState : uint32_t {
+    Requested = 0,  // Spec written by the client, not yet read by the daemon
+    Ready = 1,      // Chain built: frames can be submitted
+    Rejected = 2,   // Invalid spec (see SessionHeader::error)
+    Closed = 3      // Client gone
+};
+
+enum ControlSlotState : uint32_t {
+    Free = 0,
+    Claimed = 1,  // Taken by a client, being filled
+    Posted = 2    // Session name ready for the daemon
+};
+
+struct SlotHeader {
+    int32_t rows;
+    int32_t cols;
+    int32_t type;
+    int32_t failed;       // Result slots: 1 if the chain failed (message in place of the pixels)
+    uint64_t step;
+    uint64_t sequence;    // Numbered by the client, copied to the result
+    int64_t timestampUs;  // Capture time given by the client, copied to the result
+    int64_t submitNs;     // steady_clock time of submission (the same clock in every process)
+    int64_t processNs;    // Result slots: time spent in the chain
+    uint8_t reserved[8];
+};
+
+static_assert(sizeof(SlotHeader) == ALIGNMENT, "Slot headers are 64 bytes");
+
+struct SessionHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slotCount;
+    uint64_t slotBytes;   // Pixel bytes of each slot
+    uint64_t totalBytes;  // Size of the whole segment
+    uint32_t clientPid;
+
+    alignas(64) std::atomic<uint32_t> state;
+    alignas(64) std::atomic<uint32_t> requestHead;  // Frames submitted
+    alignas(64) std::atomic<uint32_t> requestTail;  // Frames processed (request slot free again)
+    alignas(64) std::atomic<uint32_t> resultHead;   // Results written
+    alignas(64) std::atomic<uint32_t> resultTail;   // Results released by the client
+
+    // Statistics, written by the daemon only
+    alignas(64) std::atomic<uint64_t> framesProcessed;
+    std::atomic<uint64_t> framesFailed;
+    std::atomic<uint64_t> processNsTotal;
+    std::atomic<uint64_t> latencyNsTotal;  // Submission to result, per frame
+    std::atomic<uint64_t> latencyNsMax;
+    std::atomic<int64_t> firstResultNs;
+    std::atomic<int64_t> lastResultNs;
+
+    char spec[SPEC_BYTES];
+    char error[ERROR_BYTES];  // Why the spec was rejected
+};
+
+struct ControlSlot {
+    std::atomic<uint32_t> state;
+    uint32_t clientPid;
+    char session[NAME_BYTES];
+};
+
+struct ControlHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t daemonPid;
+    alignas(64) std::atomic<uint32_t> posted;  // Bumped by each client that posts a session
+    ControlSlot slots[MAX_CLIENTS];
+};
+
+/**
+ * @brief Per-client statistics of the daemon
+ */
+struct ClientStats {
+    std::string session;     // Name of the session segment
+    uint32_t pid = 0;        // Client process
+    std::string spec;        // Chain the client selected
+    uint64_t frames = 0;     // Results written
+    uint64_t failed = 0;     // Frames the chain failed on
+    double seconds = 0.0;    // From the first result to the last
+    double meanLatencyMs = 0.0;  // Submission to result
+    double maxLatencyMs = 0.0;
+    double meanProcessMs = 0.0;  // Time in the chain
+    bool connected = false;
+
+    /**
+     * @brief Results per second
+     * @return Throughput of the client (0 before the second result)
+     */
+    double framesPerSecond() const {
+        return seconds > 0.0 ? (frames - 1) / seconds : 0.0;
+    }
+};
+
+inline uint64_t aligned(uint64_t offset) {
+    return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+namespace detail {
+
+inline int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Sleep while a shared counter still holds a value
+ * @param timeoutMs Longest sleep (spurious and early wake-ups are possible)
+ */
+inline void waitWhile(std::atomic<uint32_t>& word, uint32_t value, int timeoutMs) {
+    if (word.load(std::memory_order_acquire) != value) {
+        return;
+    }
+#ifdef __linux__
+    struct timespec timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = static_cast<long>(timeoutMs % 1000) * 1000000L;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, value, &timeout, nullptr, 0);
+#else
+    std::this_thread::sleep_for(std::chrono::microseconds(std::min(timeoutMs * 1000, 200)));
+#endif
+}
+
+/**
+ * @brief Wake the processes sleeping on a shared counter
+ */
+inline void wake(std::atomic<uint32_t>& word) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+inline bool processAlive(uint32_t pid) {
+    return pid != 0 && (kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+}
+
+inline void copyText(char* destination, size_t size, const std::string& text) {
+    size_t length = std::min(text.size(), size - 1);
+    std::memcpy(destination, text.data(), length);
+    destination[length] = '\0';
+}
+
+inline std::string readText(const char* source, size_t size) {
+    return std::string(source, strnlen(source, size));
+}
+
+/**
+ * @brief One ring of slots in a session segment
+ */
+struct Ring {
+    uint8_t* first = nullptr;
+    uint32_t count = 0;  // Power of two
+    uint32_t mask = 0;   // count - 1
+    uint64_t stride = 0;
+
+    SlotHeader& slot(uint32_t index) const {
+        return *reinterpret_cast<SlotHeader*>(first + (index & mask) * stride);
+    }
+
+    static uint8_t* pixels(SlotHeader& slot) {
+        return reinterpret_cast<uint8_t*>(&slot) + sizeof(SlotHeader);
+    }
+};
+
+inline bool isPowerOfTwo(uint32_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+inline uint64_t slotStride(uint64_t slotBytes) {
+    return sizeof(SlotHeader) + aligned(slotBytes);
+}
+
+inline uint64_t sessionBytes(uint32_t slotCount, uint64_t slotBytes) {
+    return aligned(sizeof(SessionHeader)) + 2ull * slotCount * slotStride(slotBytes);
+}
+
+/**
+ * @brief Request ring of a session
+ * @param slotCount Validated slot count (not re-read from the shared header)
+ * @param slotBytes Validated pixel bytes of each slot
+ */
+inline Ring requestRing(SessionHeader* header, uint32_t slotCount, uint64_t slotBytes) {
+    uint8_t* base = reinterpret_cast<uint8_t*>(header) + aligned(sizeof(SessionHeader));
+    return Ring{base, slotCount, slotCount - 1, slotStride(slotBytes)};
+}
+
+inline Ring resultRing(SessionHeader* header, uint32_t slotCount, uint64_t slotBytes) {
+    Ring ring = requestRing(header, slotCount, slotBytes);
+    ring.first += ring.count * ring.stride;
+    return ring;
+}
+
+inline ClientStats readStats(const SessionHeader* header) {
+    ClientStats stats;
+    stats.pid = header->clientPid;
+    stats.spec = readText(header->spec, SPEC_BYTES);
+    stats.frames = header->framesProcessed.load(std::memory_order_relaxed);
+    stats.failed = header->framesFailed.load(std::memory_order_relaxed);
+    if (stats.frames > 0) {
+        stats.seconds = (header->lastResultNs.load() - header->firstResultNs.load()) / 1e9;
+        stats.meanLatencyMs = header->latencyNsTotal.load() / 1e6 / stats.frames;
+        stats.maxLatencyMs = header->latencyNsMax.load() / 1e6;
+        stats.meanProcessMs = header->processNsTotal.load() / 1e6 / stats.frames;
+    }
+    return stats;
+}
+
+} // namespace detail
+
+/**
+ * @brief A named POSIX shared memory segment, mapped read-write
+ */
+class SharedMemory {
+private:
+    std::string name;
+    uint8_t* base = nullptr;
+    size_t length = 0;
+    bool owner = false;  // Created here: the name is removed on destruction
+
+    SharedMemory(const std::string& segmentName, int fd, size_t bytes, bool created)
+        : name(segmentName), length(bytes), owner(created) {
+        void* view = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);  // The mapping keeps the segment
+        if (view == MAP_FAILED) {
+            if (owner) {
+                shm_unlink(name.c_str());
+            }
+            throw std::runtime_error("Cannot map shared memory " + name);
+        }
+        base = static_cast<uint8_t*>(view);
+    }
+
+public:
+    /**
+     * @brief Create a segment (zero-filled)
+     * @param segmentName Name starting with '/', unique on the machine
+     * @param bytes Size
+     */
+    static std::unique_ptr<SharedMemory> create(const std::string& segmentName, size_t bytes) {
+        int fd = shm_open(segmentName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot create shared memory " + segmentName + ": " + std::strerror(errno));
+        }
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            ::close(fd);
+            shm_unlink(segmentName.c_str());
+            throw std::runtime_error("Cannot size shared memory " + segmentName);
+        }
+        return std::unique_ptr<SharedMemory>(new SharedMemory(segmentName, fd, bytes, true));
+    }
+
+    /**
+     * @brief Map an existing segment
+     * @param segmentName Name given to create()
+     * @return The mapping, or nullptr if there is no such segment
+     */
+    static std::unique_ptr<SharedMemory> open(const std::string& segmentName) {
+        int fd = shm_open(segmentName.c_str(), O_RDWR, 0600);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            return nullptr;
+        }
+        return std::unique_ptr<SharedMemory>(
+            new SharedMemory(segmentName, fd, static_cast<size_t>(info.st_size), false));
+    }
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    ~SharedMemory() {
+        munmap(base, length);
+        if (owner) {
+            shm_unlink(name.c_str());
+        }
+    }
+
+    /**
+     * @brief Remove the name now (the mappings stay valid), e.g. for the segment of a dead process
+     */
+    void unlink() {
+        shm_unlink(name.c_str());
+        owner = false;
+    }
+
+    uint8_t* data() const {
+        return base;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    const std::string& getName() const {
+        return name;
+    }
+};
+
+/**
+ * @brief A result received from the daemon
+ */
+struct SharedFrame {
+    cv::Mat image;            // View of the result slot: valid until release()
+    uint64_t sequence = 0;    // Number of the submitted frame
+    int64_t timestampUs = 0;  // Timestamp given to submit()
+    double latencyMs = 0.0;   // From submit() to receive()
+    double processMs = 0.0;   // Time in the chain, in the daemon
+    bool failed = false;      // The chain threw: see error
+    std::string error;
+};
+
+/**
+ * @brief Client of a FrameDaemon: submits frames, receives the results of its chain
+ *
+ * To avoid any copy, write the frame into the slot returned by acquire()
+ * (capture into it, or make it the output of a conversion of the same size
+ * and type), then submit() it. submit(frame) copies the frame into the slot
+ * first. Up to slotCount frames may be in flight. Results are read in place
+ * (SharedFrame::image) and must be released in the order received.
+ * A client is used from one thread.
+ */
+class SharedFrameClient {
+private:
+    std::unique_ptr<SharedMemory> memory;
+    SessionHeader* header = nullptr;
+    uint32_t daemonPid = 0;
+    detail::Ring requests;
+    detail::Ring results;
+    bool acquired = false;  // A request slot is being filled
+    uint32_t held = 0;      // Results received and not yet released
+    uint64_t nextSequence = 0;
+
+    static std::string uniqueSessionName() {
+        static std::atomic<uint32_t> counter{0};
+        return "/imgtreat-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+    }
+
+    void checkDaemon() const {
+        bool dropped = header != nullptr && header->state.load(std::memory_order_acquire) == Closed;
+        if (dropped || !detail::processAlive(daemonPid)) {
+            throw std::runtime_error("The processing daemon stopped");
+        }
+    }
+
+    /**
+     * @brief Wait until a counter differs from a value
+     * @param timeoutMs Longest wait, -1 for none
+     * @return false on timeout
+     */
+    bool waitChange(std::atomic<uint32_t>& word, uint32_t value, int timeoutMs) const {
+        auto start = std::chrono::steady_clock::now();
+        while (word.load(std::memory_order_acquire) == value) {
+            int waitedMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            if (timeoutMs >= 0 && waitedMs >= timeoutMs) {
+                return false;
+            }
+            checkDaemon();
+            detail::waitWhile(word, value, timeoutMs >= 0 ? std::min(timeoutMs - waitedMs, 100) : 100);
+        }
+        return true;
+    }
+
+    void post(ControlHeader* control, const std::string& session) {
+        for (ControlSlot& slot : control->slots) {
+            uint32_t expected = Free;
+            if (slot.state.compare_exchange_strong(expected, Claimed, std::memory_order_acq_rel)) {
+                slot.clientPid = static_cast<uint32_t>(getpid());
+                detail::copyText(slot.session, NAME_BYTES, session);
+                slot.state.store(Posted, std::memory_order_release);
+                control->posted.fetch_add(1, std::memory_order_release);
+                detail::wake(control->posted);
+                return;
+            }
+        }
+        throw std::runtime_error("The processing daemon has no free client slot");
+    }
+
+public:
+    /**
+     * @brief Connect to a daemon and select a chain
+     * @param spec Chain to run on the frames (ChainSpec format)
+     * @param maxFrameBytes Largest frame or result (rows * cols * elemSize), e.g. 1920 * 1080 * 3
+     * @param slotCount Frames in flight at most (and results waiting at most), a power of two
+     * @param daemonName Control segment of the daemon
+     * @param timeoutMs How long to wait for the daemon to accept the chain
+     * @throws std::invalid_argument if the daemon rejects the spec
+     * @throws std::runtime_error if no daemon answers
+     */
+    SharedFrameClient(const std::string& spec, size_t maxFrameBytes, uint32_t slotCount = 4,
+                      const std::string& daemonName = DEFAULT_DAEMON_NAME, int timeoutMs = 5000) {
+        if (spec.size() >= SPEC_BYTES) {
+            throw std::invalid_argument("Chain spec is too long for the transport");
+        }
+        if (maxFrameBytes == 0 || !detail::isPowerOfTwo(slotCount)) {
+            throw std::invalid_argument("Frame size must be positive and slot count a power of two");
+        }
+        std::unique_ptr<SharedMemory> control = SharedMemory::open(daemonName);
+        if (!control || control->size() < sizeof(ControlHeader)) {
+            throw std::runtime_error("No processing daemon is running (" + daemonName + ")");
+        }
+        auto* controlHeader = reinterpret_cast<ControlHeader*>(control->data());
+        if (std::memcmp(controlHeader->magic, "ITDAEMON", 8) != 0 || controlHeader->version != VERSION) {
+            throw std::runtime_error("Incompatible processing daemon (" + daemonName + ")");
+        }
+        daemonPid = controlHeader->daemonPid;
+        checkDaemon();
+
+        uint64_t slotBytes = aligned(maxFrameBytes);
+        memory = SharedMemory::create(uniqueSessionName(), detail::sessionBytes(slotCount, slotBytes));
+        header = new (memory->data()) SessionHeader();
+        std::memcpy(header->magic, "ITSHMSES", 8);
+        header->version = VERSION;
+        header->slotCount = slotCount;
+        header->slotBytes = slotBytes;
+        header->totalBytes = memory->size();
+        header->clientPid = static_cast<uint32_t>(getpid());
+        detail::copyText(header->spec, SPEC_BYTES, spec);
+        header->state.store(Requested, std::memory_order_release);
+        requests = detail::requestRing(header, slotCount, slotBytes);
+        results = detail::resultRing(header, slotCount, slotBytes);
+
+        post(controlHeader, memory->getName());
+        uint32_t requested = Requested;
+        if (!waitChange(header->state, Requested, timeoutMs) &&
+            header->state.compare_exchange_strong(requested, Closed, std::memory_order_acq_rel)) {
+            throw std::runtime_error("The processing daemon did not answer");
+        }
+        if (header->state.load(std::memory_order_acquire) == Rejected) {
+            throw std::invalid_argument(detail::readText(header->error, ERROR_BYTES));
+        }
+    }
+
+    SharedFrameClient(const SharedFrameClient&) = delete;
+    SharedFrameClient& operator=(const SharedFrameClient&) = delete;
+
+    /**
+     * @brief Disconnect: the daemon drops the session, frames in flight are lost
+     */
+    ~SharedFrameClient() {
+        if (header != nullptr) {
+            header->state.store(Closed, std::memory_order_release);
+            detail::wake(header->state);
+            detail::wake(header->requestHead);
+            detail::wake(header->resultTail);
+        }
+    }
+
+    /**
+     * @brief Get the next free request slot, to write a frame into
+     * @param size Frame size
+     * @param type Frame type (cv::Mat type)
+     * @param timeoutMs Longest wait for a free slot, -1 for none
+     * @return A view of the slot (continuous rows), empty on timeout
+     */
+    cv::Mat acquire(const cv::Size& size, int type, int timeoutMs = -1) {
+        if (acquired) {
+            throw std::runtime_error("Submit the acquired frame before acquiring another");
+        }
+        uint64_t step = static_cast<uint64_t>(size.width) * CV_ELEM_SIZE(type);
+        if (size.width <= 0 || size.height <= 0 || step * size.height > header->slotBytes) {
+            throw std::invalid_argument("Frame does not fit in a transport slot");
+        }
+        uint32_t head = header->requestHead.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t tail; head - (tail = header->requestTail.load(std::memory_order_acquire)) >= requests.count;) {
+            int waitedMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            if (timeoutMs >= 0 && waitedMs >= timeoutMs) {
+                return cv::Mat();
+            }
+            checkDaemon();
+            detail::waitWhile(header->requestTail, tail, timeoutMs >= 0 ? std::min(timeoutMs - waitedMs, 100) : 100);
+        }
+
+        SlotHeader& slot = requests.slot(head);
+        slot.rows = size.height;
+        slot.cols = size.width;
+        slot.type = type;
+        slot.step = step;
+        acquired = true;
+        return cv::Mat(size, type, detail::Ring::pixels(slot), static_cast<size_t>(step));
+    }
+
+    /**
+     * @brief Send the acquired slot to the daemon
+     * @param timestampUs Capture time, returned with the result
+     * @return Sequence number of the frame
+     */
+    uint64_t submit(int64_t timestampUs = 0) {
+        if (!acquired) {
+            throw std::runtime_error("No acquired frame to submit");
+        }
+        uint32_t head = header->requestHead.load(std::memory_order_relaxed);
+        SlotHeader& slot = requests.slot(head);
+        slot.sequence = nextSequence;
+        slot.timestampUs = timestampUs;
+        slot.submitNs = detail::nowNs();
+        acquired = false;
+        header->requestHead.store(head + 1, std::memory_order_release);
+        detail::wake(header->requestHead);
+        return nextSequence++;
+    }
+
+    /**
+     * @brief Copy a frame into the next free slot and send it
+     * @param frame The frame
+     * @param timestampUs Capture time, returned with the result
+     * @param timeoutMs Longest wait for a free slot, -1 for none
+     * @return false on timeout (the frame is not sent)
+     */
+    bool submit(const cv::Mat& frame, int64_t timestampUs = 0, int timeoutMs = -1) {
+        cv::Mat slot = acquire(frame.size(), frame.type(), timeoutMs);
+        if (slot.empty()) {
+            return false;
+        }
+        frame.copyTo(slot);
+        submit(timestampUs);
+        return true;
+    }
+
+    /**
+     * @brief Wait for the next result
+     * @param frame Receives the result, a view of the slot until release()
+     * @param timeoutMs Longest wait, -1 for none
+     * @return false on timeout
+     */
+    bool receive(SharedFrame& frame, int timeoutMs = -1) {
+        uint32_t index = header->resultTail.load(std::memory_order_relaxed) + held;
+        if (!waitChange(header->resultHead, index, timeoutMs)) {
+            return false;
+        }
+        SlotHeader& slot = results.slot(index);
+        uint8_t* pixels = detail::Ring::pixels(slot);
+        frame.sequence = slot.sequence;
+        frame.timestampUs = slot.timestampUs;
+        frame.latencyMs = (detail::nowNs() - slot.submitNs) / 1e6;
+        frame.processMs = slot.processNs / 1e6;
+        frame.failed = slot.failed != 0;
+        if (frame.failed) {
+            frame.image = cv::Mat();
+            frame.error = detail::readText(reinterpret_cast<const char*>(pixels), ERROR_BYTES);
+        } else {
+            frame.image = cv::Mat(slot.rows, slot.cols, slot.type, pixels, static_cast<size_t>(slot.step));
+            frame.error.clear();
+        }
+        ++held;
+        return true;
+    }
+
+    /**
+     * @brief Give the oldest received result slot back to the daemon
+     */
+    void release() {
+        if (held == 0) {
+            throw std::runtime_error("No received frame to release");
+        }
+        --held;
+        header->resultTail.fetch_add(1, std::memory_order_release);
+        detail::wake(header->resultTail);
+    }
+
+    /**
+     * @brief Get the number of frames submitted and not yet received
+     * @return Frames in flight
+     */
+    uint32_t getInFlight() const {
+        return header->requestHead.load(std::memory_order_relaxed) -
+               (header->resultTail.load(std::memory_order_relaxed) + held);
+    }
+
+    /**
+     * @brief Get the statistics the daemon keeps for this client
+     * @return Throughput, latency and processing time
+     */
+    ClientStats getStats() const {
+        ClientStats stats = detail::readStats(header);
+        stats.session = memory->getName();
+        stats.connected = true;
+        return stats;
+    }
+};
+
+/**
+ * @brief Processing daemon: runs the chain of each client on the frames it submits
+ *
+ * Each accepted client gets its own chain (parsed from its spec) and worker
+ * thread, which processes its frames in place in the request slots. A client
+ * that disconnects or dies is dropped; the statistics of the last clients
+ * gone stay in getClientStats().
+ *
+ * The daemon trusts its clients, which run as the same user. It validates
+ * what it reads from a session, but a client can shrink its segment
+ * (ftruncate()) after it was accepted: the pages past the new end are
+ * still mapped, and touching them raises SIGBUS, which stops the whole
+ * daemon and every other client with it. Do not serve untrusted processes.
+ */
+class FrameDaemon {
+private:
+    struct Client {
+        std::unique_ptr<SharedMemory> memory;
+        SessionHeader* header = nullptr;
+        // Validated once in accept(): the client can rewrite the shared header at any time
+        std::string spec;
+        TreatmentChain chain;
+        uint64_t slotBytes = 0;
+        detail::Ring requests;
+        detail::Ring results;
+        std::thread worker;
+        std::atomic<bool> done{false};
+    };
+
+    std::unique_ptr<SharedMemory> control;
+    ControlHeader* controlHeader = nullptr;
+    std::atomic<bool> stopping{false};
+    std::thread acceptor;
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Client>> clients;
+    std::deque<ClientStats> finished;  // Last clients gone
+
+    static constexpr size_t FINISHED_KEPT = 16;
+
+    static void fail(SlotHeader& result, const std::string& message, uint64_t slotBytes) {
+        result.failed = 1;
+        result.rows = result.cols = 0;
+        detail::copyText(reinterpret_cast<char*>(detail::Ring::pixels(result)),
+                         static_cast<size_t>(std::min<uint64_t>(slotBytes, ERROR_BYTES)), message);
+    }
+
+    static bool clientGone(const SessionHeader* header) {
+        return header->state.load(std::memory_order_acquire) == Closed || !detail::processAlive(header->clientPid);
+    }
+
+    /**
+     * @brief Process the frames of one client until it leaves
+     */
+    void serve(Client& client) {
+        SessionHeader* header = client.header;
+        TreatmentChain& chain = client.chain;
+        chain.setRecordIntermediates(false);  // Nobody reads them, and fused kernels need it
+        const detail::Ring& requests = client.requests;
+        const detail::Ring& results = client.results;
+        const uint64_t slotBytes = client.slotBytes;
+
+        while (!stopping.load() && !clientGone(header)) {
+            uint32_t tail = header->requestTail.load(std::memory_order_relaxed);
+            if (header->requestHead.load(std::memory_order_acquire) == tail) {
+                detail::waitWhile(header->requestHead, tail, 100);
+                continue;
+            }
+            uint32_t resultHead = header->resultHead.load(std::memory_order_relaxed);
+            uint32_t resultTail = header->resultTail.load(std::memory_order_acquire);
+            if (resultHead - resultTail >= results.count) {
+                detail::waitWhile(header->resultTail, resultTail, 100);  // The client holds every result slot
+                continue;
+            }
+
+            // Validate and use a copy: the client may rewrite its slot header meanwhile
+            SlotHeader request;
+            std::memcpy(&request, &requests.slot(tail), sizeof(request));
+            uint8_t* requestPixels = detail::Ring::pixels(requests.slot(tail));
+            SlotHeader& result = results.slot(resultHead);
+            uint8_t* resultPixels = detail::Ring::pixels(result);
+            bool failed = false;
+            auto start = std::chrono::steady_clock::now();
+            result.failed = 0;
+            try {
+                if (request.rows <= 0 || request.cols <= 0 ||
+                    request.step < static_cast<uint64_t>(request.cols) * CV_ELEM_SIZE(request.type) ||
+                    request.step > slotBytes / static_cast<uint64_t>(request.rows)) {
+                    throw std::invalid_argument("Invalid frame header");
+                }
+                // The chain reads the client's pixels where they are
+                cv::Mat input(request.rows, request.cols, request.type, requestPixels,
+                              static_cast<size_t>(request.step));
+                ImageFormat format = chain.prepare(input.size(), input.type());
+                uint64_t step = static_cast<uint64_t>(format.size.width) * CV_ELEM_SIZE(format.type);
+                if (step * format.size.height > slotBytes) {
+                    throw std::runtime_error("Result larger than a transport slot");
+                }
+                // The last stage writes into the result slot
+                cv::Mat output(format.size, format.type, resultPixels, static_cast<size_t>(step));
+                chain.processChain(input, output);
+                if (output.data != resultPixels) {
+                    // Not the format prepare() announced: copy it into the slot
+                    step = static_cast<uint64_t>(output.cols) * output.elemSize();
+                    if (step * output.rows > slotBytes) {
+                        throw std::runtime_error("Result larger than a transport slot");
+                    }
+                    cv::Mat slotView(output.rows, output.cols, output.type(), resultPixels,
+                                     static_cast<size_t>(step));
+                    output.copyTo(slotView);
+                }
+                result.rows = output.rows;
+                result.cols = output.cols;
+                result.type = output.type();
+                result.step = step;
+            } catch (const std::exception& e) {
+                failed = true;
+                fail(result, e.what(), slotBytes);
+            }
+            int64_t processNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            result.sequence = request.sequence;
+            result.timestampUs = request.timestampUs;
+            result.submitNs = request.submitNs;
+            result.processNs = processNs;
+
+            header->requestTail.store(tail + 1, std::memory_order_release);
+            detail::wake(header->requestTail);
+            header->resultHead.store(resultHead + 1, std::memory_order_release);
+            detail::wake(header->resultHead);
+
+            int64_t now = detail::nowNs();
+            uint64_t latency = static_cast<uint64_t>(std::max<int64_t>(now - request.submitNs, 0));
+            if (header->framesProcessed.load(std::memory_order_relaxed) == 0) {
+                header->firstResultNs.store(now, std::memory_order_relaxed);
+            }
+            header->lastResultNs.store(now, std::memory_order_relaxed);
+            header->processNsTotal.store(header->processNsTotal.load() + processNs, std::memory_order_relaxed);
+            header->latencyNsTotal.store(header->latencyNsTotal.load() + latency, std::memory_order_relaxed);
+            header->latencyNsMax.store(std::max(header->latencyNsMax.load(), latency), std::memory_order_relaxed);
+            if (failed) {
+                header->framesFailed.store(header->framesFailed.load() + 1, std::memory_order_relaxed);
+            }
+            header->framesProcessed.store(header->framesProcessed.load() + 1, std::memory_order_release);
+        }
+        client.done.store(true);
+    }
+
+    void accept(ControlSlot& slot) {
+        std::string session = detail::readText(slot.session, NAME_BYTES);
+        slot.clientPid = 0;
+        slot.state.store(Free, std::memory_order_release);
+
+        // The size is only checked here: the client may shrink the segment later (see the class doc)
+        std::unique_ptr<SharedMemory> memory = SharedMemory::open(session);
+        if (!memory || memory->size() < sizeof(SessionHeader)) {
+            return;
+        }
+        auto* header = reinterpret_cast<SessionHeader*>(memory->data());
+        // Read each shared field once, then check and keep the copies
+        const uint32_t version = header->version;
+        const uint32_t slotCount = header->slotCount;
+        const uint64_t slotBytes = header->slotBytes;
+        const uint64_t totalBytes = std::min<uint64_t>(header->totalBytes, memory->size());
+        if (std::memcmp(header->magic, "ITSHMSES", 8) != 0 || version != VERSION ||
+            !detail::isPowerOfTwo(slotCount) || slotBytes > totalBytes ||
+            slotCount > totalBytes / (2 * detail::slotStride(slotBytes)) ||
+            detail::sessionBytes(slotCount, slotBytes) > totalBytes) {
+            return;
+        }
+
+        auto client = std::make_unique<Client>();
+        client->spec = detail::readText(header->spec, SPEC_BYTES);
+        try {
+            client->chain = ChainSpec::parse(client->spec);
+        } catch (const std::exception& e) {
+            detail::copyText(header->error, ERROR_BYTES, e.what());
+            header->state.store(Rejected, std::memory_order_release);
+            detail::wake(header->state);
+            return;
+        }
+
+        client->memory = std::move(memory);
+        client->header = header;
+        client->slotBytes = slotBytes;
+        client->requests = detail::requestRing(header, slotCount, slotBytes);
+        client->results = detail::resultRing(header, slotCount, slotBytes);
+        Client* started = client.get();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            clients.push_back(std::move(client));
+        }
+        started->worker = std::thread(&FrameDaemon::serve, this, std::ref(*started));
+        uint32_t requested = Requested;
+        header->state.compare_exchange_strong(requested, Ready, std::memory_order_acq_rel);  // Unless the client gave up
+        detail::wake(header->state);
+    }
+
+    /**
+     * @brief Join the workers of the clients gone and keep their last statistics
+     */
+    void reap() {
+        std::vector<std::unique_ptr<Client>> gone;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto it = clients.begin(); it != clients.end();) {
+                if ((*it)->done.load()) {
+                    gone.push_back(std::move(*it));
+                    it = clients.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        for (auto& client : gone) {
+            client->worker.join();
+            ClientStats stats = detail::readStats(client->header);
+            stats.session = client->memory->getName();
+            stats.spec = client->spec;
+            if (!detail::processAlive(client->header->clientPid)) {
+                client->memory->unlink();  // Crashed client: nobody else removes its segment
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.push_back(stats);
+            if (finished.size() > FINISHED_KEPT) {
+                finished.pop_front();
+            }
+        }
+    }
+
+    void run() {
+        while (!stopping.load()) {
+            uint32_t posted = controlHeader->posted.load(std::memory_order_acquire);
+            for (ControlSlot& slot : controlHeader->slots) {
+                uint32_t state = slot.state.load(std::memory_order_acquire);
+                if (state == Posted) {
+                    accept(slot);
+                } else if (state == Claimed && slot.clientPid != 0 && !detail::processAlive(slot.clientPid)) {
+                    slot.clientPid = 0;
+                    slot.state.store(Free, std::memory_order_release);  // Client died while posting
+                }
+            }
+            reap();
+            detail::waitWhile(controlHeader->posted, posted, 200);
+        }
+    }
+
+public:
+    /**
+     * @brief Publish the control segment and start accepting clients
+     * @param name Control segment name (starts with '/')
+     * @throws std::runtime_error if a daemon is already running under that name
+     */
+    explicit FrameDaemon(const std::string& name = DEFAULT_DAEMON_NAME) {
+        if (std::unique_ptr<SharedMemory> existing = SharedMemory::open(name)) {
+            auto* previous = reinterpret_cast<ControlHeader*>(existing->data());
+            if (existing->size() >= sizeof(ControlHeader) && detail::processAlive(previous->daemonPid) &&
+                previous->daemonPid != static_cast<uint32_t>(getpid())) {
+                throw std::runtime_error("A processing daemon is already running (" + name + ")");
+            }
+            existing->unlink();  // Left by a daemon that died
+        }
+        control = SharedMemory::create(name, sizeof(ControlHeader));
+        controlHeader = new (control->data()) ControlHeader();
+        std::memcpy(controlHeader->magic, "ITDAEMON", 8);
+        controlHeader->version = VERSION;
+        controlHeader->daemonPid = static_cast<uint32_t>(getpid());
+        acceptor = std::thread(&FrameDaemon::run, this);
+    }
+
+    FrameDaemon(const FrameDaemon&) = delete;
+    FrameDaemon& operator=(const FrameDaemon&) = delete;
+
+    /**
+     * @brief Stop accepting clients and drop the connected ones
+     */
+    ~FrameDaemon() {
+        stopping.store(true);
+        detail::wake(controlHeader->posted);
+        acceptor.join();
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& client : clients) {
+            client->header->state.store(Closed, std::memory_order_release);
+            detail::wake(client->header->requestHead);
+            detail::wake(client->header->resultHead);
+            detail::wake(client->header->resultTail);
+            client->worker.join();
+        }
+    }
+
+    /**
+     * @brief Get the statistics of the connected clients, then of the last ones gone
+     * @return One entry per client
+     */
+    std::vector<ClientStats> getClientStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<ClientStats> all;
+        for (const auto& client : clients) {
+            ClientStats stats = detail::readStats(client->header);
+            stats.session = client->memory->getName();
+            stats.spec = client->spec;
+            stats.connected = true;
+            all.push_back(stats);
+        }
+        all.insert(all.end(), finished.begin(), finished.end());
+        return all;
+    }
+
+    /**
+     * @brief Get the number of connected clients
+     * @return Clients with a worker thread
+     */
+    size_t getClientCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return clients.size();
+    }
+};
+
+} // namespace shm_transport
+
+#endif // IT_SHM_TRANSPORT
+
+#endif // SHARED_FRAME_TRANSPORT_H
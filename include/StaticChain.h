@@ -0,0 +1,513 @@
+#ifndef STATIC_CHAIN_H
+#define STATIC_CHAIN_H
+
+#include "TreatmentChain.h"
+#include "kernels/FusedCanny.h"
+#include "kernels/PointwiseRows.h"
+#include "kernels/FixedPointGaussian.h"
+#include "treatments/BrightnessTreatment.h"
+#include "treatments/GaussianBlurTreatment.h"
+#include "treatments/GrayscaleTreatment.h"
+#include "treatments/ThresholdTreatment.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Brightness/contrast stage whose parameters are fixed at compile time
+ *
+ * alpha = AlphaPercent / 100, beta = Beta. The lookup table used by StaticChain
+ * is a constant expression.
+ */
+template <int AlphaPercent, int Beta = 0>
+class FixedBrightnessTreatment : public BrightnessTreatment {
+public:
+    static constexpr kernels::ByteLut lut = kernels::brightnessLut(AlphaPercent / 100.0, Beta);
+
+    FixedBrightnessTreatment()
+        : BrightnessTreatment(AlphaPercent / 100.0, Beta) {}
+
+    bool setParameter(const std::string& paramName, const std::string& value) override {
+        return false;  // Parameters are template arguments
+    }
+
+    std::unique_ptr<Treatment> clone() const override {
+        return std::make_unique<FixedBrightnessTreatment>();
+    }
+};
+
+/**
+ * @brief Threshold stage whose parameters are fixed at compile time
+ */
+template <int Thresh, int MaxValue = 255, int Type = cv::THRESH_BINARY>
+class FixedThresholdTreatment : public ThresholdTreatment {
+    static_assert(Type >= cv::THRESH_BINARY && Type <= cv::THRESH_TOZERO_INV, "Unsupported threshold type");
+
+public:
+    static constexpr kernels::ByteThreshold bytes = kernels::byteThreshold(Thresh, MaxValue);
+
+    FixedThresholdTreatment()
+        : ThresholdTreatment(Thresh, MaxValue, Type) {}
+
+    bool setParameter(const std::string& paramName, const std::string& value) override {
+        return false;  // Parameters are template arguments
+    }
+
+    std::unique_ptr<Treatment> clone() const override {
+        return std::make_unique<FixedThresholdTreatment>();
+    }
+};
+
+/**
+ * @brief How StaticChain runs a stage
+ */
+enum class StageKind {
+    Whole,      // Own process() on the whole image
+    Pointwise,  // Output pixel from the same input pixel: fused row by row
+    RowLocal    // Output row from the input rows within a radius: fused through a ring of rows
+};
+
+/**
+ * @brief How StaticChain runs a stage type
+ *
+ * The primary template runs the stage's own process() on the whole image.
+ * Specializations for 8-bit stages set kind and provide:
+ * - State prepare(const T&): parameters read once per frame
+ * - bool accepts(const State&, int cn): whether the fused path reproduces
+ *   process() for these parameters and channels (otherwise process() runs)
+ * - int outChannels(int cn): channels of the output
+ * - Pointwise: void row(const State&, src, dst, cols, cn), dst != src
+ * - RowLocal: int radius(const State&), size_t lineBytes(const State&, cols, cn),
+ *   void line(const State&, src, line, cols, cn) buffering one input row, and
+ *   void row(const State&, lines, dst, cols, cn) from the 2 * radius + 1
+ *   buffered rows around the output row (borders reflected), dst != lines
+ */
+template <typename T>
+struct StageTraits {
+    static constexpr StageKind kind = StageKind::Whole;
+};
+
+template <>
+struct StageTraits<GrayscaleTreatment> {
+    static constexpr StageKind kind = StageKind::Pointwise;
+    struct State {};
+
+    static State prepare(const GrayscaleTreatment&) {
+        return {};
+    }
+    static bool accepts(const State&, int cn) {
+        return cn == 1 || cn == 3 || cn == 4;
+    }
+    static int outChannels(int) {
+        return 1;
+    }
+    static void row(const State&, const uint8_t* src, uint8_t* dst, int cols, int cn) {
+        if (cn == 3) {
+            kernels::detail::lumaRow<3>(src, dst, cols);
+        } else if (cn == 4) {
+            kernels::detail::lumaRow<4>(src, dst, cols);
+        } else {
+            std::memcpy(dst, src, cols);
+        }
+    }
+};
+
+template <>
+struct StageTraits<BrightnessTreatment> {
+    static constexpr StageKind kind = StageKind::Pointwise;
+    struct State {
+        double alpha;
+        double beta;
+        kernels::ByteLut lut;
+    };
+
+    static State prepare(const BrightnessTreatment& stage) {
+        return {stage.getAlpha(), stage.getBeta(), kernels::brightnessLut(stage.getAlpha(), stage.getBeta())};
+    }
+    static bool accepts(const State&, int cn) {
+        return cn >= 1 && cn <= 4;
+    }
+    static int outChannels(int cn) {
+        return cn;
+    }
+    static void row(const State& state, const uint8_t* src, uint8_t* dst, int cols, int cn) {
+        kernels::brightnessRow(src, dst, cols * cn, state.alpha, state.beta, state.lut);
+    }
+};
+
+template <int AlphaPercent, int Beta>
+struct StageTraits<FixedBrightnessTreatment<AlphaPercent, Beta>> {
+    using Stage = FixedBrightnessTreatment<AlphaPercent, Beta>;
+    static constexpr StageKind kind = StageKind::Pointwise;
+    struct State {};
+
+    static State prepare(const Stage&) {
+        return {};
+    }
+    static bool accepts(const State&, int cn) {
+        return cn >= 1 && cn <= 4;
+    }
+    static int outChannels(int cn) {
+        return cn;
+    }
+    static void row(const State&, const uint8_t* src, uint8_t* dst, int cols, int cn) {
+        kernels::brightnessRow(src, dst, cols * cn, AlphaPercent / 100.0, Beta, Stage::lut);
+    }
+};
+
+template <>
+struct StageTraits<ThresholdTreatment> {
+    static constexpr StageKind kind = StageKind::Pointwise;
+    struct State {
+        int type;
+        kernels::ByteThreshold bytes;
+    };
+
+    static State prepare(const ThresholdTreatment& stage) {
+        return {stage.getThresholdType(), kernels::byteThreshold(stage.getThresholdValue(), stage.getMaxValue())};
+    }
+    static bool accepts(const State& state, int cn) {
+        // THRESH_OTSU / THRESH_TRIANGLE pick the threshold from the whole image: process() runs
+        return (cn == 1 || cn == 3) && (state.type & ~cv::THRESH_MASK) == 0 && kernels::canUseThresholdRow(state.type);
+    }
+    static int outChannels(int) {
+        return 1;
+    }
+    static void row(const State& state, const uint8_t* src, uint8_t* dst, int cols, int cn) {
+        // Color input is converted to grayscale first, as ThresholdTreatment does
+        if (cn == 3) {
+            kernels::detail::lumaRow<3>(src, dst, cols);
+            src = dst;
+        }
+        kernels::thresholdRow(src, dst, cols, state.type, state.bytes.thresh, state.bytes.maxval);
+    }
+};
+
+template <int Thresh, int MaxValue, int Type>
+struct StageTraits<FixedThresholdTreatment<Thresh, MaxValue, Type>> {
+    using Stage = FixedThresholdTreatment<Thresh, MaxValue, Type>;
+    static constexpr StageKind kind = StageKind::Pointwise;
+    struct State {};
+
+    static State prepare(const Stage&) {
+        return {};
+    }
+    static bool accepts(const State&, int cn) {
+        return cn == 1 || cn == 3;
+    }
+    static int outChannels(int) {
+        return 1;
+    }
+    static void row(const State&, const uint8_t* src, uint8_t* dst, int cols, int cn) {
+        if (cn == 3) {
+            kernels::detail::lumaRow<3>(src, dst, cols);
+            src = dst;
+        }
+        kernels::thresholdRow<Type>(src, dst, cols, Stage::bytes.thresh, Stage::bytes.maxval);
+    }
+};
+
+template <>
+struct StageTraits<GaussianBlurTreatment> {
+    static constexpr StageKind kind = StageKind::RowLocal;
+    struct State {
+        kernels::GaussianKernelQ8 kernel;  // ksize 0 when process() would not take the fixed-point path
+    };
+
+    static State prepare(const GaussianBlurTreatment& stage) {
+        if (!stage.isFixedPoint() || stage.getKernelSize() > 9) {
+            return {};
+        }
+        return {kernels::makeGaussianKernelQ8(stage.getKernelSize(), stage.getSigmaX(), stage.getSigmaY())};
+    }
+    static bool accepts(const State& state, int cn) {
+        const int ksize = state.kernel.ksize;
+        return (cn == 1 || cn == 3) && (ksize == 3 || ksize == 5 || ksize == 7 || ksize == 9);
+    }
+    static int outChannels(int cn) {
+        return cn;
+    }
+    static int radius(const State& state) {
+        return state.kernel.ksize / 2;
+    }
+    static size_t lineBytes(const State&, int cols, int cn) {
+        return static_cast<size_t>(cols) * cn * sizeof(uint16_t);
+    }
+    static void line(const State& state, const uint8_t* src, uint8_t* line, int cols, int cn) {
+        kernels::gaussianLineFixedPoint(state.kernel, src, reinterpret_cast<uint16_t*>(line), cols, cn);
+    }
+    static void row(const State& state, const uint8_t* const* lines, uint8_t* dst, int cols, int cn) {
+        const uint16_t* window[9];
+        for (int k = 0; k < state.kernel.ksize; ++k) {
+            window[k] = reinterpret_cast<const uint16_t*>(lines[k]);
+        }
+        kernels::gaussianColumnFixedPoint(state.kernel, window, dst, cols * cn);
+    }
+};
+
+/**
+ * @brief Treatment chain whose stage types are fixed at compile time
+ *
+ * StaticChain<GrayscaleTreatment, GaussianBlurTreatment, FixedThresholdTreatment<127>>
+ * holds its stages by value and calls them without virtual dispatch or string
+ * parameters. Consecutive pointwise and row-local stages (see StageTraits) on
+ * 8-bit images are fused: the image is cut into horizontal stripes processed
+ * in parallel, each stripe is swept once from top to bottom, and each input
+ * row goes through all the stages in cache-resident row buffers. A row-local
+ * stage (the fixed-point GaussianBlurTreatment above) keeps a ring of its
+ * last 2 * radius + 1 input rows, as kernels/FusedCanny.h does, and emits an
+ * output row as soon as the rows below it arrive; stripes recompute the halo
+ * rows they share. Only the last stage writes an image. Other stages (Canny,
+ * morphology, cv::GaussianBlur fallbacks) run their own process() on the
+ * whole image and split the fused runs around them.
+ *
+ * The output is identical to a TreatmentChain of the same treatments, which
+ * toTreatmentChain() builds for comparison.
+ */
+template <typename... Ts>
+class StaticChain {
+    static_assert(sizeof...(Ts) > 0, "StaticChain needs at least one stage");
+    static_assert(std::conjunction<std::is_base_of<Treatment, Ts>...>::value,
+                  "StaticChain stages must derive from Treatment");
+
+private:
+    using Stages = std::tuple<Ts...>;
+    static constexpr size_t stageCount = sizeof...(Ts);
+
+    template <size_t I>
+    using StageAt = std::tuple_element_t<I, Stages>;
+
+    Stages stages;
+
+    static constexpr int MAX_FUSED_RADIUS = 32;  // Larger row-local stages run process()
+
+    /**
+     * @brief End of the run of fusable (pointwise or row-local) stages starting at I
+     */
+    template <size_t I>
+    static constexpr size_t fusedRunEnd() {
+        if constexpr (I < stageCount) {
+            if constexpr (StageTraits<StageAt<I>>::kind != StageKind::Whole) {
+                return fusedRunEnd<I + 1>();
+            } else {
+                return I;
+            }
+        } else {
+            return I;
+        }
+    }
+
+    /**
+     * @brief Run stage I on the whole image with its own process()
+     */
+    template <size_t I>
+    cv::Mat runStage(const cv::Mat& input) {
+        using Stage = StageAt<I>;
+        Stage& stage = std::get<I>(stages);
+        // Qualified calls: the stage type is known, no virtual dispatch
+        if (!stage.Stage::validateInput(input)) {
+            throw std::runtime_error("Treatment " + std::to_string(I) + " cannot process the current image");
+        }
+        return stage.Stage::process(input);
+    }
+
+    /**
+     * @brief Rows one fused stage produces in a stripe, and its row buffers
+     */
+    struct Lane {
+        int channels = 0;           // Input channels
+        int radius = 0;             // Input rows read above and below an output row
+        int begin = 0;              // Output rows [begin, end) of the stripe
+        int end = 0;
+        int next = 0;               // Next output row to emit
+        size_t lineBytes = 0;       // Bytes of one buffered input row (row-local)
+        std::vector<uint8_t> ring;  // 2 * radius + 1 buffered input rows (row-local)
+        std::vector<uint8_t> out;   // Output row handed to the next stage
+    };
+
+    /**
+     * @brief Push input row y of stage First + K through it and the stages after it
+     */
+    template <size_t First, size_t K, size_t Count, typename States>
+    static void feed(const States& states, std::array<Lane, Count>& lanes, cv::Mat& output,
+                     int rows, int cols, int y, const uint8_t* src) {
+        using Traits = StageTraits<StageAt<First + K>>;
+        Lane& lane = lanes[K];
+        const auto& state = std::get<K>(states);
+        auto emit = [&](int outRow) -> uint8_t* {
+            // The last stage writes into the output directly
+            return K + 1 == Count ? output.ptr<uint8_t>(outRow) : lane.out.data();
+        };
+        if constexpr (Traits::kind == StageKind::Pointwise) {
+            uint8_t* dst = emit(y);
+            Traits::row(state, src, dst, cols, lane.channels);
+            if constexpr (K + 1 < Count) {
+                feed<First, K + 1, Count>(states, lanes, output, rows, cols, y, dst);
+            }
+        } else {
+            const int window = 2 * lane.radius + 1;
+            Traits::line(state, src, &lane.ring[static_cast<size_t>(y % window) * lane.lineBytes], cols, lane.channels);
+            // Emit every output row whose lowest input row (clipped to the image) has arrived
+            const uint8_t* lines[2 * MAX_FUSED_RADIUS + 1];
+            for (; lane.next < lane.end && std::min(rows - 1, lane.next + lane.radius) <= y; ++lane.next) {
+                for (int k = 0; k < window; ++k) {
+                    int source = cv::borderInterpolate(lane.next - lane.radius + k, rows, cv::BORDER_REFLECT_101);
+                    lines[k] = &lane.ring[static_cast<size_t>(source % window) * lane.lineBytes];
+                }
+                uint8_t* dst = emit(lane.next);
+                Traits::row(state, lines, dst, cols, lane.channels);
+                if constexpr (K + 1 < Count) {
+                    feed<First, K + 1, Count>(states, lanes, output, rows, cols, lane.next, dst);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Run fusable stages First..First+sizeof(Ks)-1 as one sweep per stripe
+     * @param output Receives the result of the run
+     * @return false if a stage does not take the fused path for this image (output untouched)
+     */
+    template <size_t First, size_t... Ks>
+    bool runFused(const cv::Mat& input, cv::Mat& output, std::index_sequence<Ks...>) {
+        constexpr size_t count = sizeof...(Ks);
+        auto states = std::make_tuple(StageTraits<StageAt<First + Ks>>::prepare(std::get<First + Ks>(stages))...);
+
+        int channels[count + 1] = {input.channels()};
+        int radii[count] = {};
+        size_t lineBytes[count] = {};
+        bool accepted[count] = {};
+        auto describe = [&](auto k) {
+            constexpr size_t K = decltype(k)::value;
+            using Traits = StageTraits<StageAt<First + K>>;
+            const auto& state = std::get<K>(states);
+            accepted[K] = Traits::accepts(state, channels[K]);
+            channels[K + 1] = Traits::outChannels(channels[K]);
+            if constexpr (Traits::kind == StageKind::RowLocal) {
+                radii[K] = accepted[K] ? Traits::radius(state) : 0;
+                lineBytes[K] = Traits::lineBytes(state, input.cols, channels[K]);
+            }
+        };
+        (describe(std::integral_constant<size_t, Ks>{}), ...);
+        if (std::find(accepted, accepted + count, false) != accepted + count ||
+            *std::max_element(radii, radii + count) > MAX_FUSED_RADIUS) {
+            return false;
+        }
+        const int widest = *std::max_element(channels, channels + count + 1);
+
+        const int rows = input.rows;
+        const int cols = input.cols;
+        const int stripes = std::max(1, std::min(cv::getNumThreads() * 4, rows / 64));
+        cv::Mat result(input.size(), CV_8UC(channels[count]));
+
+        cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+            std::array<Lane, count> lanes;
+            for (int s = range.start; s < range.end; ++s) {
+                const int y0 = rows * s / stripes;
+                const int y1 = rows * (s + 1) / stripes;
+                // Stage k outputs the stripe plus the rows the stages after it read around it
+                int halo = 0;
+                for (size_t k = count; k-- > 0;) {
+                    Lane& lane = lanes[k];
+                    lane.channels = channels[k];
+                    lane.radius = radii[k];
+                    lane.begin = lane.next = std::max(0, y0 - halo);
+                    lane.end = std::min(rows, y1 + halo);
+                    lane.lineBytes = lineBytes[k];
+                    lane.ring.resize(lineBytes[k] * (2 * radii[k] + 1));
+                    lane.out.resize(static_cast<size_t>(cols) * widest);
+                    halo += radii[k];
+                }
+                const int top = std::max(0, y0 - halo);
+                const int bottom = std::min(rows, y1 + halo);
+                for (int y = top; y < bottom; ++y) {
+                    feed<First, 0, count>(states, lanes, result, rows, cols, y, input.ptr<uint8_t>(y));
+                }
+            }
+        }, stripes);
+
+        output = result;
+        return true;
+    }
+
+    /**
+     * @brief Run stages I..end, fusing pointwise and row-local runs when the image is 8-bit
+     */
+    template <size_t I>
+    cv::Mat runFrom(const cv::Mat& input) {
+        if constexpr (I == stageCount) {
+            return input;
+        } else if constexpr (StageTraits<StageAt<I>>::kind != StageKind::Whole) {
+            constexpr size_t end = fusedRunEnd<I>();
+            cv::Mat fused;
+            if (input.depth() == CV_8U && runFused<I>(input, fused, std::make_index_sequence<end - I>{})) {
+                return runFrom<end>(fused);
+            }
+            // A stage refused its parameters or format: run it alone, fuse from the next one
+            return runFrom<I + 1>(runStage<I>(input));
+        } else {
+            return runFrom<I + 1>(runStage<I>(input));
+        }
+    }
+
+    template <size_t... Is>
+    void appendClones(TreatmentChain& chain, std::index_sequence<Is...>) const {
+        (chain.addTreatment(std::get<Is>(stages).clone()), ...);
+    }
+
+public:
+    StaticChain() = default;
+
+    /**
+     * @brief Create a chain from configured stages
+     * @param stages One treatment per stage type (copied)
+     */
+    explicit StaticChain(const Ts&... stages)
+        : stages(stages...) {}
+
+    /**
+     * @brief Get the number of stages
+     * @return Number of stages
+     */
+    static constexpr size_t size() {
+        return stageCount;
+    }
+
+    /**
+     * @brief Access a stage (e.g. to change the parameters of a non-fixed stage)
+     * @return Reference to stage I
+     */
+    template <size_t I>
+    StageAt<I>& get() {
+        return std::get<I>(stages);
+    }
+
+    /**
+     * @brief Process an image through every stage
+     * @param input The input image
+     * @return The final processed image
+     */
+    cv::Mat process(const cv::Mat& input) {
+        if (input.empty()) {
+            throw std::invalid_argument("Input image is empty");
+        }
+        return runFrom<0>(input);
+    }
+
+    /**
+     * @brief Build the equivalent dynamic chain (e.g. to benchmark against it)
+     * @return A TreatmentChain holding clones of the stages
+     */
+    TreatmentChain toTreatmentChain() const {
+        TreatmentChain chain;
+        appendClones(chain, std::make_index_sequence<stageCount>{});
+        return chain;
+    }
+};
+
+#endif // STATIC_CHAIN_H
@@ -0,0 +1,331 @@
+#ifndef SYNTHETIC_IMAGE_SOURCE_H
+#define SYNTHETIC_IMAGE_SOURCE_H
+
+#include "ImageSource.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief What a SyntheticImageSource draws
+ */
+enum class SyntheticContent {
+    Noise,         // Uniform noise, different on every frame of the pool
+    Gradient,      // Color ramps scrolling horizontally
+    MovingShapes,  // Circles and rectangles bouncing over a gradient background
+    StaticScene    // A fixed scene where only a small square moves (change detection)
+};
+
+/**
+ * @brief Image source generating frames procedurally, faster than any camera or decoder
+ *
+ * Everything expensive is rendered once by the constructor: frames are drawn
+ * in a pool of preallocated buffers (or are views of a prerendered strip for
+ * Gradient), and a new frame only redraws what moved since that buffer was
+ * last used. A frame therefore costs one copy whatever its content, so
+ * benchmarks at 8K or hundreds of frames per second measure the pipeline
+ * rather than the source.
+ *
+ * Each frame returned by getImage() is a new image owned by the caller, like
+ * a camera frame: it can be kept or modified freely. renderInto() writes the
+ * frame into an existing buffer instead. The content is the same from run to
+ * run for a given seed. setAllocator() applies to the returned frames, and to
+ * the pool on the next reset().
+ */
+class SyntheticImageSource : public ImageSource {
+private:
+    struct Shape {
+        cv::Point2d position;  // Center
+        cv::Point2d velocity;  // Pixels per frame
+        int radius;
+        bool circle;
+        cv::Scalar color;
+
+        cv::Rect bounds(const cv::Size& size) const {
+            cv::Rect box(static_cast<int>(position.x) - radius - 1, static_cast<int>(position.y) - radius - 1,
+                         2 * radius + 3, 2 * radius + 3);
+            return box & cv::Rect(0, 0, size.width, size.height);
+        }
+    };
+
+    cv::Size size;
+    int type;
+    SyntheticContent content;
+    double fps;
+    size_t poolSize;
+    uint64_t seed;
+
+    std::vector<cv::Mat> pool;
+    std::vector<std::vector<cv::Rect>> dirty;  // Per buffer: regions drawn over the background
+    cv::Mat background;                        // Shapes and StaticScene
+    cv::Mat strip;                             // Gradient: frames are views of it
+    std::vector<Shape> shapes;
+    cv::RNG rng;
+
+    size_t frameIndex = 0;
+    std::chrono::steady_clock::time_point start;
+
+    static constexpr int GRADIENT_PERIOD = 256;
+
+    /**
+     * @brief Scale of a pixel value given in 8-bit units for the source type
+     */
+    double unit() const {
+        switch (CV_MAT_DEPTH(type)) {
+            case CV_16U: return 257.0;
+            case CV_16S: return 128.0;
+            case CV_32F:
+            case CV_64F: return 1.0 / 255.0;
+            default: return 1.0;
+        }
+    }
+
+    /**
+     * @brief Convert an image rendered in 8 bits to the source type
+     */
+    cv::Mat toSourceType(const cv::Mat& rendered) const {
+        cv::Mat converted;
+        converted.allocator = allocator;
+        rendered.convertTo(converted, CV_MAT_DEPTH(type), unit());
+        return converted;
+    }
+
+    cv::Mat renderGradient(int width, int height, int xScale) const {
+        const int cn = CV_MAT_CN(type);
+        cv::Mat rendered(height, width, CV_8UC(cn));
+        for (int y = 0; y < height; ++y) {
+            uchar* row = rendered.ptr<uchar>(y);
+            for (int x = 0; x < width; ++x) {
+                for (int c = 0; c < cn; ++c) {
+                    row[x * cn + c] = static_cast<uchar>((x * xScale / GRADIENT_PERIOD + y * 128 / height + c * 85) & 255);
+                }
+            }
+        }
+        return rendered;
+    }
+
+    void addShapes(int count, int minRadius, int maxRadius, double maxSpeed) {
+        for (int i = 0; i < count; ++i) {
+            Shape shape;
+            shape.radius = rng.uniform(minRadius, maxRadius + 1);
+            shape.position = cv::Point2d(rng.uniform(0.0, static_cast<double>(size.width)),
+                                         rng.uniform(0.0, static_cast<double>(size.height)));
+            shape.velocity = cv::Point2d(rng.uniform(-maxSpeed, maxSpeed), rng.uniform(-maxSpeed, maxSpeed));
+            shape.circle = (i % 2) == 0;
+            shape.color = cv::Scalar(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256), 255) * unit();
+            shapes.push_back(shape);
+        }
+    }
+
+    void moveShapes() {
+        for (Shape& shape : shapes) {
+            shape.position += shape.velocity;
+            if (shape.position.x < 0 || shape.position.x >= size.width) {
+                shape.velocity.x = -shape.velocity.x;
+                shape.position.x = std::min(std::max(shape.position.x, 0.0), size.width - 1.0);
+            }
+            if (shape.position.y < 0 || shape.position.y >= size.height) {
+                shape.velocity.y = -shape.velocity.y;
+                shape.position.y = std::min(std::max(shape.position.y, 0.0), size.height - 1.0);
+            }
+        }
+    }
+
+    /**
+     * @brief Redraw a pool buffer: restore what was drawn in it, draw the shapes where they are now
+     */
+    void drawShapes(size_t slot) {
+        cv::Mat& frame = pool[slot];
+        for (const cv::Rect& region : dirty[slot]) {
+            background(region).copyTo(frame(region));
+        }
+        dirty[slot].clear();
+        for (const Shape& shape : shapes) {
+            cv::Point center(static_cast<int>(shape.position.x), static_cast<int>(shape.position.y));
+            if (shape.circle) {
+                cv::circle(frame, center, shape.radius, shape.color, cv::FILLED);
+            } else {
+                cv::rectangle(frame, cv::Rect(center.x - shape.radius, center.y - shape.radius,
+                                              2 * shape.radius, 2 * shape.radius), shape.color, cv::FILLED);
+            }
+            cv::Rect region = shape.bounds(size);
+            if (region.area() > 0) {
+                dirty[slot].push_back(region);
+            }
+        }
+    }
+
+public:
+    /**
+     * @brief Create a generator
+     * @param frameSize Width and height of the frames (e.g. 7680x4320)
+     * @param frameType cv::Mat type of the frames (e.g. CV_8UC3, CV_16UC1, CV_32FC3)
+     * @param frameContent What to draw
+     * @param framesPerSecond Pace getImage() at this rate, or 0 to return frames immediately
+     * @param buffers Number of preallocated buffers (Noise cycles through that many different frames)
+     * @param randomSeed Seed of the noise, shape positions and colors
+     */
+    SyntheticImageSource(const cv::Size& frameSize, int frameType = CV_8UC3,
+                         SyntheticContent frameContent = SyntheticContent::MovingShapes,
+                         double framesPerSecond = 0.0, size_t buffers = 4, uint64_t randomSeed = 0x5EED)
+        : size(frameSize), type(frameType), content(frameContent), fps(framesPerSecond), poolSize(buffers),
+          seed(randomSeed) {
+        if (size.width < 1 || size.height < 1) {
+            throw std::invalid_argument("Frame size must be positive");
+        }
+        if (CV_MAT_CN(type) > 4) {
+            throw std::invalid_argument("Synthetic frames have 1 to 4 channels");
+        }
+        if (fps < 0.0) {
+            throw std::invalid_argument("Frame rate cannot be negative");
+        }
+        if (poolSize < 1) {
+            throw std::invalid_argument("At least one frame buffer is needed");
+        }
+        reset();
+    }
+
+    /**
+     * @brief Render the pool again and restart from the first frame
+     */
+    void reset() {
+        rng = cv::RNG(seed);
+        pool.clear();
+        dirty.assign(poolSize, std::vector<cv::Rect>());
+        shapes.clear();
+        background.release();
+        strip.release();
+        frameIndex = 0;
+
+        switch (content) {
+            case SyntheticContent::Noise:
+                for (size_t i = 0; i < poolSize; ++i) {
+                    cv::Mat rendered(size, CV_8UC(CV_MAT_CN(type)));
+                    rng.fill(rendered, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+                    pool.push_back(toSourceType(rendered));
+                }
+                break;
+
+            case SyntheticContent::Gradient:
+                // One ramp period wider than a frame; frame n starts n * 4 pixels further
+                strip = toSourceType(renderGradient(size.width + GRADIENT_PERIOD, size.height, GRADIENT_PERIOD));
+                break;
+
+            case SyntheticContent::MovingShapes:
+            case SyntheticContent::StaticScene: {
+                background = toSourceType(renderGradient(size.width, size.height, 64));
+                int shortSide = std::min(size.width, size.height);
+                if (content == SyntheticContent::MovingShapes) {
+                    addShapes(8, std::max(1, shortSide / 40), std::max(1, shortSide / 10),
+                              std::max(1.0, shortSide / 100.0));
+                } else {
+                    // Fixed shapes painted into the background; only a small square moves, about a pixel per frame
+                    addShapes(6, std::max(1, shortSide / 20), std::max(1, shortSide / 8), 0.0);
+                    pool.assign(1, background);
+                    drawShapes(0);
+                    shapes.clear();
+                    dirty.assign(poolSize, std::vector<cv::Rect>());
+                    addShapes(1, std::max(1, shortSide / 100), std::max(1, shortSide / 100), 0.0);
+                    shapes[0].velocity = cv::Point2d(1.0, 0.5);
+                    shapes[0].circle = false;
+                }
+                pool.clear();
+                for (size_t i = 0; i < poolSize; ++i) {
+                    cv::Mat frame;
+                    frame.allocator = allocator;
+                    background.copyTo(frame);
+                    pool.push_back(frame);
+                }
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief Get the next frame, at its time when a frame rate is set
+     * @return A new frame, independent of the source
+     */
+    cv::Mat getImage() override {
+        cv::Mat frame;
+        frame.allocator = allocator;
+        renderInto(frame);
+        return frame;
+    }
+
+    /**
+     * @brief Write the next frame into a buffer, at its time when a frame rate is set
+     *
+     * Same frames as getImage(), without allocating: a buffer of the frame
+     * size and type (e.g. a shared-memory slot) is written in place.
+     * @param frame Destination, (re)allocated if its size or type differs
+     */
+    void renderInto(cv::Mat& frame) {
+        next().copyTo(frame);
+    }
+
+private:
+    /**
+     * @brief Advance to the next frame
+     * @return The pool buffer or strip view holding it (owned by the source)
+     */
+    cv::Mat next() {
+        if (fps > 0.0) {
+            if (frameIndex == 0) {
+                start = std::chrono::steady_clock::now();
+            }
+            std::this_thread::sleep_until(start + std::chrono::microseconds(
+                                                      static_cast<int64_t>(frameIndex * 1e6 / fps)));
+        }
+        size_t n = frameIndex++;
+
+        switch (content) {
+            case SyntheticContent::Noise:
+                return pool[n % poolSize];
+
+            case SyntheticContent::Gradient: {
+                int offset = static_cast<int>((n * 4) % GRADIENT_PERIOD);
+                return strip(cv::Rect(offset, 0, size.width, size.height));
+            }
+
+            default: {
+                size_t slot = n % poolSize;
+                if (n > 0) {
+                    moveShapes();
+                }
+                drawShapes(slot);
+                return pool[slot];
+            }
+        }
+    }
+
+public:
+    /**
+     * @brief Get the number of frames produced since the last reset()
+     * @return Frame count
+     */
+    size_t getFrameCount() const {
+        return frameIndex;
+    }
+
+    bool isAvailable() const override {
+        return true;
+    }
+
+    std::string getDescription() const override {
+        static const char* names[] = {"noise", "gradient", "moving shapes", "static scene"};
+        std::string description = "Synthetic: " + std::string(names[static_cast<int>(content)]) + " " +
+                                  std::to_string(size.width) + "x" + std::to_string(size.height) + ", " +
+                                  std::to_string(CV_MAT_CN(type)) + " channel(s)";
+        if (fps > 0.0) {
+            description += ", " + std::to_string(static_cast<int>(fps + 0.5)) + " fps";
+        }
+        return description;
+    }
+};
+
+#endif // SYNTHETIC_IMAGE_SOURCE_H
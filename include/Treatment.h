@@ -2,11 +2,54 @@
 #define TREATMENT_H
 
 #include <opencv2/opencv.hpp>
+#include <cmath>
 #include <string>
 #include <map>
+#include <algorithm>
 #include <memory>
 #include <vector>
 
+/**
+ * @brief Size and type of the images a treatment receives or returns
+ */
+struct ImageFormat {
+    cv::Size size;
+    int type = CV_8UC3;  // cv::Mat type (depth and channels)
+
+    bool operator==(const ImageFormat& other) const {
+        return size == other.size && type == other.type;
+    }
+    bool operator!=(const ImageFormat& other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * @brief Formats a treatment accepts and how it uses the channels
+ *
+ * Used by validateInput() and by FormatPlanner to decide where a chain
+ * needs a color conversion.
+ */
+struct FormatTraits {
+    std::vector<int> channels = {1, 2, 3, 4};  // Accepted channel counts
+    std::vector<int> depths;                   // Accepted depths (CV_8U...), empty for any
+    bool lumaOnly = false;  // Only the luma is used: a color input is converted to gray first
+    bool linear = false;    // Same linear filter on every channel, so it commutes with
+                            // the (linear) gray conversion up to rounding
+
+    /**
+     * @brief Check whether an image type is accepted
+     * @param type cv::Mat type
+     * @return true if both its channel count and its depth are accepted
+     */
+    bool accepts(int type) const {
+        bool channelOk = std::find(channels.begin(), channels.end(), CV_MAT_CN(type)) != channels.end();
+        bool depthOk = depths.empty() ||
+                       std::find(depths.begin(), depths.end(), CV_MAT_DEPTH(type)) != depths.end();
+        return channelOk && depthOk;
+    }
+};
+
 /**
  * @brief Base class for all image treatments
  * 
@@ -24,6 +67,38 @@ public:
      */
     virtual cv::Mat process(const cv::Mat& input) = 0;
 
+    /**
+     * @brief Process an input image into a given output
+     *
+     * When output already has the size and type of the result it is filled
+     * in place, so a caller owning the destination (a shared-memory slot, a
+     * display buffer) saves a copy; otherwise it is reallocated. The default
+     * stores the result of process(): treatments writing with OpenCV
+     * functions override it to write into output directly.
+     *
+     * @param input The input image
+     * @param output The output image (must not overlap input)
+     */
+    virtual void processInto(const cv::Mat& input, cv::Mat& output) {
+        storeResult(process(input), output);
+    }
+
+    /**
+     * @brief Store a result into an output, keeping the output buffer when it fits
+     * @param result The result image
+     * @param output Copied into when it has the result size and type, else rebound to result
+     */
+    static void storeResult(const cv::Mat& result, cv::Mat& output) {
+        if (result.data == output.data && result.size() == output.size() && result.type() == output.type()) {
+            return;
+        }
+        if (!output.empty() && result.size() == output.size() && result.type() == output.type()) {
+            result.copyTo(output);
+        } else {
+            output = result;
+        }
+    }
+
     /**
      * @brief Get the name of this treatment
      * @return Treatment name as string
@@ -42,6 +117,27 @@ public:
      */
     virtual std::map<std::string, std::string> getParameters() const = 0;
 
+    /**
+     * @brief Get the numeric parameters with their exact values
+     *
+     * getParameters() formats floating-point values with 6 decimals, so two
+     * treatments can print the same strings with different settings; use this
+     * to compare them. The default parses getParameters(), which is exact for
+     * integer and boolean parameters: treatments holding a double override it.
+     * @return Map of parameter names to their current values
+     */
+    virtual std::map<std::string, double> getParameterValues() const {
+        std::map<std::string, double> values;
+        for (const auto& param : getParameters()) {
+            try {
+                values[param.first] = std::stod(param.second);
+            } catch (const std::exception&) {
+                // Not numeric: getParameters() already holds the exact value
+            }
+        }
+        return values;
+    }
+
     /**
      * @brief Set a parameter value
      * @param paramName The parameter name
@@ -62,13 +158,106 @@ public:
      */
     virtual std::unique_ptr<Treatment> clone() const = 0;
 
+    /**
+     * @brief Clone this treatment for an image downscaled by a factor
+     *
+     * Spatial parameters (kernel sizes, sigmas, block sizes) are scaled so
+     * that processing the downscaled image looks like the full-resolution
+     * result downscaled. Used to preview a chain on a small proxy
+     * (TreatmentChain::makeProxy()); pointwise treatments keep clone().
+     *
+     * @param scale Size of the proxy relative to the full image (0 < scale <= 1)
+     * @return A unique_ptr to the scaled copy
+     */
+    virtual std::unique_ptr<Treatment> cloneScaled(double scale) const {
+        return clone();
+    }
+
+    /**
+     * @brief Scale a kernel size, keeping odd sizes odd (centered kernels)
+     * @param size Kernel size at full resolution
+     * @param scale Scale factor
+     * @return Scaled size, at least 1
+     */
+    static int scaleKernelSize(int size, double scale) {
+        if (size % 2 == 1) {
+            return std::max(1, 2 * static_cast<int>(std::lround((size * scale - 1.0) / 2.0)) + 1);
+        }
+        return std::max(1, static_cast<int>(std::lround(size * scale)));
+    }
+
+    /**
+     * @brief Precompute what process() needs for a given input format
+     *
+     * Kernels, lookup tables, structuring elements and scratch buffers that
+     * depend only on the parameters and the frame format are built here, so
+     * process() is a pure hot loop. TreatmentChain calls it before each frame:
+     * it must return immediately when nothing changed since the last call
+     * (setParameter() drops what a new value invalidates). process() prepares
+     * lazily too, so calling it is never required, only earlier.
+     *
+     * @param inputSize Size of the images process() will receive
+     * @param inputType Type of those images (e.g. CV_8UC3)
+     * @return Format of the images process() will return
+     */
+    virtual ImageFormat prepare(const cv::Size& inputSize, int inputType) {
+        return {inputSize, inputType};
+    }
+
+    /**
+     * @brief Get the formats the treatment accepts
+     * @return Accepted channel counts and depths, and how the channels are used
+     */
+    virtual FormatTraits getFormatTraits() const {
+        return FormatTraits();
+    }
+
     /**
      * @brief Check if the treatment can process the given input
      * @param input The input image
-     * @return true if input is valid, false otherwise
+     * @return true if input is non-empty and its format is accepted, false otherwise
      */
     virtual bool validateInput(const cv::Mat& input) const {
-        return !input.empty();
+        return !input.empty() && getFormatTraits().accepts(input.type());
+    }
+
+    /**
+     * @brief Check whether the result depends on the previous frames
+     *
+     * A stateful treatment (temporal smoothing, background model...) must see
+     * the frames of a stream in order: FrameParallelExecutor runs it, and the
+     * treatments after it, on a single ordered lane instead of its workers.
+     *
+     * @return true if process() keeps state from one frame to the next
+     */
+    virtual bool isStateful() const {
+        return false;
+    }
+
+    /**
+     * @brief Get the neighbourhood radius read around each output pixel
+     * @return Radius in pixels (0 = pointwise), or -1 if an output pixel
+     *         may depend on the whole image
+     */
+    virtual int getBorderRadius() const {
+        return 0;
+    }
+
+    /**
+     * @brief Get the input region needed to compute an output region exactly
+     * @param outputRegion Region of the output image that must be correct
+     * @param imageSize Size of the full input image
+     * @return Input region (clipped to the image) to feed the treatment with
+     */
+    virtual cv::Rect getInputRegion(const cv::Rect& outputRegion, const cv::Size& imageSize) const {
+        cv::Rect full(0, 0, imageSize.width, imageSize.height);
+        int radius = getBorderRadius();
+        if (radius < 0) {
+            return full;
+        }
+        cv::Rect region(outputRegion.x - radius, outputRegion.y - radius,
+                        outputRegion.width + 2 * radius, outputRegion.height + 2 * radius);
+        return region & full;
     }
 };
 
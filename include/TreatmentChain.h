@@ -2,21 +2,312 @@
 #define TREATMENT_CHAIN_H
 
 #include "Treatment.h"
+#include "BandIO.h"
+#include "MemoryBudget.h"
+#include "treatments/GrayscaleTreatment.h"
+#include "treatments/GaussianBlurTreatment.h"
+#include "treatments/CannyEdgeTreatment.h"
+#include "kernels/FusedCanny.h"
+#include "kernels/OutputBuffer.h"
+#include <algorithm>
+#include <limits>
 #include <vector>
 #include <memory>
 #include <stdexcept>
 
+/**
+ * @brief How processChain() ran the last image within its memory budget
+ */
+enum class ChainExecution {
+    Recorded,  // Whole image, intermediate results recorded
+    Streamed,  // Whole image, intermediate results dropped
+    Tiled      // Horizontal bands written into the output, intermediate results dropped
+};
+
 /**
  * @brief Manages a chain of image treatments
  * 
  * This class maintains an ordered list of treatments and processes
  * an image through all of them sequentially.
+ * 
+ * When intermediate results are not recorded (and for region processing),
+ * known stage patterns are replaced by fused kernels: Grayscale followed by
+ * Gaussian Blur and Canny Edge Detection runs as one sweep.
+ * 
+ * With a memory budget (setMemoryBudget(), MemoryAccount::setProcessBudget()),
+ * processChain() estimates its working set from the frame formats and
+ * degrades instead of exhausting memory: it drops the intermediate results,
+ * then processes the image in bands, and otherwise throws
+ * MemoryBudgetExceeded before allocating anything.
  */
 class TreatmentChain {
 private:
     std::vector<std::unique_ptr<Treatment>> treatments;
     cv::Mat originalImage;
     std::vector<cv::Mat> intermediateResults;
+    bool recordIntermediates = true;
+    cv::MatAllocator* allocator = nullptr;  // Allocator of the recorded copies
+    size_t memoryBudget = 0;                // Bytes one call may use (0 = no limit)
+    MemoryReservation recordedReservation;  // Process-wide account of the recorded copies
+    MemoryUsage memoryUsage;                // Recorded bytes held, peak of the last call
+    ChainExecution lastExecution = ChainExecution::Recorded;
+
+    static constexpr int MIN_TILE_ROWS = 16;
+
+    static size_t imageBytes(const ImageFormat& format) {
+        return static_cast<size_t>(format.size.area()) * CV_ELEM_SIZE(format.type);
+    }
+
+    static size_t imageBytes(const cv::Mat& image) {
+        return image.total() * image.elemSize();
+    }
+
+    /**
+     * @brief Prepare every treatment and collect the format entering each one, then the output format
+     */
+    std::vector<ImageFormat> prepareStages(const cv::Size& inputSize, int inputType) {
+        std::vector<ImageFormat> formats{{inputSize, inputType}};
+        for (const auto& treatment : treatments) {
+            ImageFormat format = formats.back();
+            formats.push_back(treatment->prepare(format.size, format.type));
+        }
+        return formats;
+    }
+
+    /**
+     * @brief Largest input + output of a single stage, in bytes per row (all stages keep the width)
+     */
+    static size_t stagePairRowBytes(const std::vector<ImageFormat>& formats) {
+        size_t pair = 0;
+        for (size_t i = 1; i < formats.size(); ++i) {
+            pair = std::max(pair, static_cast<size_t>(formats[i - 1].size.width) * CV_ELEM_SIZE(formats[i - 1].type) +
+                                  static_cast<size_t>(formats[i].size.width) * CV_ELEM_SIZE(formats[i].type));
+        }
+        return pair;
+    }
+
+    /**
+     * @brief Largest input + output of a single stage over whole images
+     */
+    static size_t stagePairBytes(const std::vector<ImageFormat>& formats) {
+        size_t pair = imageBytes(formats.front());
+        for (size_t i = 1; i < formats.size(); ++i) {
+            pair = std::max(pair, imageBytes(formats[i - 1]) + imageBytes(formats[i]));
+        }
+        return pair;
+    }
+
+    /**
+     * @brief Output rows per band that fit a byte budget
+     * @param formats Formats from prepareStages()
+     * @param extraBytes Bytes held during the whole run besides the bands (e.g. the output)
+     * @param available Budget for extraBytes and one band through the largest stage
+     * @param required Set to the bytes needed with the smallest band
+     * @return Rows per band (at most the image height), 0 if nothing fits or the chain cannot run in bands
+     */
+    size_t bandRowsWithin(const std::vector<ImageFormat>& formats, size_t extraBytes,
+                          size_t available, size_t& required) const {
+        int halo = tileHalo(formats);
+        required = stagePairBytes(formats) + extraBytes;
+        if (halo < 0 || treatments.empty()) {
+            return 0;
+        }
+        size_t rowBytes = stagePairRowBytes(formats);
+        size_t haloRows = 2 * static_cast<size_t>(halo);
+        required = extraBytes + (MIN_TILE_ROWS + haloRows) * rowBytes;
+        if (required > available) {
+            return 0;
+        }
+        size_t rows = (available - extraBytes) / rowBytes - haloRows;
+        return std::min(rows, static_cast<size_t>(formats.front().size.height));
+    }
+
+    /**
+     * @brief Total radius of the chain, or -1 if it cannot run in bands
+     */
+    int tileHalo(const std::vector<ImageFormat>& formats) const {
+        int halo = 0;
+        for (size_t i = 0; i < treatments.size(); ++i) {
+            int radius = treatments[i]->getBorderRadius();
+            if (radius < 0 || formats[i + 1].size != formats[0].size) {
+                return -1;
+            }
+            halo += radius;
+        }
+        return halo;
+    }
+
+    /**
+     * @brief Deep copy of an image, allocated with the chain's allocator
+     */
+    cv::Mat copyOf(const cv::Mat& image) const {
+        cv::Mat copy;
+        copy.allocator = allocator;
+        image.copyTo(copy);
+        return copy;
+    }
+
+    /**
+     * @brief Run Grayscale -> Gaussian Blur -> Canny Edge Detection as one fused sweep
+     * @param index Index of the Grayscale stage
+     * @param input Input of that stage
+     * @param output Edge map, if the fused kernel ran
+     * @return true if the three stages starting at index were fused
+     */
+    bool runFusedEdges(size_t index, const cv::Mat& input, cv::Mat& output) const {
+        if (index + 3 > treatments.size() ||
+            dynamic_cast<const GrayscaleTreatment*>(treatments[index].get()) == nullptr) {
+            return false;
+        }
+        const auto* blur = dynamic_cast<const GaussianBlurTreatment*>(treatments[index + 1].get());
+        const auto* canny = dynamic_cast<const CannyEdgeTreatment*>(treatments[index + 2].get());
+        if (blur == nullptr || canny == nullptr || !blur->isFixedPoint() || canny->getApertureSize() != 3) {
+            return false;
+        }
+        return kernels::fusedGrayBlurCanny(input, output, blur->getKernelSize(), blur->getSigmaX(),
+                                           blur->getSigmaY(), canny->getThreshold1(), canny->getThreshold2());
+    }
+
+    /**
+     * @brief Output given to a step of the chain
+     * @param end Index after the last stage of the step
+     * @param into Output of the whole chain, or nullptr
+     * @return *into when the step ends the chain, else an empty image
+     */
+    cv::Mat lastStageOutput(size_t end, const cv::Mat* into) const {
+        return into != nullptr && end == treatments.size() ? *into : cv::Mat();
+    }
+
+    /**
+     * @brief Run an image through every treatment without recording intermediates
+     * @param input The input image
+     * @param keepSize Throw if a treatment changes the image size (region processing)
+     * @param peak If not null, raised to the largest input + output bytes of a stage
+     * @param into If not null, output the last stage writes into (see processChain())
+     * @return The final processed image
+     */
+    cv::Mat runTreatments(const cv::Mat& input, bool keepSize, size_t* peak = nullptr,
+                          const cv::Mat* into = nullptr) const {
+        cv::Mat current = input;
+        for (size_t i = 0; i < treatments.size(); ++i) {
+            cv::Mat next = lastStageOutput(i + 3, into);
+            const size_t first = i;  // First stage of this step (the fused kernel runs three)
+            if (runFusedEdges(i, current, next)) {
+                i += 2;
+            } else {
+                if (!treatments[i]->validateInput(current)) {
+                    throw std::runtime_error("Treatment " + std::to_string(i) + 
+                                           " cannot process the current image");
+                }
+                next = lastStageOutput(i + 1, into);
+                treatments[i]->processInto(current, next);
+            }
+            if (keepSize && next.size() != current.size()) {
+                throw std::runtime_error("Treatment " + std::to_string(first) +
+                                       " changes the image size; region processing is not supported");
+            }
+            if (peak != nullptr) {
+                *peak = std::max(*peak, imageBytes(current) + imageBytes(next));
+            }
+            current = next;
+        }
+        return current;
+    }
+
+    /**
+     * @brief Run an image through the chain in horizontal bands written into one output
+     * @param input The input image
+     * @param bandRows Output rows per band
+     * @param outputType Type of the chain output
+     * @param peak Raised to the output bytes plus the largest band working set
+     * @param into Output to write the bands into when it has the chain output format
+     * @return The final processed image, identical to a whole-image run
+     */
+    cv::Mat runTiled(const cv::Mat& input, int bandRows, int outputType, size_t& peak,
+                     const cv::Mat& into) const {
+        cv::Mat output = kernels::outputBuffer(input, into, input.size(), outputType);
+        for (int y = 0; y < input.rows; y += bandRows) {
+            cv::Rect band(0, y, input.cols, std::min(bandRows, input.rows - y));
+            cv::Rect required = getRequiredRegion(band, input.size());
+            size_t bandPeak = 0;
+            cv::Mat processed = runTreatments(input(required), true, &bandPeak);
+            cv::Rect local(band.x - required.x, band.y - required.y, band.width, band.height);
+            processed(local).copyTo(output(band));
+            peak = std::max(peak, imageBytes(output) + bandPeak);
+        }
+        return output;
+    }
+
+    /**
+     * @brief Run the chain within the memory budget, the last stage writing into output when it fits
+     */
+    cv::Mat runChain(const cv::Mat& input, const cv::Mat& output) {
+        if (input.empty()) {
+            throw std::invalid_argument("Input image is empty");
+        }
+        std::vector<ImageFormat> formats = prepareStages(input.size(), input.type());
+
+        // The previous copies are dropped before this call is budgeted
+        originalImage.release();
+        intermediateResults.clear();
+        recordedReservation.release();
+        memoryUsage = MemoryUsage();
+
+        size_t limit = memoryBudget == 0 ? std::numeric_limits<size_t>::max() : memoryBudget;
+        MemoryReservation working;
+        auto fits = [&](size_t bytes) {
+            return bytes <= limit && working.tryReserve(bytes);
+        };
+
+        size_t pairBytes = stagePairBytes(formats);
+        size_t recordedBytes = 0;
+        for (const ImageFormat& format : formats) {
+            recordedBytes += imageBytes(format);
+        }
+
+        if (recordIntermediates && fits(recordedBytes + pairBytes)) {
+            lastExecution = ChainExecution::Recorded;
+            originalImage = copyOf(input);
+            intermediateResults.push_back(originalImage);
+            size_t held = imageBytes(originalImage);
+
+            cv::Mat current = input;
+            for (size_t i = 0; i < treatments.size(); ++i) {
+                if (!treatments[i]->validateInput(current)) {
+                    throw std::runtime_error("Treatment " + std::to_string(i) + 
+                                           " cannot process the current image");
+                }
+                cv::Mat next = lastStageOutput(i + 1, &output);
+                treatments[i]->processInto(current, next);
+                memoryUsage.peak = std::max(memoryUsage.peak, held + imageBytes(current) + imageBytes(next));
+                current = next;
+                intermediateResults.push_back(copyOf(current));
+                held += imageBytes(current);
+            }
+
+            working.release();
+            recordedReservation.reserve(held);
+            memoryUsage.current = held;
+            return current;
+        }
+
+        if (fits(pairBytes)) {
+            lastExecution = ChainExecution::Streamed;
+            return runTreatments(input, false, &memoryUsage.peak, &output);
+        }
+
+        // Bands: the output plus one band through the largest stage, halo included
+        size_t available = std::min(limit, MemoryAccount::available());
+        size_t outputBytes = imageBytes(formats.back());
+        size_t required = 0;
+        size_t rows = bandRowsWithin(formats, outputBytes, available, required);
+        if (rows > 0 &&
+            fits(outputBytes + (rows + 2 * static_cast<size_t>(tileHalo(formats))) * stagePairRowBytes(formats))) {
+            lastExecution = ChainExecution::Tiled;
+            return runTiled(input, static_cast<int>(rows), formats.back().type, memoryUsage.peak, output);
+        }
+        throw MemoryBudgetExceeded(required, available);
+    }
 
 public:
     /**
@@ -70,35 +361,294 @@ public:
         return treatments[index].get();
     }
 
+    /**
+     * @brief Get a treatment at a specific index (read-only)
+     * @param index Index of the treatment
+     * @return Pointer to the treatment
+     */
+    const Treatment* getTreatment(size_t index) const {
+        if (index >= treatments.size()) {
+            throw std::out_of_range("Index out of range");
+        }
+        return treatments[index].get();
+    }
+
+    /**
+     * @brief Choose whether processChain() keeps a copy of every intermediate result
+     * @param record false to skip the copies and allow fused stages (faster)
+     */
+    void setRecordIntermediates(bool record) {
+        recordIntermediates = record;
+    }
+
+    /**
+     * @brief Check whether processChain() records intermediate results
+     * @return true if intermediates are recorded (default)
+     */
+    bool isRecordingIntermediates() const {
+        return recordIntermediates;
+    }
+
+    /**
+     * @brief Allocate the recorded copies (original and intermediates) with a given allocator
+     * 
+     * Treatments allocate their outputs with OpenCV's default allocator; use
+     * FramePool::install() to pool those as well.
+     * 
+     * @param copyAllocator The allocator (e.g. a FramePool), or nullptr for OpenCV's default
+     */
+    void setAllocator(cv::MatAllocator* copyAllocator) {
+        allocator = copyAllocator;
+    }
+
+    /**
+     * @brief Prepare every treatment for a frame format
+     * 
+     * Each treatment precomputes its kernels and tables for the format the
+     * previous one produces. processChain() calls this before every frame;
+     * it only does work when the frame geometry or a parameter changed, so
+     * calling it ahead of time (e.g. before a stream starts) moves all
+     * setup out of the first frame.
+     * 
+     * @param inputSize Size of the frames the chain will receive
+     * @param inputType Type of those frames (e.g. CV_8UC3)
+     * @return Format of the frames the chain will return
+     */
+    ImageFormat prepare(const cv::Size& inputSize, int inputType) {
+        return prepareStages(inputSize, inputType).back();
+    }
+
+    /**
+     * @brief Limit the image bytes one processChain() call may hold
+     * 
+     * The working set is estimated from the frame formats: the recorded
+     * copies, plus the input and output of the largest stage. When it does
+     * not fit, the intermediate results are dropped; if that is not enough,
+     * chains whose treatments keep the image size and have a bounded
+     * neighbourhood run in horizontal bands; otherwise MemoryBudgetExceeded
+     * is thrown. The process-wide budget of MemoryAccount applies on top.
+     * 
+     * @param bytes The budget, or 0 for no limit (default)
+     */
+    void setMemoryBudget(size_t bytes) {
+        memoryBudget = bytes;
+    }
+
+    /**
+     * @brief Get the per-call memory budget
+     * @return Budget in bytes (0 = no limit)
+     */
+    size_t getMemoryBudget() const {
+        return memoryBudget;
+    }
+
+    /**
+     * @brief Get the image bytes of this chain
+     * @return Bytes of the recorded copies held now, and the peak of the last processChain()
+     */
+    MemoryUsage getMemoryUsage() const {
+        return memoryUsage;
+    }
+
+    /**
+     * @brief Get how the last processChain() ran
+     * @return Recorded, Streamed (intermediates dropped) or Tiled
+     */
+    ChainExecution getLastExecution() const {
+        return lastExecution;
+    }
+
     /**
      * @brief Process an image through the entire chain
      * @param input The input image
      * @return The final processed image
      */
     cv::Mat processChain(const cv::Mat& input) {
+        cv::Mat output;
+        processChain(input, output);
+        return output;
+    }
+
+    /**
+     * @brief Process an image through the entire chain into a given output
+     *
+     * When output already has the format prepare() returns and does not
+     * overlap input, the last stage writes into it (see
+     * Treatment::processInto()): a caller owning the destination, such as a
+     * shared-memory slot, gets the result without a copy. Otherwise output
+     * is reallocated.
+     *
+     * @param input The input image
+     * @param output The final processed image
+     */
+    void processChain(const cv::Mat& input, cv::Mat& output) {
+        cv::Mat target = kernels::overlaps(input, output) ? cv::Mat() : output;
+        Treatment::storeResult(runChain(input, target), output);
+    }
+
+    /**
+     * @brief Process an image larger than memory, band by band, from a reader to a writer
+     * 
+     * Each output band is computed from the input rows it needs (the band plus
+     * the border each treatment reads, see getRequiredRegion()) and written
+     * before the next one is read, so the result is identical to
+     * processChain() on the whole image while memory stays bounded by the
+     * band height times the width times the two largest adjacent stage
+     * formats. Treatments must keep the image size and have a bounded
+     * neighbourhood (Canny and Mosaic need the whole image). With a memory
+     * budget, the band height is lowered to fit it.
+     * 
+     * @param reader Source of the input rows
+     * @param writer Destination of the output rows (opened and closed here)
+     * @param bandRows Output rows per band
+     * @return Format of the written image
+     */
+    ImageFormat processBands(BandReader& reader, BandWriter& writer, int bandRows = 256) {
+        if (bandRows < 1) {
+            throw std::invalid_argument("Band height must be positive");
+        }
+        const cv::Size size = reader.getSize();
+        std::vector<ImageFormat> formats = prepareStages(size, reader.getType());
+        const int halo = tileHalo(formats);
+        if (halo < 0) {
+            throw std::invalid_argument("The chain cannot run in bands: a treatment changes the image size "
+                                        "or needs the whole image");
+        }
+
+        size_t limit = memoryBudget == 0 ? std::numeric_limits<size_t>::max() : memoryBudget;
+        size_t available = std::min(limit, MemoryAccount::available());
+        if (available != std::numeric_limits<size_t>::max() && !treatments.empty()) {
+            size_t required = 0;
+            size_t rows = bandRowsWithin(formats, 0, available, required);
+            if (rows == 0) {
+                throw MemoryBudgetExceeded(required, available);
+            }
+            bandRows = static_cast<int>(std::min(static_cast<size_t>(bandRows), rows));
+        }
+        size_t rowBytes = std::max(stagePairRowBytes(formats), static_cast<size_t>(size.width) *
+                                                               CV_ELEM_SIZE(formats.front().type));
+        size_t bandBytes = (static_cast<size_t>(bandRows) + 2 * static_cast<size_t>(halo)) * rowBytes;
+        MemoryReservation working;
+        if (bandBytes > limit || !working.tryReserve(bandBytes)) {
+            throw MemoryBudgetExceeded(bandBytes, available);
+        }
+
+        originalImage.release();
+        intermediateResults.clear();
+        recordedReservation.release();
+        memoryUsage = MemoryUsage();
+        lastExecution = ChainExecution::Tiled;
+
+        writer.open(size, formats.back().type);
+        for (int y = 0; y < size.height; y += bandRows) {
+            cv::Rect band(0, y, size.width, std::min(bandRows, size.height - y));
+            cv::Rect required = getRequiredRegion(band, size);  // Full width: only rows are added
+            cv::Mat input = reader.readRows(required.y, required.height);
+            size_t bandPeak = imageBytes(input);
+            cv::Mat processed = runTreatments(input, true, &bandPeak);
+            writer.writeRows(processed.rowRange(band.y - required.y, band.y - required.y + band.height));
+            memoryUsage.peak = std::max(memoryUsage.peak, bandPeak);
+        }
+        writer.close();
+        return formats.back();
+    }
+
+    /**
+     * @brief Compute the input region the whole chain needs to produce a region exactly
+     * @param region Region of the final output that must be correct
+     * @param imageSize Size of the input image
+     * @return Input region including the halo required by every treatment
+     */
+    cv::Rect getRequiredRegion(const cv::Rect& region, const cv::Size& imageSize) const {
+        cv::Rect required = region & cv::Rect(0, 0, imageSize.width, imageSize.height);
+        for (auto it = treatments.rbegin(); it != treatments.rend(); ++it) {
+            required = (*it)->getInputRegion(required, imageSize);
+        }
+        return required;
+    }
+
+    /**
+     * @brief Process only some regions of an image through the chain
+     * 
+     * Each region is processed together with the halo its treatments need, so
+     * the returned pixels are identical to the same area of processChain().
+     * Intermediate results are left untouched.
+     * 
+     * @param input The input image
+     * @param regions Regions of interest (clipped to the image)
+     * @return One processed crop per region, in the same order
+     */
+    std::vector<cv::Mat> processRegions(const cv::Mat& input, const std::vector<cv::Rect>& regions) const {
         if (input.empty()) {
             throw std::invalid_argument("Input image is empty");
         }
 
-        originalImage = input.clone();
-        intermediateResults.clear();
-        intermediateResults.push_back(originalImage);
+        cv::Rect full(0, 0, input.cols, input.rows);
+        cv::Mat fullResult;  // Computed once if any region needs the whole frame
+        std::vector<cv::Mat> results;
+        results.reserve(regions.size());
 
-        cv::Mat current = input;
-        for (size_t i = 0; i < treatments.size(); ++i) {
-            if (!treatments[i]->validateInput(current)) {
-                throw std::runtime_error("Treatment " + std::to_string(i) + 
-                                       " cannot process the current image");
+        for (const cv::Rect& requested : regions) {
+            cv::Rect region = requested & full;
+            if (region.empty()) {
+                throw std::invalid_argument("Region lies outside the image");
+            }
+
+            cv::Rect required = getRequiredRegion(region, input.size());
+            if (required == full) {
+                if (fullResult.empty()) {
+                    fullResult = runTreatments(input, true);
+                }
+                results.push_back(fullResult(region));
+            } else {
+                cv::Mat processed = runTreatments(input(required), true);
+                cv::Rect local(region.x - required.x, region.y - required.y,
+                               region.width, region.height);
+                results.push_back(processed(local));
             }
-            current = treatments[i]->process(current);
-            intermediateResults.push_back(current.clone());
         }
 
-        return current;
+        return results;
+    }
+
+    /**
+     * @brief Process some regions of an image and paste them back into a full frame
+     * @param input The input image
+     * @param regions Regions of interest (clipped to the image)
+     * @return Copy of the input where only the regions hold processed pixels
+     */
+    cv::Mat processChainInRegions(const cv::Mat& input, const std::vector<cv::Rect>& regions) const {
+        std::vector<cv::Mat> crops = processRegions(input, regions);
+        cv::Mat output = copyOf(input);
+        cv::Rect full(0, 0, input.cols, input.rows);
+
+        for (size_t i = 0; i < crops.size(); ++i) {
+            cv::Mat crop = crops[i];
+            if (crop.channels() != output.channels()) {
+                if (crop.channels() == 1 && output.channels() == 3) {
+                    cv::cvtColor(crop, crop, cv::COLOR_GRAY2BGR);
+                } else if (crop.channels() == 1 && output.channels() == 4) {
+                    cv::cvtColor(crop, crop, cv::COLOR_GRAY2BGRA);
+                } else {
+                    throw std::runtime_error("Cannot paste a " + std::to_string(crop.channels()) +
+                                           "-channel result into a " + std::to_string(output.channels()) +
+                                           "-channel frame");
+                }
+            }
+            if (crop.depth() != output.depth()) {
+                crop.convertTo(crop, output.type());
+            }
+            crop.copyTo(output(regions[i] & full));
+        }
+
+        return output;
     }
 
     /**
      * @brief Get the intermediate result after a specific treatment
+     * 
+     * Only available when intermediates are recorded (see setRecordIntermediates()).
+     * 
      * @param index Index of the treatment (0 = original, 1 = after first treatment, etc.)
      * @return The intermediate image
      */
@@ -114,7 +664,35 @@ public:
      */
     void clear() {
         treatments.clear();
+        originalImage.release();
         intermediateResults.clear();
+        recordedReservation.release();
+        memoryUsage.current = 0;
+    }
+
+    /**
+     * @brief Copy the chain to preview it on a downscaled proxy of the image
+     *
+     * Every treatment is copied with Treatment::cloneScaled(), so running the
+     * copy on an image scale times smaller gives about the full-resolution
+     * result shrunk to that size, at a fraction of the cost. Run this chain
+     * on the full image only to commit the result.
+     *
+     * @param scale Size of the proxy relative to the full image (0 < scale <= 1)
+     * @return The proxy chain, with the same recording, allocator and budget settings
+     */
+    TreatmentChain makeProxy(double scale) const {
+        if (!(scale > 0.0 && scale <= 1.0)) {
+            throw std::invalid_argument("Proxy scale must be in (0, 1]");
+        }
+        TreatmentChain proxy;
+        for (const auto& treatment : treatments) {
+            proxy.addTreatment(treatment->cloneScaled(scale));
+        }
+        proxy.setRecordIntermediates(recordIntermediates);
+        proxy.setAllocator(allocator);
+        proxy.setMemoryBudget(memoryBudget);
+        return proxy;
     }
 
     /**
@@ -0,0 +1,419 @@
+#ifndef VIDEO_IO_H
+#define VIDEO_IO_H
+
+#include "BoundedQueue.h"
+#include "ImageSource.h"
+#include "TreatmentChain.h"
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+/**
+ * @brief A video frame with its position in the stream
+ */
+struct TimedFrame {
+    cv::Mat image;
+    int64_t index = -1;        // Frame number, from 0
+    double timestampMs = 0.0;  // Presentation time
+};
+
+/**
+ * @brief Image source decoding a video file on its own thread
+ *
+ * A decoder thread reads ahead into a bounded queue (queueSize frames), so
+ * decoding the next frames overlaps with processing the current one, and
+ * stops when the queue is full. Frames come out in file order with their
+ * index and timestamp; getImage() returns an empty Mat at the end.
+ */
+class VideoFileImageSource : public ImageSource {
+private:
+    std::string filepath;
+    cv::VideoCapture capture;
+    bool opened;
+    double fps;
+    cv::Size frameSize;
+    int64_t frameCount;
+
+    BoundedQueue<TimedFrame> queue;
+    std::thread decoder;
+    std::exception_ptr error;
+
+    void decode() {
+        try {
+            for (int64_t index = 0;; ++index) {
+                TimedFrame frame;
+                frame.image.allocator = allocator;
+                if (!capture.read(frame.image) || frame.image.empty()) {
+                    break;
+                }
+                frame.index = index;
+                frame.timestampMs = capture.get(cv::CAP_PROP_POS_MSEC);
+                if (frame.timestampMs <= 0.0 && index > 0 && fps > 0.0) {
+                    frame.timestampMs = index * 1000.0 / fps;  // Backend without timestamps
+                }
+                if (!queue.push(std::move(frame))) {
+                    break;  // Source destroyed
+                }
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        queue.close();
+    }
+
+public:
+    /**
+     * @brief Open a video file
+     * @param path Path of the file
+     * @param queueSize Decoded frames held ahead of the consumer
+     */
+    explicit VideoFileImageSource(const std::string& path, size_t queueSize = 8)
+        : filepath(path), capture(path), queue(queueSize) {
+        opened = capture.isOpened();
+        fps = opened ? capture.get(cv::CAP_PROP_FPS) : 0.0;
+        frameSize = opened ? cv::Size(static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH)),
+                                      static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT)))
+                           : cv::Size();
+        frameCount = opened ? static_cast<int64_t>(capture.get(cv::CAP_PROP_FRAME_COUNT)) : 0;
+    }
+
+    ~VideoFileImageSource() {
+        queue.close();
+        if (decoder.joinable()) {
+            decoder.join();
+        }
+    }
+
+    /**
+     * @brief Get the next frame with its index and timestamp
+     * @param frame Receives the frame
+     * @return false at the end of the file
+     */
+    bool getTimedFrame(TimedFrame& frame) {
+        if (!opened) {
+            return false;
+        }
+        if (!decoder.joinable()) {
+            decoder = std::thread(&VideoFileImageSource::decode, this);  // Started here so setAllocator() applies
+        }
+        if (queue.pop(frame)) {
+            return true;
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return false;
+    }
+
+    cv::Mat getImage() override {
+        TimedFrame frame;
+        return getTimedFrame(frame) ? frame.image : cv::Mat();
+    }
+
+    /**
+     * @brief Get the frame rate declared by the file
+     * @return Frames per second (0 if unknown)
+     */
+    double getFps() const {
+        return fps;
+    }
+
+    /**
+     * @brief Get the size of the frames
+     * @return Width and height
+     */
+    cv::Size getFrameSize() const {
+        return frameSize;
+    }
+
+    /**
+     * @brief Get the number of frames declared by the file (an estimate for some formats)
+     * @return Frame count
+     */
+    int64_t getFrameCount() const {
+        return frameCount;
+    }
+
+    bool isAvailable() const override {
+        return opened;
+    }
+
+    std::string getDescription() const override {
+        return "Video: " + filepath + " (" + std::to_string(frameSize.width) + "x" +
+               std::to_string(frameSize.height) + ", " + std::to_string(fps) + " fps)";
+    }
+};
+
+/**
+ * @brief Writes frames to a video file from its own encoder thread
+ *
+ * write() queues the frame (waiting only when queueSize frames are already
+ * pending) and an encoder thread writes them in order. Like
+ * AsyncImageWriter, it queues a copy so the caller can reuse its buffer
+ * right away; passing the frame with std::move() hands it over instead.
+ * The file is created with the size of the first frame; gray or non-8-bit
+ * frames (Canny, Threshold...) are converted to 8-bit BGR, which every
+ * backend accepts.
+ *
+ * The file has a constant frame rate: a frame whose timestamp is later than
+ * its slot (a source that dropped frames) is preceded by copies of the
+ * previous frame, so the output keeps the timing of the input.
+ */
+class VideoFileSink {
+private:
+    std::string filepath;
+    double fps;
+    int fourcc;
+
+    BoundedQueue<TimedFrame> queue;
+    std::thread encoder;
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};  // error is set (by the encoder thread)
+    cv::VideoWriter writer;
+    cv::Size frameSize;
+    int64_t nextIndex = 0;
+    std::atomic<size_t> framesWritten{0};
+    std::atomic<size_t> framesDuplicated{0};
+
+    static cv::Mat toBgr8(const cv::Mat& image) {
+        cv::Mat converted = image;
+        if (converted.depth() != CV_8U) {
+            converted.convertTo(converted, CV_8U);
+        }
+        if (converted.channels() == 1) {
+            cv::cvtColor(converted, converted, cv::COLOR_GRAY2BGR);
+        } else if (converted.channels() == 4) {
+            cv::cvtColor(converted, converted, cv::COLOR_BGRA2BGR);
+        }
+        return converted;
+    }
+
+    void encode() {
+        try {
+            TimedFrame frame;
+            cv::Mat previous;
+            double firstTimestampMs = 0.0;
+            while (queue.pop(frame)) {
+                if (!writer.isOpened()) {
+                    frameSize = frame.image.size();
+                    firstTimestampMs = frame.timestampMs;
+                    if (!writer.open(filepath, fourcc, fps, frameSize, true)) {
+                        throw std::runtime_error("Cannot create " + filepath);
+                    }
+                } else if (frame.image.size() != frameSize) {
+                    throw std::runtime_error("Frame " + std::to_string(frame.index) + " does not have the size of the video");
+                }
+                cv::Mat image = toBgr8(frame.image);
+
+                // Slot of this frame at the output rate
+                size_t slot = static_cast<size_t>(std::llround((frame.timestampMs - firstTimestampMs) * fps / 1000.0));
+                while (!previous.empty() && framesWritten < slot) {
+                    writer.write(previous);
+                    ++framesWritten;
+                    ++framesDuplicated;
+                }
+                writer.write(image);
+                ++framesWritten;
+                previous = image;
+            }
+        } catch (...) {
+            error = std::current_exception();
+            failed = true;
+            queue.close();  // Unblock write()
+        }
+    }
+
+public:
+    /**
+     * @brief Prepare a video file
+     * @param path Path of the file to write (replaced)
+     * @param framesPerSecond Frame rate of the file (usually VideoFileImageSource::getFps())
+     * @param codec FourCC of the codec (default MJPG, available in every OpenCV build with .avi files)
+     * @param queueSize Frames waiting for the encoder at most
+     */
+    VideoFileSink(const std::string& path, double framesPerSecond,
+                  int codec = cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), size_t queueSize = 8)
+        : filepath(path), fps(framesPerSecond), fourcc(codec), queue(queueSize) {
+        if (fps <= 0.0) {
+            throw std::invalid_argument("Frame rate must be positive");
+        }
+    }
+
+    VideoFileSink(const VideoFileSink&) = delete;
+    VideoFileSink& operator=(const VideoFileSink&) = delete;
+
+    ~VideoFileSink() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    /**
+     * @brief Queue a copy of a frame; frames must be written in index order
+     * @param frame The frame, its index and timestamp (copied: the caller keeps it)
+     */
+    void write(const TimedFrame& frame) {
+        TimedFrame copy = frame;
+        copy.image = frame.image.clone();
+        write(std::move(copy));
+    }
+
+    /**
+     * @brief Queue a frame without copying it; frames must be written in index order
+     * @param frame The frame, handed over: nothing may write to its pixels afterwards
+     */
+    void write(TimedFrame&& frame) {
+        if (failed) {
+            std::rethrow_exception(error);
+        }
+        if (frame.image.empty()) {
+            throw std::invalid_argument("Cannot write an empty frame");
+        }
+        if (frame.index >= 0 && frame.index < nextIndex) {
+            throw std::invalid_argument("Frame " + std::to_string(frame.index) + " written after frame " +
+                                        std::to_string(nextIndex - 1));
+        }
+        nextIndex = frame.index >= 0 ? frame.index + 1 : nextIndex + 1;
+        if (!encoder.joinable()) {
+            encoder = std::thread(&VideoFileSink::encode, this);
+        }
+        if (!queue.push(std::move(frame))) {
+            if (failed) {
+                std::rethrow_exception(error);
+            }
+            throw std::runtime_error(filepath + " is closed");
+        }
+    }
+
+    /**
+     * @brief Queue a copy of an image as the next frame, at the file rate
+     * @param image The frame (copied: the caller keeps it)
+     */
+    void write(const cv::Mat& image) {
+        write(image.clone());
+    }
+
+    /**
+     * @brief Queue an image as the next frame, at the file rate, without copying it
+     * @param image The frame, handed over: nothing may write to its pixels afterwards
+     */
+    void write(cv::Mat&& image) {
+        TimedFrame frame;
+        frame.image = std::move(image);
+        frame.index = nextIndex;
+        frame.timestampMs = nextIndex * 1000.0 / fps;
+        write(std::move(frame));
+    }
+
+    /**
+     * @brief Write the pending frames and close the file (done by the destructor too)
+     */
+    void close() {
+        queue.close();
+        if (encoder.joinable()) {
+            encoder.join();
+        }
+        if (writer.isOpened()) {
+            writer.release();
+        }
+        if (failed) {
+            failed = false;
+            std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * @brief Get the number of frames in the file so far
+     * @return Frames written, duplicates included
+     */
+    size_t getFramesWritten() const {
+        return framesWritten;
+    }
+
+    /**
+     * @brief Get the number of copies written to fill timestamp gaps
+     * @return Duplicated frame count
+     */
+    size_t getFramesDuplicated() const {
+        return framesDuplicated;
+    }
+};
+
+/**
+ * @brief Timing of a VideoPipeline::run()
+ */
+struct VideoPipelineStats {
+    size_t frames = 0;          // Frames processed
+    double seconds = 0.0;       // From the first decoded frame to the closed file
+    double decodeWaitMs = 0.0;  // Time the processing thread waited for the decoder
+    double processMs = 0.0;     // Time spent in the chain
+    double encodeWaitMs = 0.0;  // Time the processing thread waited for room in the encoder queue
+
+    /**
+     * @brief End-to-end throughput
+     * @return Frames per second
+     */
+    double fps() const {
+        return seconds > 0.0 ? frames / seconds : 0.0;
+    }
+};
+
+/**
+ * @brief Decodes, processes and encodes a video on three overlapping threads
+ *
+ * The source decodes ahead and the sink encodes behind while the calling
+ * thread runs the chain, so the throughput is that of the slowest of the
+ * three stages rather than their sum. The wait times in the result show
+ * which stage limits it.
+ */
+class VideoPipeline {
+public:
+    /**
+     * @brief Process every frame of a video
+     * @param source The decoded video
+     * @param chain The chain applied to each frame (disable setRecordIntermediates() for speed)
+     * @param sink The output video (closed on return)
+     * @return Frame count and timings
+     */
+    static VideoPipelineStats run(VideoFileImageSource& source, TreatmentChain& chain, VideoFileSink& sink) {
+        using Clock = std::chrono::steady_clock;
+        auto elapsedMs = [](Clock::time_point from, Clock::time_point to) {
+            return std::chrono::duration<double, std::milli>(to - from).count();
+        };
+
+        VideoPipelineStats stats;
+        auto start = Clock::now();
+        TimedFrame frame;
+        for (;;) {
+            auto t0 = Clock::now();
+            if (!source.getTimedFrame(frame)) {
+                break;
+            }
+            auto t1 = Clock::now();
+            TimedFrame result;
+            result.image = chain.processChain(frame.image);
+            result.index = frame.index;
+            result.timestampMs = frame.timestampMs;
+            auto t2 = Clock::now();
+            sink.write(std::move(result));  // A new image per frame, not used afterwards
+            auto t3 = Clock::now();
+
+            stats.decodeWaitMs += elapsedMs(t0, t1);
+            stats.processMs += elapsedMs(t1, t2);
+            stats.encodeWaitMs += elapsedMs(t2, t3);
+            ++stats.frames;
+        }
+        sink.close();
+        stats.seconds = elapsedMs(start, Clock::now()) / 1000.0;
+        return stats;
+    }
+};
+
+#endif // VIDEO_IO_H
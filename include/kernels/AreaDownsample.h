@@ -0,0 +1,166 @@
+#ifndef AREA_DOWNSAMPLE_H
+#define AREA_DOWNSAMPLE_H
+
+#include "Simd.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief Halving an image by 2x2 area averaging (one pyramid level)
+ *
+ * Each output pixel is the mean of a 2x2 block of input pixels, per channel,
+ * rounded to nearest: (a + b + c + d + 2) >> 2 for 8-bit images, as
+ * cv::resize(INTER_AREA) computes an exact halving. An odd last column or
+ * row is averaged with itself, so the output is ceil(size / 2) and covers
+ * the whole input.
+ *
+ * 8-bit rows take three passes: the two input rows are added into a 16-bit
+ * buffer (SIMD widening adds), each sum is added to the one cn lanes
+ * further and rounded back to 8 bits (SIMD, so every channel count works),
+ * and every other pixel of that is copied to the output. Output rows are
+ * independent and processed in parallel. Other depths use cv::resize().
+ */
+namespace kernels {
+
+namespace detail {
+
+/**
+ * @brief sums[i] = a[i] + b[i]
+ */
+inline void addRowsWiden(const uint8_t* a, const uint8_t* b, uint16_t* sums, int n) {
+    int i = 0;
+#if IT_SIMD_AVX2 || IT_SIMD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i <= n - 16; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i + 8), hi);
+    }
+#elif IT_SIMD_NEON
+    for (; i <= n - 16; i += 16) {
+        uint8x16_t va = vld1q_u8(a + i);
+        uint8x16_t vb = vld1q_u8(b + i);
+        vst1q_u16(sums + i, vaddl_u8(vget_low_u8(va), vget_low_u8(vb)));
+        vst1q_u16(sums + i + 8, vaddl_u8(vget_high_u8(va), vget_high_u8(vb)));
+    }
+#endif
+    for (; i < n; ++i) {
+        sums[i] = static_cast<uint16_t>(a[i] + b[i]);
+    }
+}
+
+/**
+ * @brief means[i] = (sums[i] + sums[i + cn] + 2) >> 2 for i < n
+ */
+inline void averageNeighbours(const uint16_t* sums, uint8_t* means, int n, int cn) {
+    int i = 0;
+#if IT_SIMD_AVX2 || IT_SIMD_SSE2
+    const __m128i two = _mm_set1_epi16(2);
+    for (; i <= n - 16; i += 16) {
+        __m128i lo = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + i)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + i + cn)));
+        __m128i hi = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + i + 8)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + i + 8 + cn)));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(means + i), _mm_packus_epi16(lo, hi));
+    }
+#elif IT_SIMD_NEON
+    for (; i <= n - 16; i += 16) {
+        uint16x8_t lo = vaddq_u16(vld1q_u16(sums + i), vld1q_u16(sums + i + cn));
+        uint16x8_t hi = vaddq_u16(vld1q_u16(sums + i + 8), vld1q_u16(sums + i + 8 + cn));
+        vst1q_u8(means + i, vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+    }
+#endif
+    for (; i < n; ++i) {
+        means[i] = static_cast<uint8_t>((sums[i] + sums[i + cn] + 2) >> 2);
+    }
+}
+
+/**
+ * @brief Keep the pixels at even positions: out pixel x = means pixel 2x
+ */
+template <int CN>
+inline void keepEvenPixels(const uint8_t* means, uint8_t* out, int pixels, int cn) {
+    const int channels = CN > 0 ? CN : cn;  // Fixed-size copies for 1 to 4 channels
+    for (int x = 0; x < pixels; ++x) {
+        std::memcpy(out + x * channels, means + 2 * x * channels, channels);
+    }
+}
+
+/**
+ * @brief Compute output row y of an 8-bit halving
+ * @param sums Scratch buffer of at least (src.cols + 1) * channels values
+ * @param means Scratch buffer of at least src.cols * channels values
+ */
+inline void halveRow8u(const cv::Mat& src, cv::Mat& dst, int y, std::vector<uint16_t>& sums,
+                       std::vector<uint8_t>& means) {
+    const int cn = src.channels();
+    const int n = src.cols * cn;
+    const uint8_t* row0 = src.ptr<uint8_t>(2 * y);
+    const uint8_t* row1 = src.ptr<uint8_t>(std::min(2 * y + 1, src.rows - 1));
+    uint8_t* out = dst.ptr<uint8_t>(y);
+
+    addRowsWiden(row0, row1, sums.data(), n);
+    if (src.cols % 2 != 0) {
+        std::copy(sums.begin() + n - cn, sums.begin() + n, sums.begin() + n);  // Odd column paired with itself
+    }
+    // Pairs start at even pixels: the means at odd pixels are computed and skipped
+    const int pairs = dst.cols;
+    averageNeighbours(sums.data(), means.data(), (2 * pairs - 1) * cn, cn);
+    switch (cn) {
+        case 1: keepEvenPixels<1>(means.data(), out, pairs, cn); break;
+        case 2: keepEvenPixels<2>(means.data(), out, pairs, cn); break;
+        case 3: keepEvenPixels<3>(means.data(), out, pairs, cn); break;
+        case 4: keepEvenPixels<4>(means.data(), out, pairs, cn); break;
+        default: keepEvenPixels<0>(means.data(), out, pairs, cn); break;
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Size of an image halved by halveArea()
+ * @param size Input size
+ * @return ceil(width / 2) x ceil(height / 2)
+ */
+inline cv::Size halvedSize(const cv::Size& size) {
+    return cv::Size((size.width + 1) / 2, (size.height + 1) / 2);
+}
+
+/**
+ * @brief Halve an image by 2x2 area averaging
+ * @param src The input image (any depth and number of channels; SIMD path for 8-bit)
+ * @param dst The output image of halvedSize(src.size()) (reallocated, never aliases src)
+ */
+inline void halveArea(const cv::Mat& src, cv::Mat& dst) {
+    if (src.empty()) {
+        dst = src;
+        return;
+    }
+    cv::Mat output(halvedSize(src.size()), src.type());
+    if (src.depth() != CV_8U) {
+        cv::resize(src, output, output.size(), 0, 0, cv::INTER_AREA);
+        dst = output;
+        return;
+    }
+
+    cv::parallel_for_(cv::Range(0, output.rows), [&](const cv::Range& range) {
+        std::vector<uint16_t> sums(static_cast<size_t>(src.cols + 1) * src.channels());
+        std::vector<uint8_t> means(static_cast<size_t>(src.cols) * src.channels());
+        for (int y = range.start; y < range.end; ++y) {
+            detail::halveRow8u(src, output, y, sums, means);
+        }
+    }, std::max(1, std::min(cv::getNumThreads() * 4, output.rows)));
+    dst = output;
+}
+
+} // namespace kernels
+
+#endif // AREA_DOWNSAMPLE_H
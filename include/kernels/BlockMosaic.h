@@ -0,0 +1,179 @@
+#ifndef BLOCK_MOSAIC_H
+#define BLOCK_MOSAIC_H
+
+#include "Simd.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief Pixelation by exact block averages
+ *
+ * The image is tiled with blockSize x blockSize blocks from its top-left
+ * corner (blocks on the right and bottom edges are cut to the image). Each
+ * block is replaced by the mean of its pixels, per channel, rounded to the
+ * nearest value for integer depths.
+ *
+ * One pass per block row: its rows are summed column-wise (SIMD widening
+ * adds for 8-bit images), the column sums are reduced per block, and the
+ * block values are written to the first row and copied to the others. Block
+ * rows are independent and processed in parallel; a block row is fully
+ * read before it is written, so the kernel works in place.
+ */
+namespace kernels {
+
+namespace detail {
+
+/**
+ * @brief Column sum type: exact integer sums for 8/16-bit, double otherwise
+ */
+template <typename T> struct BlockSumType { typedef double type; };
+template <> struct BlockSumType<uint8_t> { typedef uint32_t type; };
+template <> struct BlockSumType<uint16_t> { typedef uint32_t type; };
+template <> struct BlockSumType<int8_t> { typedef int32_t type; };
+template <> struct BlockSumType<int16_t> { typedef int32_t type; };
+
+/**
+ * @brief sums[i] += row[i]
+ */
+template <typename T, typename S>
+inline void accumulateRow(const T* row, S* sums, int n) {
+    for (int i = 0; i < n; ++i) {
+        sums[i] += static_cast<S>(row[i]);
+    }
+}
+
+inline void accumulateRow(const uint8_t* row, uint32_t* sums, int n) {
+    int i = 0;
+#if IT_SIMD_AVX2
+    for (; i <= n - 16; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m256i lo = _mm256_cvtepu8_epi32(v);
+        __m256i hi = _mm256_cvtepu8_epi32(_mm_srli_si128(v, 8));
+        __m256i* s = reinterpret_cast<__m256i*>(sums + i);
+        _mm256_storeu_si256(s, _mm256_add_epi32(_mm256_loadu_si256(s), lo));
+        _mm256_storeu_si256(s + 1, _mm256_add_epi32(_mm256_loadu_si256(s + 1), hi));
+    }
+#elif IT_SIMD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i <= n - 16; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        __m128i* s = reinterpret_cast<__m128i*>(sums + i);
+        _mm_storeu_si128(s, _mm_add_epi32(_mm_loadu_si128(s), _mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_si128(s + 2, _mm_add_epi32(_mm_loadu_si128(s + 2), _mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_si128(s + 3, _mm_add_epi32(_mm_loadu_si128(s + 3), _mm_unpackhi_epi16(hi, zero)));
+    }
+#elif IT_SIMD_NEON
+    for (; i <= n - 16; i += 16) {
+        uint8x16_t v = vld1q_u8(row + i);
+        uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+        uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+        vst1q_u32(sums + i, vaddw_u16(vld1q_u32(sums + i), vget_low_u16(lo)));
+        vst1q_u32(sums + i + 4, vaddw_u16(vld1q_u32(sums + i + 4), vget_high_u16(lo)));
+        vst1q_u32(sums + i + 8, vaddw_u16(vld1q_u32(sums + i + 8), vget_low_u16(hi)));
+        vst1q_u32(sums + i + 12, vaddw_u16(vld1q_u32(sums + i + 12), vget_high_u16(hi)));
+    }
+#endif
+    for (; i < n; ++i) {
+        sums[i] += row[i];
+    }
+}
+
+/**
+ * @brief Block-average the rows [y0, y1) of src into dst (dst may be src)
+ */
+template <typename T>
+inline void mosaicBlockRow(const cv::Mat& src, cv::Mat& dst, int blockSize, int y0, int y1,
+                           std::vector<typename BlockSumType<T>::type>& sums, std::vector<T>& values) {
+    typedef typename BlockSumType<T>::type S;
+    const int cols = src.cols;
+    const int cn = src.channels();
+    const int n = cols * cn;
+
+    sums.assign(n, S(0));
+    for (int y = y0; y < y1; ++y) {
+        accumulateRow(src.ptr<T>(y), sums.data(), n);
+    }
+
+    values.resize(n);
+    for (int x0 = 0; x0 < cols; x0 += blockSize) {
+        const int x1 = std::min(cols, x0 + blockSize);
+        const double count = static_cast<double>(x1 - x0) * (y1 - y0);
+        for (int ch = 0; ch < cn; ++ch) {
+            double total = 0;
+            for (int x = x0; x < x1; ++x) {
+                total += static_cast<double>(sums[x * cn + ch]);
+            }
+            T mean = cv::saturate_cast<T>(total / count);
+            for (int x = x0; x < x1; ++x) {
+                values[x * cn + ch] = mean;
+            }
+        }
+    }
+
+    for (int y = y0; y < y1; ++y) {
+        std::copy(values.begin(), values.end(), dst.ptr<T>(y));
+    }
+}
+
+template <typename T>
+inline void mosaicTyped(const cv::Mat& src, cv::Mat& dst, int blockSize) {
+    const int blockRows = (src.rows + blockSize - 1) / blockSize;
+    cv::parallel_for_(cv::Range(0, blockRows), [&](const cv::Range& range) {
+        std::vector<typename BlockSumType<T>::type> sums;
+        std::vector<T> values;
+        for (int b = range.start; b < range.end; ++b) {
+            int y0 = b * blockSize;
+            mosaicBlockRow<T>(src, dst, blockSize, y0, std::min(src.rows, y0 + blockSize), sums, values);
+        }
+    }, std::max(1, std::min(cv::getNumThreads() * 4, blockRows)));
+}
+
+} // namespace detail
+
+/**
+ * @brief Replace every blockSize x blockSize block by its mean
+ * @param src The input image (any depth, any number of channels)
+ * @param dst The output image; may be src itself for in-place operation
+ * @param blockSize Block side in pixels (>= 1)
+ * @throws std::invalid_argument if blockSize < 1
+ */
+inline void mosaicBlockAverage(const cv::Mat& src, cv::Mat& dst, int blockSize) {
+    if (blockSize < 1) {
+        throw std::invalid_argument("Mosaic block size must be at least 1");
+    }
+    if (src.empty()) {
+        dst = src;
+        return;
+    }
+    if (dst.data != src.data || dst.size() != src.size() || dst.type() != src.type()) {
+        dst.create(src.size(), src.type());
+    }
+    if (blockSize == 1) {
+        if (dst.data != src.data) {
+            src.copyTo(dst);
+        }
+        return;
+    }
+
+    switch (src.depth()) {
+        case CV_8U:  detail::mosaicTyped<uint8_t>(src, dst, blockSize); break;
+        case CV_8S:  detail::mosaicTyped<int8_t>(src, dst, blockSize); break;
+        case CV_16U: detail::mosaicTyped<uint16_t>(src, dst, blockSize); break;
+        case CV_16S: detail::mosaicTyped<int16_t>(src, dst, blockSize); break;
+        case CV_32S: detail::mosaicTyped<int32_t>(src, dst, blockSize); break;
+        case CV_32F: detail::mosaicTyped<float>(src, dst, blockSize); break;
+        case CV_64F: detail::mosaicTyped<double>(src, dst, blockSize); break;
+        default:
+            throw std::invalid_argument("Unsupported image depth for mosaic");
+    }
+}
+
+} // namespace kernels
+
+#endif // BLOCK_MOSAIC_H
@@ -0,0 +1,382 @@
+#ifndef FIXED_POINT_GAUSSIAN_H
+#define FIXED_POINT_GAUSSIAN_H
+
+#include "OutputBuffer.h"
+#include "Simd.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief Separable Gaussian blur for 8-bit images in 16-bit fixed point
+ *
+ * Coefficients are stored in Q8 (they sum to exactly 256). The horizontal
+ * pass produces Q8 values that fit in 16 bits, the vertical pass accumulates
+ * them in 32 bits and rounds back to 8 bits. This is the same arithmetic as
+ * OpenCV's bit-exact 8-bit path, and coefficients are quantized the same way,
+ * so results match cv::GaussianBlur; the documented tolerance is +/-1 per
+ * pixel, to cover double vs. soft-float rounding of the kernel weights.
+ *
+ * Kernel sizes 3, 5, 7 and 9 are specialized at compile time; borders use
+ * BORDER_REFLECT_101 like cv::GaussianBlur.
+ */
+namespace kernels {
+
+/**
+ * @brief Check whether the fixed-point path handles an image and kernel size
+ * @param src The input image
+ * @param ksize Kernel size (square)
+ * @return true for 8UC1/8UC3 images with a kernel of 3, 5, 7 or 9
+ */
+inline bool canUseFixedPointGaussian(const cv::Mat& src, int ksize) {
+    return (src.type() == CV_8UC1 || src.type() == CV_8UC3) &&
+           (ksize == 3 || ksize == 5 || ksize == 7 || ksize == 9);
+}
+
+/**
+ * @brief Compute symmetric Gaussian coefficients in Q8 fixed point
+ * @param ksize Kernel size (odd)
+ * @param sigma Standard deviation (<= 0 = derived from ksize like OpenCV)
+ * @return ksize coefficients summing to exactly 256
+ */
+inline std::vector<uint16_t> gaussianCoefficientsQ8(int ksize, double sigma) {
+    // OpenCV's fixed tables for sigma <= 0, already exact in Q8
+    static const uint16_t small3[] = {64, 128, 64};
+    static const uint16_t small5[] = {16, 64, 96, 64, 16};
+    static const uint16_t small7[] = {8, 28, 56, 72, 56, 28, 8};
+    if (sigma <= 0) {
+        if (ksize == 3) return std::vector<uint16_t>(small3, small3 + 3);
+        if (ksize == 5) return std::vector<uint16_t>(small5, small5 + 5);
+        if (ksize == 7) return std::vector<uint16_t>(small7, small7 + 7);
+        sigma = 0.3 * ((ksize - 1) * 0.5 - 1) + 0.8;
+    }
+
+    const int r = ksize / 2;
+    std::vector<double> weights(ksize);
+    double sum = 1.0;  // Centre tap
+    for (int i = 0; i < r; ++i) {
+        double x = i - r;
+        weights[i] = std::exp(-(x * x) / (2.0 * sigma * sigma));
+        sum += 2.0 * weights[i];
+    }
+
+    // Quantize the left half with error diffusion and give the remainder to
+    // the centre tap, as OpenCV does for its fixed-point kernels
+    std::vector<uint16_t> coeffs(ksize);
+    double err = 0.0;
+    int total = 0;
+    for (int i = 0; i < r; ++i) {
+        double v = weights[i] / sum * 256.0 + err;
+        double q = std::nearbyint(v);
+        err = v - q;
+        coeffs[i] = coeffs[ksize - 1 - i] = static_cast<uint16_t>(q);
+        total += 2 * static_cast<int>(q);
+    }
+    coeffs[r] = static_cast<uint16_t>(256 - total);
+    return coeffs;
+}
+
+namespace detail {
+
+/**
+ * @brief Horizontal pass: dst[i] = sum_k c[k] * src[i + k * cn]
+ *
+ * src is a row padded with K/2 pixels on each side. Products and sums stay
+ * below 65536, so 16-bit lanes are exact.
+ */
+template <int K>
+inline void gaussianRowQ8(const uint8_t* src, uint16_t* dst, int n, int cn, const uint16_t* c) {
+    int i = 0;
+#if IT_SIMD_AVX2
+    for (; i <= n - 16; i += 16) {
+        __m256i acc = _mm256_setzero_si256();
+        for (int k = 0; k < K; ++k) {
+            __m256i v = _mm256_cvtepu8_epi16(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + k * cn)));
+            acc = _mm256_add_epi16(acc, _mm256_mullo_epi16(v, _mm256_set1_epi16(static_cast<short>(c[k]))));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), acc);
+    }
+#elif IT_SIMD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i <= n - 16; i += 16) {
+        __m128i lo = zero, hi = zero;
+        for (int k = 0; k < K; ++k) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + k * cn));
+            __m128i ck = _mm_set1_epi16(static_cast<short>(c[k]));
+            lo = _mm_add_epi16(lo, _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), ck));
+            hi = _mm_add_epi16(hi, _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), ck));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), hi);
+    }
+#elif IT_SIMD_NEON
+    for (; i <= n - 16; i += 16) {
+        uint16x8_t lo = vdupq_n_u16(0), hi = vdupq_n_u16(0);
+        for (int k = 0; k < K; ++k) {
+            uint8x16_t v = vld1q_u8(src + i + k * cn);
+            lo = vmlaq_n_u16(lo, vmovl_u8(vget_low_u8(v)), c[k]);
+            hi = vmlaq_n_u16(hi, vmovl_u8(vget_high_u8(v)), c[k]);
+        }
+        vst1q_u16(dst + i, lo);
+        vst1q_u16(dst + i + 8, hi);
+    }
+#endif
+    for (; i < n; ++i) {
+        uint32_t acc = 0;
+        for (int k = 0; k < K; ++k) {
+            acc += static_cast<uint32_t>(c[k]) * src[i + k * cn];
+        }
+        dst[i] = static_cast<uint16_t>(acc);
+    }
+}
+
+/**
+ * @brief Vertical pass: dst[i] = (sum_k c[k] * rows[k][i] + 2^15) >> 16
+ */
+template <int K>
+inline void gaussianColumnQ8(const uint16_t* const* rows, uint8_t* dst, int n, const uint16_t* c) {
+    int i = 0;
+#if IT_SIMD_AVX2
+    const __m256i half = _mm256_set1_epi32(1 << 15);
+    for (; i <= n - 16; i += 16) {
+        __m256i accLo = half, accHi = half;
+        for (int k = 0; k < K; ++k) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k] + i));
+            __m256i ck = _mm256_set1_epi16(static_cast<short>(c[k]));
+            __m256i pl = _mm256_mullo_epi16(v, ck);
+            __m256i ph = _mm256_mulhi_epu16(v, ck);
+            accLo = _mm256_add_epi32(accLo, _mm256_unpacklo_epi16(pl, ph));
+            accHi = _mm256_add_epi32(accHi, _mm256_unpackhi_epi16(pl, ph));
+        }
+        // Unpack and pack both work per 128-bit lane, so element order is restored
+        __m256i w = _mm256_packs_epi32(_mm256_srli_epi32(accLo, 16), _mm256_srli_epi32(accHi, 16));
+        __m256i b = _mm256_permute4x64_epi64(_mm256_packus_epi16(w, w), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_castsi256_si128(b));
+    }
+#elif IT_SIMD_SSE2
+    const __m128i half = _mm_set1_epi32(1 << 15);
+    for (; i <= n - 16; i += 16) {
+        __m128i acc0 = half, acc1 = half, acc2 = half, acc3 = half;
+        for (int k = 0; k < K; ++k) {
+            __m128i ck = _mm_set1_epi16(static_cast<short>(c[k]));
+            __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + i));
+            __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + i + 8));
+            __m128i pl0 = _mm_mullo_epi16(v0, ck), ph0 = _mm_mulhi_epu16(v0, ck);
+            __m128i pl1 = _mm_mullo_epi16(v1, ck), ph1 = _mm_mulhi_epu16(v1, ck);
+            acc0 = _mm_add_epi32(acc0, _mm_unpacklo_epi16(pl0, ph0));
+            acc1 = _mm_add_epi32(acc1, _mm_unpackhi_epi16(pl0, ph0));
+            acc2 = _mm_add_epi32(acc2, _mm_unpacklo_epi16(pl1, ph1));
+            acc3 = _mm_add_epi32(acc3, _mm_unpackhi_epi16(pl1, ph1));
+        }
+        __m128i w0 = _mm_packs_epi32(_mm_srli_epi32(acc0, 16), _mm_srli_epi32(acc1, 16));
+        __m128i w1 = _mm_packs_epi32(_mm_srli_epi32(acc2, 16), _mm_srli_epi32(acc3, 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(w0, w1));
+    }
+#elif IT_SIMD_NEON
+    for (; i <= n - 16; i += 16) {
+        uint32x4_t acc0 = vdupq_n_u32(0), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+        for (int k = 0; k < K; ++k) {
+            uint16x8_t v0 = vld1q_u16(rows[k] + i);
+            uint16x8_t v1 = vld1q_u16(rows[k] + i + 8);
+            acc0 = vmlal_n_u16(acc0, vget_low_u16(v0), c[k]);
+            acc1 = vmlal_n_u16(acc1, vget_high_u16(v0), c[k]);
+            acc2 = vmlal_n_u16(acc2, vget_low_u16(v1), c[k]);
+            acc3 = vmlal_n_u16(acc3, vget_high_u16(v1), c[k]);
+        }
+        // vrshrn adds the 2^15 rounding term before shifting
+        uint16x8_t w0 = vcombine_u16(vrshrn_n_u32(acc0, 16), vrshrn_n_u32(acc1, 16));
+        uint16x8_t w1 = vcombine_u16(vrshrn_n_u32(acc2, 16), vrshrn_n_u32(acc3, 16));
+        vst1q_u8(dst + i, vcombine_u8(vqmovn_u16(w0), vqmovn_u16(w1)));
+    }
+#endif
+    for (; i < n; ++i) {
+        uint32_t acc = 1u << 15;
+        for (int k = 0; k < K; ++k) {
+            acc += static_cast<uint32_t>(c[k]) * rows[k][i];
+        }
+        dst[i] = static_cast<uint8_t>(acc >> 16);
+    }
+}
+
+/**
+ * @brief Horizontal pass of one unpadded row, borders reflected (BORDER_REFLECT_101)
+ *
+ * Same values as gaussianRowQ8() on the padded row: the interior is read in
+ * place and only the r pixels at each end are computed from reflected indices.
+ */
+template <int K>
+inline void gaussianLineQ8(const uint8_t* src, uint16_t* dst, int cols, int cn, const uint16_t* c) {
+    const int r = K / 2;
+    const int inner = cols > 2 * r ? (cols - 2 * r) * cn : 0;
+    if (inner > 0) {
+        gaussianRowQ8<K>(src, dst + r * cn, inner, cn, c);
+    }
+    for (int x = 0; x < cols; ++x) {
+        if (inner > 0 && x == r) {
+            x = cols - r;  // Interior done
+        }
+        for (int ch = 0; ch < cn; ++ch) {
+            uint32_t acc = 0;
+            for (int k = 0; k < K; ++k) {
+                acc += static_cast<uint32_t>(c[k]) * src[cv::borderInterpolate(x - r + k, cols, cv::BORDER_REFLECT_101) * cn + ch];
+            }
+            dst[x * cn + ch] = static_cast<uint16_t>(acc);
+        }
+    }
+}
+
+/**
+ * @brief Blur src into dst (distinct buffers) with a K x K kernel, in row bands
+ *
+ * Each band keeps a ring of K horizontally filtered rows, so every source row
+ * is filtered once per band.
+ */
+template <int K>
+inline void gaussianBlurQ8(const cv::Mat& src, cv::Mat& dst, const uint16_t* cx, const uint16_t* cy) {
+    const int r = K / 2;
+    const int rows = src.rows;
+    const int cols = src.cols;
+    const int cn = src.channels();
+    const int n = cols * cn;
+    const int stripes = std::max(1, std::min(cv::getNumThreads() * 4, rows / 64));
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& band) {
+        std::vector<uint8_t> padded(static_cast<size_t>(cols + 2 * r) * cn);
+        std::vector<uint16_t> ring(static_cast<size_t>(K) * n);
+        const uint16_t* window[K];
+        const int first = band.start - r;
+
+        auto filterRow = [&](int virtualRow) {
+            const uint8_t* s = src.ptr<uint8_t>(cv::borderInterpolate(virtualRow, rows, cv::BORDER_REFLECT_101));
+            for (int x = 0; x < r; ++x) {
+                int left = cv::borderInterpolate(x - r, cols, cv::BORDER_REFLECT_101);
+                int right = cv::borderInterpolate(cols + x, cols, cv::BORDER_REFLECT_101);
+                std::memcpy(&padded[x * cn], s + left * cn, cn);
+                std::memcpy(&padded[(r + cols + x) * cn], s + right * cn, cn);
+            }
+            std::memcpy(&padded[r * cn], s, n);
+            gaussianRowQ8<K>(padded.data(), &ring[static_cast<size_t>((virtualRow - first) % K) * n], n, cn, cx);
+        };
+
+        for (int vy = first; vy < band.start + r; ++vy) {
+            filterRow(vy);
+        }
+        for (int y = band.start; y < band.end; ++y) {
+            filterRow(y + r);
+            for (int k = 0; k < K; ++k) {
+                window[k] = &ring[static_cast<size_t>((y - r + k - first) % K) * n];
+            }
+            gaussianColumnQ8<K>(window, dst.ptr<uint8_t>(y), n, cy);
+        }
+    }, stripes);
+}
+
+} // namespace detail
+
+/**
+ * @brief Q8 coefficients of both passes, computed once per parameter set
+ */
+struct GaussianKernelQ8 {
+    int ksize = 0;
+    std::vector<uint16_t> cx;
+    std::vector<uint16_t> cy;
+};
+
+/**
+ * @brief Compute the fixed-point kernel for gaussianBlurFixedPoint()
+ * @param ksize Kernel size (3, 5, 7 or 9)
+ * @param sigmaX Standard deviation in X (0 = auto)
+ * @param sigmaY Standard deviation in Y (0 = same as sigmaX)
+ * @return The kernel
+ */
+inline GaussianKernelQ8 makeGaussianKernelQ8(int ksize, double sigmaX, double sigmaY) {
+    if (sigmaY <= 0) {
+        sigmaY = sigmaX;
+    }
+    GaussianKernelQ8 kernel;
+    kernel.ksize = ksize;
+    kernel.cx = gaussianCoefficientsQ8(ksize, sigmaX);
+    kernel.cy = gaussianCoefficientsQ8(ksize, sigmaY);
+    return kernel;
+}
+
+/**
+ * @brief Horizontal pass of one row, for callers streaming rows through their own ring
+ * @param kernel Kernel from makeGaussianKernelQ8() (size 3, 5, 7 or 9)
+ * @param src Row of cols pixels (8-bit, cn channels)
+ * @param dst cols * cn Q8 values
+ */
+inline void gaussianLineFixedPoint(const GaussianKernelQ8& kernel, const uint8_t* src, uint16_t* dst,
+                                   int cols, int cn) {
+    switch (kernel.ksize) {
+        case 3: detail::gaussianLineQ8<3>(src, dst, cols, cn, kernel.cx.data()); break;
+        case 5: detail::gaussianLineQ8<5>(src, dst, cols, cn, kernel.cx.data()); break;
+        case 7: detail::gaussianLineQ8<7>(src, dst, cols, cn, kernel.cx.data()); break;
+        case 9: detail::gaussianLineQ8<9>(src, dst, cols, cn, kernel.cx.data()); break;
+    }
+}
+
+/**
+ * @brief Vertical pass producing one output row from ksize horizontally filtered rows
+ * @param kernel Kernel from makeGaussianKernelQ8() (size 3, 5, 7 or 9)
+ * @param lines The ksize rows around the output row, top to bottom, borders reflected
+ * @param dst n output bytes
+ */
+inline void gaussianColumnFixedPoint(const GaussianKernelQ8& kernel, const uint16_t* const* lines,
+                                     uint8_t* dst, int n) {
+    switch (kernel.ksize) {
+        case 3: detail::gaussianColumnQ8<3>(lines, dst, n, kernel.cy.data()); break;
+        case 5: detail::gaussianColumnQ8<5>(lines, dst, n, kernel.cy.data()); break;
+        case 7: detail::gaussianColumnQ8<7>(lines, dst, n, kernel.cy.data()); break;
+        case 9: detail::gaussianColumnQ8<9>(lines, dst, n, kernel.cy.data()); break;
+    }
+}
+
+/**
+ * @brief Gaussian blur of an 8-bit image with a precomputed fixed-point kernel
+ * @param src The input image (8UC1 or 8UC3)
+ * @param dst The output image (written in place when it already has the result format
+ *            and does not overlap src, otherwise reallocated)
+ * @param kernel Kernel from makeGaussianKernelQ8()
+ * @return false if the input or kernel size is not supported (dst untouched)
+ */
+inline bool gaussianBlurFixedPoint(const cv::Mat& src, cv::Mat& dst, const GaussianKernelQ8& kernel) {
+    if (!canUseFixedPointGaussian(src, kernel.ksize)) {
+        return false;
+    }
+
+    cv::Mat output = outputBuffer(src, dst, src.size(), src.type());
+    switch (kernel.ksize) {
+        case 3: detail::gaussianBlurQ8<3>(src, output, kernel.cx.data(), kernel.cy.data()); break;
+        case 5: detail::gaussianBlurQ8<5>(src, output, kernel.cx.data(), kernel.cy.data()); break;
+        case 7: detail::gaussianBlurQ8<7>(src, output, kernel.cx.data(), kernel.cy.data()); break;
+        case 9: detail::gaussianBlurQ8<9>(src, output, kernel.cx.data(), kernel.cy.data()); break;
+    }
+    dst = output;
+    return true;
+}
+
+/**
+ * @brief Gaussian blur through the fixed-point SIMD path
+ * @param src The input image (8UC1 or 8UC3)
+ * @param dst The output image (written in place when it already has the result format
+ *            and does not overlap src, otherwise reallocated)
+ * @param ksize Kernel size (3, 5, 7 or 9)
+ * @param sigmaX Standard deviation in X (0 = auto)
+ * @param sigmaY Standard deviation in Y (0 = same as sigmaX)
+ * @return false if the input or kernel size is not supported (dst untouched)
+ */
+inline bool gaussianBlurFixedPoint(const cv::Mat& src, cv::Mat& dst, int ksize, double sigmaX, double sigmaY) {
+    if (!canUseFixedPointGaussian(src, ksize)) {
+        return false;
+    }
+    return gaussianBlurFixedPoint(src, dst, makeGaussianKernelQ8(ksize, sigmaX, sigmaY));
+}
+
+} // namespace kernels
+
+#endif // FIXED_POINT_GAUSSIAN_H
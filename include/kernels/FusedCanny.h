@@ -0,0 +1,459 @@
+#ifndef FUSED_CANNY_H
+#define FUSED_CANNY_H
+
+#include "Simd.h"
+#include "FixedPointGaussian.h"
+#include "OutputBuffer.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief Fused grayscale -> Gaussian blur -> Canny edge detection for 8-bit images
+ *
+ * The image is cut into horizontal stripes processed in parallel. Each
+ * stripe is swept once, top to bottom, with a few rows of ring buffers:
+ * luma conversion and the horizontal blur pass feed the vertical blur pass,
+ * blurred rows feed a 3x3 Sobel (L1 magnitude), and three magnitude rows
+ * feed non-maximum suppression, which writes edge candidates into the
+ * output. Nothing image-sized is allocated besides the output.
+ *
+ * Hysteresis then follows edges inside each stripe; a serial seam pass
+ * restarts it from the edge pixels on both sides of every stripe boundary,
+ * so edges crossing stripes are connected exactly as in a global pass.
+ *
+ * Arithmetic matches cv::cvtColor (BGR/BGRA to gray), the fixed-point
+ * Gaussian path and cv::Canny (aperture 3, L1 gradient), so the result is
+ * the same as running the three treatments one after the other.
+ */
+namespace kernels {
+
+namespace detail {
+
+#if IT_SIMD_AVX2
+/**
+ * @brief Byte shuffle masks that gather one channel of 16 interleaved pixels
+ *
+ * masks[ch][k] picks the bytes of channel ch found in the k-th 16-byte
+ * vector of the input and moves them to their pixel position.
+ */
+template <int CN>
+inline const __m128i* channelMasks() {
+    struct Masks {
+        __m128i m[3][CN];
+        Masks() {
+            for (int ch = 0; ch < 3; ++ch) {
+                for (int k = 0; k < CN; ++k) {
+                    alignas(16) int8_t bytes[16];
+                    for (int j = 0; j < 16; ++j) {
+                        int b = j * CN + ch;
+                        bytes[j] = (b / 16 == k) ? static_cast<int8_t>(b % 16) : static_cast<int8_t>(-128);
+                    }
+                    m[ch][k] = _mm_load_si128(reinterpret_cast<const __m128i*>(bytes));
+                }
+            }
+        }
+    };
+    static const Masks masks;
+    return &masks.m[0][0];
+}
+#endif
+
+/**
+ * @brief BGR or BGRA row to luma, with OpenCV's 15-bit coefficients
+ */
+template <int CN>
+inline void lumaRow(const uint8_t* src, uint8_t* dst, int cols) {
+    int x = 0;
+#if IT_SIMD_AVX2
+    const __m128i* masks = channelMasks<CN>();
+    const __m256i cBG = _mm256_set1_epi32((19235 << 16) | 3735);
+    const __m256i cR = _mm256_set1_epi32((16384 << 16) | 9798);
+    const __m256i one = _mm256_set1_epi16(1);
+    for (; x <= cols - 16; x += 16) {
+        __m128i v[CN];
+        for (int k = 0; k < CN; ++k) {
+            v[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * CN) + k);
+        }
+        __m256i c16[3];
+        for (int ch = 0; ch < 3; ++ch) {
+            __m128i c = _mm_shuffle_epi8(v[0], masks[ch * CN]);
+            for (int k = 1; k < CN; ++k) {
+                c = _mm_or_si128(c, _mm_shuffle_epi8(v[k], masks[ch * CN + k]));
+            }
+            c16[ch] = _mm256_cvtepu8_epi16(c);
+        }
+        __m256i bg = _mm256_unpacklo_epi16(c16[0], c16[1]);
+        __m256i r1 = _mm256_unpacklo_epi16(c16[2], one);
+        __m256i lo = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(bg, cBG), _mm256_madd_epi16(r1, cR)), 15);
+        bg = _mm256_unpackhi_epi16(c16[0], c16[1]);
+        r1 = _mm256_unpackhi_epi16(c16[2], one);
+        __m256i hi = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(bg, cBG), _mm256_madd_epi16(r1, cR)), 15);
+        __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(lo, hi), _mm256_setzero_si256());
+        packed = _mm256_permute4x64_epi64(packed, 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm256_castsi256_si128(packed));
+    }
+#elif IT_SIMD_NEON
+    for (; x <= cols - 8; x += 8) {
+        uint8x8_t b, g, r;
+        if (CN == 3) {
+            uint8x8x3_t p = vld3_u8(src + x * 3);
+            b = p.val[0]; g = p.val[1]; r = p.val[2];
+        } else {
+            uint8x8x4_t p = vld4_u8(src + x * 4);
+            b = p.val[0]; g = p.val[1]; r = p.val[2];
+        }
+        uint16x8_t b16 = vmovl_u8(b), g16 = vmovl_u8(g), r16 = vmovl_u8(r);
+        uint32x4_t lo = vdupq_n_u32(1 << 14), hi = vdupq_n_u32(1 << 14);
+        lo = vmlal_n_u16(vmlal_n_u16(vmlal_n_u16(lo, vget_low_u16(b16), 3735), vget_low_u16(g16), 19235), vget_low_u16(r16), 9798);
+        hi = vmlal_n_u16(vmlal_n_u16(vmlal_n_u16(hi, vget_high_u16(b16), 3735), vget_high_u16(g16), 19235), vget_high_u16(r16), 9798);
+        vst1_u8(dst + x, vmovn_u16(vcombine_u16(vshrn_n_u32(lo, 15), vshrn_n_u32(hi, 15))));
+    }
+#endif
+    for (; x < cols; ++x) {
+        const uint8_t* p = src + x * CN;
+        dst[x] = static_cast<uint8_t>((p[0] * 3735 + p[1] * 19235 + p[2] * 9798 + (1 << 14)) >> 15);
+    }
+}
+
+/**
+ * @brief 3x3 Sobel and L1 magnitude of one row
+ *
+ * a, b, c are the rows above, at and below, each readable at [-1, cols].
+ * Values stay within int16: |dx|, |dy| <= 1020.
+ */
+inline void sobelRow(const uint8_t* a, const uint8_t* b, const uint8_t* c,
+                     int16_t* dx, int16_t* dy, int16_t* mag, int cols) {
+    int x = 0;
+#if IT_SIMD_AVX2 || IT_SIMD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    auto load = [&](const uint8_t* p) {
+        return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+    };
+    for (; x <= cols - 8; x += 8) {
+        __m128i a0 = load(a + x - 1), a1 = load(a + x), a2 = load(a + x + 1);
+        __m128i b0 = load(b + x - 1), b2 = load(b + x + 1);
+        __m128i c0 = load(c + x - 1), c1 = load(c + x), c2 = load(c + x + 1);
+        __m128i gx = _mm_add_epi16(_mm_add_epi16(_mm_sub_epi16(a2, a0), _mm_sub_epi16(c2, c0)),
+                                   _mm_slli_epi16(_mm_sub_epi16(b2, b0), 1));
+        __m128i gy = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(c0, c2), _mm_slli_epi16(c1, 1)),
+                                   _mm_add_epi16(_mm_add_epi16(a0, a2), _mm_slli_epi16(a1, 1)));
+        __m128i m = _mm_add_epi16(_mm_max_epi16(gx, _mm_sub_epi16(zero, gx)),
+                                  _mm_max_epi16(gy, _mm_sub_epi16(zero, gy)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dx + x), gx);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dy + x), gy);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mag + x), m);
+    }
+#elif IT_SIMD_NEON
+    auto load = [](const uint8_t* p) { return vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p))); };
+    for (; x <= cols - 8; x += 8) {
+        int16x8_t a0 = load(a + x - 1), a1 = load(a + x), a2 = load(a + x + 1);
+        int16x8_t b0 = load(b + x - 1), b2 = load(b + x + 1);
+        int16x8_t c0 = load(c + x - 1), c1 = load(c + x), c2 = load(c + x + 1);
+        int16x8_t gx = vaddq_s16(vaddq_s16(vsubq_s16(a2, a0), vsubq_s16(c2, c0)),
+                                 vshlq_n_s16(vsubq_s16(b2, b0), 1));
+        int16x8_t gy = vsubq_s16(vaddq_s16(vaddq_s16(c0, c2), vshlq_n_s16(c1, 1)),
+                                 vaddq_s16(vaddq_s16(a0, a2), vshlq_n_s16(a1, 1)));
+        vst1q_s16(dx + x, gx);
+        vst1q_s16(dy + x, gy);
+        vst1q_s16(mag + x, vaddq_s16(vabsq_s16(gx), vabsq_s16(gy)));
+    }
+#endif
+    for (; x < cols; ++x) {
+        int gx = (a[x + 1] - a[x - 1]) + 2 * (b[x + 1] - b[x - 1]) + (c[x + 1] - c[x - 1]);
+        int gy = (c[x - 1] + 2 * c[x] + c[x + 1]) - (a[x - 1] + 2 * a[x] + a[x + 1]);
+        dx[x] = static_cast<int16_t>(gx);
+        dy[x] = static_cast<int16_t>(gy);
+        mag[x] = static_cast<int16_t>(std::abs(gx) + std::abs(gy));
+    }
+}
+
+/**
+ * @brief Non-maximum suppression of one row, as cv::Canny does it
+ *
+ * Writes 0 (no edge), 1 (weak candidate) or 255 (strong edge) and returns
+ * the strong pixels' columns in strong.
+ */
+inline void suppressRow(const int16_t* magPrev, const int16_t* mag, const int16_t* magNext,
+                        const int16_t* dx, const int16_t* dy, uint8_t* out, int cols,
+                        int low, int high, std::vector<int>& strong) {
+    const int tg22 = 13573;  // tan(22.5 deg) in Q15
+    int x = 0;
+#if IT_SIMD_AVX2 || IT_SIMD_SSE2
+    // Same tests, branch-free on 8 pixels; the Q15 comparisons need 32-bit lanes
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vlow = _mm_set1_epi16(static_cast<int16_t>(low));
+    const __m128i vhigh = _mm_set1_epi16(static_cast<int16_t>(high));
+    const __m128i vtg22 = _mm_set1_epi16(tg22);
+    const __m128i ones = _mm_set1_epi16(1);
+    auto load = [](const int16_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+    for (; x <= cols - 8; x += 8) {
+        const __m128i m = load(mag + x);
+        const __m128i candidate = _mm_cmpgt_epi16(m, vlow);
+        if (_mm_movemask_epi8(candidate) == 0) {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), zero);
+            continue;
+        }
+        const __m128i gx = load(dx + x);
+        const __m128i gy = load(dy + x);
+        const __m128i ax = _mm_max_epi16(gx, _mm_sub_epi16(zero, gx));
+        const __m128i ay = _mm_max_epi16(gy, _mm_sub_epi16(zero, gy));
+
+        const __m128i pLo16 = _mm_mullo_epi16(ax, vtg22);
+        const __m128i pHi16 = _mm_mulhi_epi16(ax, vtg22);
+        __m128i horizontal[2], vertical[2];
+        for (int h = 0; h < 2; ++h) {
+            __m128i tg22x = h ? _mm_unpackhi_epi16(pLo16, pHi16) : _mm_unpacklo_epi16(pLo16, pHi16);
+            __m128i ax32 = h ? _mm_unpackhi_epi16(ax, zero) : _mm_unpacklo_epi16(ax, zero);
+            __m128i ay32 = _mm_slli_epi32(h ? _mm_unpackhi_epi16(ay, zero) : _mm_unpacklo_epi16(ay, zero), 15);
+            horizontal[h] = _mm_cmplt_epi32(ay32, tg22x);
+            vertical[h] = _mm_cmpgt_epi32(ay32, _mm_add_epi32(tg22x, _mm_slli_epi32(ax32, 16)));
+        }
+        const __m128i isHorizontal = _mm_packs_epi32(horizontal[0], horizontal[1]);
+        const __m128i isVertical = _mm_packs_epi32(vertical[0], vertical[1]);
+        const __m128i isDiagonal = _mm_andnot_si128(_mm_or_si128(isHorizontal, isVertical), candidate);
+        const __m128i antiDiagonal = _mm_srai_epi16(_mm_xor_si128(gx, gy), 15);  // s = -1
+
+        auto greater = [&](const __m128i& other) { return _mm_cmpgt_epi16(m, other); };
+        auto notLess = [&](const __m128i& other) { return _mm_andnot_si128(_mm_cmpgt_epi16(other, m), candidate); };
+        __m128i peak = _mm_and_si128(isHorizontal, _mm_and_si128(greater(load(mag + x - 1)), notLess(load(mag + x + 1))));
+        peak = _mm_or_si128(peak, _mm_and_si128(isVertical, _mm_and_si128(greater(load(magPrev + x)), notLess(load(magNext + x)))));
+        __m128i diagonal = _mm_and_si128(greater(load(magPrev + x - 1)), greater(load(magNext + x + 1)));
+        __m128i anti = _mm_and_si128(greater(load(magPrev + x + 1)), greater(load(magNext + x - 1)));
+        diagonal = _mm_or_si128(_mm_and_si128(antiDiagonal, anti), _mm_andnot_si128(antiDiagonal, diagonal));
+        peak = _mm_and_si128(candidate, _mm_or_si128(peak, _mm_and_si128(isDiagonal, diagonal)));
+
+        const __m128i isStrong = _mm_and_si128(peak, _mm_cmpgt_epi16(m, vhigh));
+        const __m128i value = _mm_or_si128(_mm_and_si128(peak, ones), _mm_and_si128(isStrong, _mm_set1_epi16(255)));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(value, zero));
+        for (int bits = _mm_movemask_epi8(_mm_packs_epi16(isStrong, zero)); bits != 0; bits &= bits - 1) {
+            int i = 0;
+            while (((bits >> i) & 1) == 0) {
+                ++i;
+            }
+            strong.push_back(x + i);
+        }
+    }
+#endif
+    for (; x < cols; ++x) {
+        const int m = mag[x];
+        uint8_t value = 0;
+        if (m > low) {
+            const int xs = dx[x];
+            const int ys = dy[x];
+            const int ax = std::abs(xs);
+            const int ay = std::abs(ys) << 15;
+            const int tg22x = ax * tg22;
+            bool peak;
+            if (ay < tg22x) {
+                peak = m > mag[x - 1] && m >= mag[x + 1];
+            } else if (ay > tg22x + (ax << 16)) {
+                peak = m > magPrev[x] && m >= magNext[x];
+            } else {
+                const int s = (xs ^ ys) < 0 ? -1 : 1;
+                peak = m > magPrev[x - s] && m > magNext[x + s];
+            }
+            if (peak) {
+                value = m > high ? 255 : 1;
+                if (value == 255) {
+                    strong.push_back(x);
+                }
+            }
+        }
+        out[x] = value;
+    }
+}
+
+/**
+ * @brief Promote weak candidates 8-connected to the stacked edges, within rows [y0, y1)
+ */
+inline void followEdges(cv::Mat& map, std::vector<cv::Point>& stack, int y0, int y1) {
+    const int cols = map.cols;
+    while (!stack.empty()) {
+        cv::Point p = stack.back();
+        stack.pop_back();
+        for (int ny = std::max(y0, p.y - 1); ny <= std::min(y1 - 1, p.y + 1); ++ny) {
+            uint8_t* row = map.ptr<uint8_t>(ny);
+            for (int nx = std::max(0, p.x - 1); nx <= std::min(cols - 1, p.x + 1); ++nx) {
+                if (row[nx] == 1) {
+                    row[nx] = 255;
+                    stack.push_back(cv::Point(nx, ny));
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Sweep rows [y0, y1): luma, blur, Sobel, NMS and stripe-local hysteresis
+ */
+template <int K>
+inline void edgeStripe(const cv::Mat& src, cv::Mat& dst, int y0, int y1,
+                       const uint16_t* cx, const uint16_t* cy, int low, int high) {
+    const int r = K / 2;
+    const int rows = src.rows;
+    const int cols = src.cols;
+    const int cn = src.channels();
+    const size_t gradStep = static_cast<size_t>(cols) + 2;
+
+    std::vector<uint8_t> luma(cols + 2 * r);
+    std::vector<uint16_t> hring(static_cast<size_t>(K) * cols);
+    std::vector<uint8_t> blurred(4 * gradStep);
+    std::vector<int16_t> dxRing(3 * gradStep), dyRing(3 * gradStep);
+    std::vector<int16_t> magRing(3 * gradStep, 0);
+    std::vector<int16_t> zeroMag(gradStep, 0);
+    std::vector<int> strong;
+    std::vector<cv::Point> stack;
+
+    // Horizontal blur of luma rows, reflected at the top and bottom
+    const int hFirst = std::max(0, y0 - 2) - r;
+    int hNext = hFirst;
+    auto hRow = [&](int v) { return &hring[static_cast<size_t>((v - hFirst) % K) * cols]; };
+    auto ensureHorizontal = [&](int v) {
+        for (; hNext <= v; ++hNext) {
+            const uint8_t* s = src.ptr<uint8_t>(cv::borderInterpolate(hNext, rows, cv::BORDER_REFLECT_101));
+            if (cn == 1) {
+                std::memcpy(&luma[r], s, cols);
+            } else if (cn == 3) {
+                lumaRow<3>(s, &luma[r], cols);
+            } else {
+                lumaRow<4>(s, &luma[r], cols);
+            }
+            for (int x = 0; x < r; ++x) {
+                luma[x] = luma[r + cv::borderInterpolate(x - r, cols, cv::BORDER_REFLECT_101)];
+                luma[r + cols + x] = luma[r + cv::borderInterpolate(cols + x, cols, cv::BORDER_REFLECT_101)];
+            }
+            gaussianRowQ8<K>(luma.data(), hRow(hNext), cols, 1, cx);
+        }
+    };
+
+    // Blurred rows, padded by one replicated pixel for the Sobel
+    int bNext = std::max(0, y0 - 2);
+    auto bRow = [&](int y) { return &blurred[static_cast<size_t>(y % 4) * gradStep + 1]; };
+    auto ensureBlurred = [&](int y) {
+        for (; bNext <= y; ++bNext) {
+            ensureHorizontal(bNext + r);
+            const uint16_t* window[K];
+            for (int k = 0; k < K; ++k) {
+                window[k] = hRow(bNext - r + k);
+            }
+            uint8_t* b = bRow(bNext);
+            gaussianColumnQ8<K>(window, b, cols, cy);
+            b[-1] = b[0];
+            b[cols] = b[cols - 1];
+        }
+    };
+
+    // Gradients; magnitude rows keep a zero column on each side
+    int gNext = std::max(0, y0 - 1);
+    auto magRow = [&](int y) -> const int16_t* {
+        return (y < 0 || y >= rows) ? &zeroMag[1] : &magRing[static_cast<size_t>(y % 3) * gradStep + 1];
+    };
+    auto ensureGradient = [&](int y) {
+        for (; gNext <= std::min(y, rows - 1); ++gNext) {
+            ensureBlurred(std::min(gNext + 1, rows - 1));
+            const size_t slot = static_cast<size_t>(gNext % 3) * gradStep + 1;
+            sobelRow(bRow(std::max(gNext - 1, 0)), bRow(gNext), bRow(std::min(gNext + 1, rows - 1)),
+                     &dxRing[slot], &dyRing[slot], &magRing[slot], cols);
+        }
+    };
+
+    for (int y = y0; y < y1; ++y) {
+        ensureGradient(y + 1);
+        const size_t slot = static_cast<size_t>(y % 3) * gradStep + 1;
+        strong.clear();
+        suppressRow(magRow(y - 1), magRow(y), magRow(y + 1), &dxRing[slot], &dyRing[slot],
+                    dst.ptr<uint8_t>(y), cols, low, high, strong);
+        for (int x : strong) {
+            stack.push_back(cv::Point(x, y));
+        }
+    }
+    followEdges(dst, stack, y0, y1);
+}
+
+} // namespace detail
+
+/**
+ * @brief Check whether the fused edge engine handles an image and blur size
+ * @param src The input image
+ * @param blurSize Gaussian kernel size
+ * @return true for 8-bit images with 1, 3 or 4 channels and a kernel of 3, 5, 7 or 9
+ */
+inline bool canUseFusedCanny(const cv::Mat& src, int blurSize) {
+    return !src.empty() && src.depth() == CV_8U &&
+           (src.channels() == 1 || src.channels() == 3 || src.channels() == 4) &&
+           (blurSize == 3 || blurSize == 5 || blurSize == 7 || blurSize == 9);
+}
+
+/**
+ * @brief Grayscale, Gaussian blur and Canny (aperture 3, L1) in one sweep
+ * @param src The input image (8-bit, 1, 3 or 4 channels)
+ * @param dst The edge map (8UC1, 0 or 255; written in place when it already has that
+ *            format and does not overlap src, otherwise reallocated)
+ * @param blurSize Gaussian kernel size (3, 5, 7 or 9)
+ * @param sigmaX Gaussian standard deviation in X (0 = auto)
+ * @param sigmaY Gaussian standard deviation in Y (0 = same as sigmaX)
+ * @param threshold1 First hysteresis threshold
+ * @param threshold2 Second hysteresis threshold
+ * @return false if the input or blur size is not supported (dst untouched)
+ */
+inline bool fusedGrayBlurCanny(const cv::Mat& src, cv::Mat& dst, int blurSize,
+                               double sigmaX, double sigmaY, double threshold1, double threshold2) {
+    if (!canUseFusedCanny(src, blurSize)) {
+        return false;
+    }
+    if (sigmaY <= 0) {
+        sigmaY = sigmaX;
+    }
+    std::vector<uint16_t> cx = gaussianCoefficientsQ8(blurSize, sigmaX);
+    std::vector<uint16_t> cy = gaussianCoefficientsQ8(blurSize, sigmaY);
+    if (threshold1 > threshold2) {
+        std::swap(threshold1, threshold2);
+    }
+    const int low = static_cast<int>(std::floor(std::max(-1.0, std::min(threshold1, 32767.0))));
+    const int high = static_cast<int>(std::floor(std::max(-1.0, std::min(threshold2, 32767.0))));
+
+    const int rows = src.rows;
+    const int stripes = std::max(1, std::min(cv::getNumThreads() * 4, rows / 64));
+    cv::Mat output = outputBuffer(src, dst, src.size(), CV_8UC1);
+
+    cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; ++s) {
+            const int y0 = rows * s / stripes;
+            const int y1 = rows * (s + 1) / stripes;
+            switch (blurSize) {
+                case 3: detail::edgeStripe<3>(src, output, y0, y1, cx.data(), cy.data(), low, high); break;
+                case 5: detail::edgeStripe<5>(src, output, y0, y1, cx.data(), cy.data(), low, high); break;
+                case 7: detail::edgeStripe<7>(src, output, y0, y1, cx.data(), cy.data(), low, high); break;
+                case 9: detail::edgeStripe<9>(src, output, y0, y1, cx.data(), cy.data(), low, high); break;
+            }
+        }
+    }, stripes);
+
+    // Seam fixup: continue hysteresis from edges on both sides of each stripe boundary
+    std::vector<cv::Point> stack;
+    for (int s = 1; s < stripes; ++s) {
+        const int boundary = rows * s / stripes;
+        for (int y = boundary - 1; y <= boundary; ++y) {
+            const uint8_t* row = output.ptr<uint8_t>(y);
+            for (int x = 0; x < output.cols; ++x) {
+                if (row[x] == 255) {
+                    stack.push_back(cv::Point(x, y));
+                }
+            }
+        }
+    }
+    detail::followEdges(output, stack, 0, rows);
+
+    // Drop the weak candidates that no edge reached
+    cv::threshold(output, output, 1, 255, cv::THRESH_BINARY);
+    dst = output;
+    return true;
+}
+
+} // namespace kernels
+
+#endif // FUSED_CANNY_H
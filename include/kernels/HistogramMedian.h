@@ -0,0 +1,276 @@
+#ifndef HISTOGRAM_MEDIAN_H
+#define HISTOGRAM_MEDIAN_H
+
+#include "OutputBuffer.h"
+#include "Simd.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Histogram-based median filters for large kernels
+ *
+ * 8-bit images use a Perreault-Hebert constant-time filter: one 256-bin
+ * histogram per column slides down the image, and the kernel histogram is
+ * updated by adding the entering column and subtracting the leaving one
+ * (SIMD histogram merges). Cost per pixel does not depend on the kernel size.
+ *
+ * 16-bit images use a sliding two-level (256 x 256) kernel histogram, which
+ * costs O(k) per pixel instead of O(k^2).
+ *
+ * Both work on 1-4 channels, use BORDER_REPLICATE like cv::medianBlur and
+ * produce identical results. The image is split into column strips that are
+ * processed in parallel.
+ */
+namespace kernels {
+
+namespace detail {
+
+inline void addHistogram(uint16_t* dst, const uint16_t* src, int n) {
+    int i = 0;
+#if IT_SIMD_AVX2
+    for (; i <= n - 16; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_add_epi16(a, b));
+    }
+#elif IT_SIMD_SSE2
+    for (; i <= n - 8; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_add_epi16(a, b));
+    }
+#elif IT_SIMD_NEON
+    for (; i <= n - 8; i += 8) {
+        vst1q_u16(dst + i, vaddq_u16(vld1q_u16(dst + i), vld1q_u16(src + i)));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = static_cast<uint16_t>(dst[i] + src[i]);
+    }
+}
+
+/**
+ * @brief dst += add - sub, element-wise
+ */
+inline void slideHistogram(uint16_t* dst, const uint16_t* add, const uint16_t* sub, int n) {
+    int i = 0;
+#if IT_SIMD_AVX2
+    for (; i <= n - 16; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(add + i));
+        __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sub + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_sub_epi16(_mm256_add_epi16(a, p), m));
+    }
+#elif IT_SIMD_SSE2
+    for (; i <= n - 8; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(add + i));
+        __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sub + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_sub_epi16(_mm_add_epi16(a, p), m));
+    }
+#elif IT_SIMD_NEON
+    for (; i <= n - 8; i += 8) {
+        uint16x8_t a = vaddq_u16(vld1q_u16(dst + i), vld1q_u16(add + i));
+        vst1q_u16(dst + i, vsubq_u16(a, vld1q_u16(sub + i)));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = static_cast<uint16_t>(dst[i] + add[i] - sub[i]);
+    }
+}
+
+/**
+ * @brief Find the value of a given rank in a coarse (16) + fine (256) histogram
+ */
+inline uint8_t histogramRank8u(const uint16_t* fine, const uint16_t* coarse, int rank) {
+    int count = 0;
+    int bucket = 0;
+    while (count + coarse[bucket] <= rank) {
+        count += coarse[bucket++];
+    }
+    int value = bucket * 16;
+    while (count + fine[value] <= rank) {
+        count += fine[value++];
+    }
+    return static_cast<uint8_t>(value);
+}
+
+/**
+ * @brief Constant-time median over columns [x0, x1) of an 8-bit image
+ *
+ * Histogram layout: one block of 16 coarse + 256 fine bins per column and
+ * channel; the coarse bins count values by their high nibble.
+ */
+inline void medianStrip8u(const cv::Mat& src, cv::Mat& dst, int radius, int x0, int x1) {
+    const int rows = src.rows;
+    const int cols = src.cols;
+    const int cn = src.channels();
+    const int bins = 16 + 256;
+    const int rank = ((2 * radius + 1) * (2 * radius + 1)) / 2;
+    const int hx0 = std::max(0, x0 - radius);
+    const int hx1 = std::min(cols, x1 + radius);
+
+    std::vector<uint16_t> columns(static_cast<size_t>(hx1 - hx0) * cn * bins, 0);
+    std::vector<uint16_t> kernel(static_cast<size_t>(cn) * bins);
+    auto columnHist = [&](int x, int ch) {
+        x = std::min(std::max(x, 0), cols - 1);
+        return &columns[(static_cast<size_t>(x - hx0) * cn + ch) * bins];
+    };
+    auto updateColumns = [&](int y, int delta) {
+        const uint8_t* row = src.ptr<uint8_t>(std::min(std::max(y, 0), rows - 1));
+        for (int x = hx0; x < hx1; ++x) {
+            for (int ch = 0; ch < cn; ++ch) {
+                uint8_t v = row[x * cn + ch];
+                uint16_t* h = columnHist(x, ch);
+                h[v >> 4] = static_cast<uint16_t>(h[v >> 4] + delta);
+                h[16 + v] = static_cast<uint16_t>(h[16 + v] + delta);
+            }
+        }
+    };
+
+    for (int y = -radius; y <= radius; ++y) {
+        updateColumns(y, 1);
+    }
+
+    for (int y = 0; y < rows; ++y) {
+        std::fill(kernel.begin(), kernel.end(), 0);
+        for (int ch = 0; ch < cn; ++ch) {
+            for (int dx = -radius; dx <= radius; ++dx) {
+                addHistogram(&kernel[static_cast<size_t>(ch) * bins], columnHist(x0 + dx, ch), bins);
+            }
+        }
+
+        uint8_t* out = dst.ptr<uint8_t>(y);
+        for (int x = x0; x < x1; ++x) {
+            for (int ch = 0; ch < cn; ++ch) {
+                uint16_t* k = &kernel[static_cast<size_t>(ch) * bins];
+                if (x > x0) {
+                    slideHistogram(k, columnHist(x + radius, ch), columnHist(x - radius - 1, ch), bins);
+                }
+                out[x * cn + ch] = histogramRank8u(k + 16, k, rank);
+            }
+        }
+
+        if (y + 1 < rows) {
+            updateColumns(y - radius, -1);
+            updateColumns(y + radius + 1, 1);
+        }
+    }
+}
+
+/**
+ * @brief Sliding-histogram median over columns [x0, x1) of a 16-bit image
+ *
+ * The kernel histogram has 256 coarse bins (high byte) and 65536 fine bins
+ * per channel; each step right adds and removes one column of the window.
+ */
+inline void medianStrip16u(const cv::Mat& src, cv::Mat& dst, int radius, int x0, int x1) {
+    const int rows = src.rows;
+    const int cols = src.cols;
+    const int cn = src.channels();
+    const int rank = ((2 * radius + 1) * (2 * radius + 1)) / 2;
+    const int bins = 256 + 65536;
+
+    std::vector<uint32_t> hist(static_cast<size_t>(cn) * bins, 0);
+    std::vector<const uint16_t*> window(2 * radius + 1);
+    auto clampX = [&](int x) { return std::min(std::max(x, 0), cols - 1); };
+
+    auto updateColumn = [&](int x, int delta) {
+        x = clampX(x);
+        for (const uint16_t* row : window) {
+            for (int ch = 0; ch < cn; ++ch) {
+                uint16_t v = row[x * cn + ch];
+                uint32_t* h = &hist[static_cast<size_t>(ch) * bins];
+                h[v >> 8] += delta;
+                h[256 + v] += delta;
+            }
+        }
+    };
+
+    for (int y = 0; y < rows; ++y) {
+        for (int dy = -radius; dy <= radius; ++dy) {
+            window[dy + radius] = src.ptr<uint16_t>(std::min(std::max(y + dy, 0), rows - 1));
+        }
+        for (int dx = -radius; dx <= radius; ++dx) {
+            updateColumn(x0 + dx, 1);
+        }
+
+        uint16_t* out = dst.ptr<uint16_t>(y);
+        for (int x = x0; x < x1; ++x) {
+            if (x > x0) {
+                updateColumn(x - radius - 1, -1);
+                updateColumn(x + radius, 1);
+            }
+            for (int ch = 0; ch < cn; ++ch) {
+                const uint32_t* h = &hist[static_cast<size_t>(ch) * bins];
+                int count = 0;
+                int bucket = 0;
+                while (count + static_cast<int>(h[bucket]) <= rank) {
+                    count += h[bucket++];
+                }
+                int value = bucket * 256;
+                while (count + static_cast<int>(h[256 + value]) <= rank) {
+                    count += h[256 + value++];
+                }
+                out[x * cn + ch] = static_cast<uint16_t>(value);
+            }
+        }
+
+        // Empty the histogram by removing the last window
+        for (int dx = -radius; dx <= radius; ++dx) {
+            updateColumn(x1 - 1 + dx, -1);
+        }
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Check whether the histogram median handles an image and kernel size
+ * @param src The input image
+ * @param ksize Kernel size (odd)
+ * @return true for 8U/16U images with 1-4 channels and 3 <= ksize <= 255
+ */
+inline bool canUseHistogramMedian(const cv::Mat& src, int ksize) {
+    return (src.depth() == CV_8U || src.depth() == CV_16U) &&
+           src.channels() <= 4 && ksize >= 3 && ksize <= 255 && (ksize % 2) == 1;
+}
+
+/**
+ * @brief Median filter through the histogram path
+ * @param src The input image (8U or 16U, 1-4 channels)
+ * @param dst The output image (written in place when it already has the result format
+ *            and does not overlap src, otherwise reallocated)
+ * @param ksize Kernel size (odd, 3-255)
+ * @return false if the input or kernel size is not supported (dst untouched)
+ */
+inline bool medianBlurHistogram(const cv::Mat& src, cv::Mat& dst, int ksize) {
+    if (!canUseHistogramMedian(src, ksize)) {
+        return false;
+    }
+    const int radius = ksize / 2;
+    const int stripWidth = std::max(64, 2 * ksize);
+    const int strips = (src.cols + stripWidth - 1) / stripWidth;
+    const bool is8u = src.depth() == CV_8U;
+
+    cv::Mat output = outputBuffer(src, dst, src.size(), src.type());
+    cv::parallel_for_(cv::Range(0, strips), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; ++s) {
+            int x0 = s * stripWidth;
+            int x1 = std::min(src.cols, x0 + stripWidth);
+            if (is8u) {
+                detail::medianStrip8u(src, output, radius, x0, x1);
+            } else {
+                detail::medianStrip16u(src, output, radius, x0, x1);
+            }
+        }
+    }, strips);
+    dst = output;
+    return true;
+}
+
+} // namespace kernels
+
+#endif // HISTOGRAM_MEDIAN_H
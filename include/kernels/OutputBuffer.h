@@ -0,0 +1,42 @@
+#ifndef KERNELS_OUTPUT_BUFFER_H
+#define KERNELS_OUTPUT_BUFFER_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+
+namespace kernels {
+
+/**
+ * @brief Check whether the pixels of two images share memory
+ */
+inline bool overlaps(const cv::Mat& a, const cv::Mat& b) {
+    if (a.empty() || b.empty()) {
+        return false;
+    }
+    const uint8_t* aEnd = a.ptr(a.rows - 1) + a.cols * a.elemSize();
+    const uint8_t* bEnd = b.ptr(b.rows - 1) + b.cols * b.elemSize();
+    return a.data < bEnd && b.data < aEnd;
+}
+
+/**
+ * @brief Image a kernel writes its result into
+ *
+ * dst itself when it already has the result format and does not overlap
+ * src (a preallocated output, e.g. a shared-memory slot, is filled in
+ * place), otherwise a new image.
+ *
+ * @param src The kernel input
+ * @param dst The output given to the kernel
+ * @param size Size of the result
+ * @param type Type of the result
+ */
+inline cv::Mat outputBuffer(const cv::Mat& src, const cv::Mat& dst, const cv::Size& size, int type) {
+    if (dst.size() == size && dst.type() == type && !overlaps(src, dst)) {
+        return dst;
+    }
+    return cv::Mat(size, type);
+}
+
+} // namespace kernels
+
+#endif // KERNELS_OUTPUT_BUFFER_H
@@ -0,0 +1,293 @@
+#ifndef POINTWISE_ROWS_H
+#define POINTWISE_ROWS_H
+
+#include "Simd.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Row kernels of pointwise 8-bit treatments
+ *
+ * Each kernel processes one row of bytes (SSE2/AVX2/NEON with a scalar
+ * tail) and is small enough to inline, so a sequence of pointwise stages can
+ * run row by row without full-frame intermediates. Tables and thresholds are
+ * built by constexpr functions: stages whose parameters are template
+ * arguments get them at compile time.
+ *
+ * Arithmetic matches cv::Mat::convertTo (8U -> 8U, single precision
+ * multiply-add rounded half to even) and cv::threshold on 8-bit images.
+ */
+namespace kernels {
+
+/**
+ * @brief 256-entry byte lookup table
+ */
+struct ByteLut {
+    uint8_t v[256] = {};
+};
+
+/**
+ * @brief Threshold parameters as cv::threshold applies them to 8-bit images
+ */
+struct ByteThreshold {
+    int thresh;      // floor(threshold), compared with v > thresh
+    uint8_t maxval;  // round(maxValue), saturated
+};
+
+/**
+ * @brief Round half to even and saturate to [0, 255] (cvRound + saturate_cast)
+ */
+constexpr uint8_t saturateRound(double v) {
+    if (!(v > 0.0)) {
+        return 0;
+    }
+    if (v >= 255.0) {
+        return 255;
+    }
+    int i = static_cast<int>(v);
+    double frac = v - i;
+    if (frac > 0.5 || (frac == 0.5 && (i & 1))) {
+        ++i;
+    }
+    return static_cast<uint8_t>(i);
+}
+
+/**
+ * @brief Largest integer not greater than v (cvFloor), clamped to [-1, 255]
+ */
+constexpr int floorByte(double v) {
+    if (v < 0.0) {
+        return -1;
+    }
+    if (v >= 255.0) {
+        return 255;
+    }
+    return static_cast<int>(v);
+}
+
+/**
+ * @brief Table of output = saturate(alpha * input + beta), as convertTo computes it
+ *
+ * convertTo multiplies and adds in single precision with a fused multiply-add;
+ * the exact product of two floats fits in a double, so rounding the double
+ * sum to float gives the same value.
+ */
+constexpr ByteLut brightnessLut(double alpha, double beta) {
+    ByteLut lut;
+    double a = static_cast<float>(alpha);
+    double b = static_cast<float>(beta);
+    for (int v = 0; v < 256; ++v) {
+        lut.v[v] = saturateRound(static_cast<float>(v * a + b));
+    }
+    return lut;
+}
+
+/**
+ * @brief Threshold and maximum value as cv::threshold uses them for 8-bit images
+ */
+constexpr ByteThreshold byteThreshold(double thresh, double maxValue) {
+    return {floorByte(thresh), saturateRound(maxValue)};
+}
+
+/**
+ * @brief dst[i] = lut[src[i]] for n bytes (in place allowed)
+ */
+inline void lutRow(const uint8_t* src, uint8_t* dst, int n, const ByteLut& lut) {
+    for (int i = 0; i < n; ++i) {
+        dst[i] = lut.v[src[i]];
+    }
+}
+
+/**
+ * @brief dst[i] = saturate(alpha * src[i] + beta), bit-exact with brightnessLut()
+ *
+ * With FMA (and on AArch64) this is convertTo's single-precision fused
+ * multiply-add. Otherwise the product and sum are computed in double precision
+ * (the product of two floats is exact there) and rounded to float, which gives
+ * the same value. Either way the result is rounded half to even. Rows without
+ * a SIMD path use the table instead.
+ */
+inline void brightnessRow(const uint8_t* src, uint8_t* dst, int n, double alpha, double beta, const ByteLut& lut) {
+    int i = 0;
+#if IT_SIMD_AVX2 && (defined(__FMA__) || defined(_MSC_VER))
+    // Single-precision fused multiply-add, exactly as convertTo
+    const __m256 a = _mm256_set1_ps(static_cast<float>(alpha));
+    const __m256 b = _mm256_set1_ps(static_cast<float>(beta));
+    const __m256 lo = _mm256_set1_ps(-1.0f), hi = _mm256_set1_ps(256.0f);
+    auto eight = [&](__m128i bytes) {
+        __m256 f = _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes)), a, b);
+        return _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(f, lo), hi));
+    };
+    for (; i <= n - 16; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m256i w = _mm256_permute4x64_epi64(_mm256_packs_epi32(eight(v), eight(_mm_srli_si128(v, 8))), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         _mm_packus_epi16(_mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1)));
+    }
+#elif IT_SIMD_AVX2
+    const __m256d a = _mm256_set1_pd(static_cast<float>(alpha));
+    const __m256d b = _mm256_set1_pd(static_cast<float>(beta));
+    const __m256 lo = _mm256_set1_ps(-1.0f), hi = _mm256_set1_ps(256.0f);
+    auto eight = [&](__m128i bytes) {
+        __m256i v = _mm256_cvtepu8_epi32(bytes);
+        __m128 f0 = _mm256_cvtpd_ps(_mm256_add_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), a), b));
+        __m128 f1 = _mm256_cvtpd_ps(_mm256_add_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), a), b));
+        __m256 f = _mm256_min_ps(_mm256_max_ps(_mm256_set_m128(f1, f0), lo), hi);
+        return _mm256_cvtps_epi32(f);
+    };
+    for (; i <= n - 16; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m256i w = _mm256_permute4x64_epi64(_mm256_packs_epi32(eight(v), eight(_mm_srli_si128(v, 8))), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         _mm_packus_epi16(_mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1)));
+    }
+#elif IT_SIMD_SSE2
+    const __m128d a = _mm_set1_pd(static_cast<float>(alpha));
+    const __m128d b = _mm_set1_pd(static_cast<float>(beta));
+    const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(256.0f);
+    const __m128i zero = _mm_setzero_si128();
+    auto four = [&](__m128i v) {
+        __m128 f0 = _mm_cvtpd_ps(_mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(v), a), b));
+        __m128 f1 = _mm_cvtpd_ps(_mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), a), b));
+        __m128 f = _mm_min_ps(_mm_max_ps(_mm_movelh_ps(f0, f1), lo), hi);
+        return _mm_cvtps_epi32(f);
+    };
+    for (; i <= n - 16; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i w0 = _mm_unpacklo_epi8(v, zero), w1 = _mm_unpackhi_epi8(v, zero);
+        __m128i p0 = _mm_packs_epi32(four(_mm_unpacklo_epi16(w0, zero)), four(_mm_unpackhi_epi16(w0, zero)));
+        __m128i p1 = _mm_packs_epi32(four(_mm_unpacklo_epi16(w1, zero)), four(_mm_unpackhi_epi16(w1, zero)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(p0, p1));
+    }
+#elif IT_SIMD_NEON && defined(__aarch64__)
+    // Single-precision fused multiply-add, exactly as convertTo
+    const float32x4_t a = vdupq_n_f32(static_cast<float>(alpha));
+    const float32x4_t b = vdupq_n_f32(static_cast<float>(beta));
+    auto four = [&](uint16x4_t v) {
+        return vcvtnq_s32_f32(vfmaq_f32(b, vcvtq_f32_u32(vmovl_u16(v)), a));
+    };
+    for (; i <= n - 16; i += 16) {
+        uint8x16_t v = vld1q_u8(src + i);
+        uint16x8_t w0 = vmovl_u8(vget_low_u8(v)), w1 = vmovl_u8(vget_high_u8(v));
+        int16x8_t p0 = vcombine_s16(vqmovn_s32(four(vget_low_u16(w0))), vqmovn_s32(four(vget_high_u16(w0))));
+        int16x8_t p1 = vcombine_s16(vqmovn_s32(four(vget_low_u16(w1))), vqmovn_s32(four(vget_high_u16(w1))));
+        vst1q_u8(dst + i, vcombine_u8(vqmovun_s16(p0), vqmovun_s16(p1)));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = lut.v[src[i]];
+    }
+}
+
+/**
+ * @brief cv::threshold of n bytes for one threshold type (in place allowed)
+ * @param thresh Threshold from byteThreshold(), in [-1, 255]
+ */
+template <int Type>
+inline void thresholdRow(const uint8_t* src, uint8_t* dst, int n, int thresh, uint8_t maxval) {
+    static_assert(Type >= cv::THRESH_BINARY && Type <= cv::THRESH_TOZERO_INV, "Unsupported threshold type");
+    if (thresh < 0 || thresh >= 255) {
+        // Every pixel is above (thresh < 0) or none is (thresh >= 255)
+        const bool above = thresh < 0;
+        if ((Type == cv::THRESH_TOZERO && above) ||
+            ((Type == cv::THRESH_TRUNC || Type == cv::THRESH_TOZERO_INV) && !above)) {
+            std::memmove(dst, src, n);
+        } else {
+            bool keepMax = (Type == cv::THRESH_BINARY && above) || (Type == cv::THRESH_BINARY_INV && !above);
+            std::memset(dst, keepMax ? maxval : 0, n);
+        }
+        return;
+    }
+    const uint8_t t = static_cast<uint8_t>(thresh);
+    int i = 0;
+#if IT_SIMD_AVX2 || IT_SIMD_SSE2
+    // v > t  <=>  max(v, t + 1) == v
+    const __m128i t1 = _mm_set1_epi8(static_cast<char>(t + 1));
+    const __m128i tv = _mm_set1_epi8(static_cast<char>(t));
+    const __m128i mv = _mm_set1_epi8(static_cast<char>(maxval));
+    for (; i <= n - 16; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i above = _mm_cmpeq_epi8(_mm_max_epu8(v, t1), v);
+        __m128i r;
+        if (Type == cv::THRESH_BINARY) {
+            r = _mm_and_si128(above, mv);
+        } else if (Type == cv::THRESH_BINARY_INV) {
+            r = _mm_andnot_si128(above, mv);
+        } else if (Type == cv::THRESH_TRUNC) {
+            r = _mm_or_si128(_mm_and_si128(above, tv), _mm_andnot_si128(above, v));
+        } else if (Type == cv::THRESH_TOZERO) {
+            r = _mm_and_si128(above, v);
+        } else {
+            r = _mm_andnot_si128(above, v);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), r);
+    }
+#elif IT_SIMD_NEON
+    const uint8x16_t tv = vdupq_n_u8(t);
+    const uint8x16_t mv = vdupq_n_u8(maxval);
+    const uint8x16_t zero = vdupq_n_u8(0);
+    for (; i <= n - 16; i += 16) {
+        uint8x16_t v = vld1q_u8(src + i);
+        uint8x16_t above = vcgtq_u8(v, tv);
+        uint8x16_t r;
+        if (Type == cv::THRESH_BINARY) {
+            r = vandq_u8(above, mv);
+        } else if (Type == cv::THRESH_BINARY_INV) {
+            r = vbicq_u8(mv, above);
+        } else if (Type == cv::THRESH_TRUNC) {
+            r = vbslq_u8(above, tv, v);
+        } else if (Type == cv::THRESH_TOZERO) {
+            r = vbslq_u8(above, v, zero);
+        } else {
+            r = vbicq_u8(v, above);
+        }
+        vst1q_u8(dst + i, r);
+    }
+#endif
+    for (; i < n; ++i) {
+        uint8_t v = src[i];
+        bool above = v > t;
+        if (Type == cv::THRESH_BINARY) {
+            dst[i] = above ? maxval : 0;
+        } else if (Type == cv::THRESH_BINARY_INV) {
+            dst[i] = above ? 0 : maxval;
+        } else if (Type == cv::THRESH_TRUNC) {
+            dst[i] = above ? t : v;
+        } else if (Type == cv::THRESH_TOZERO) {
+            dst[i] = above ? v : 0;
+        } else {
+            dst[i] = above ? 0 : v;
+        }
+    }
+}
+
+/**
+ * @brief Check whether thresholdRow() handles a threshold type
+ * @return true for the five basic types, without THRESH_OTSU / THRESH_TRIANGLE flags
+ */
+inline bool canUseThresholdRow(int type) {
+    return type >= cv::THRESH_BINARY && type <= cv::THRESH_TOZERO_INV;
+}
+
+/**
+ * @brief cv::threshold of n bytes, threshold type chosen at run time
+ * @throws std::invalid_argument for a type canUseThresholdRow() refuses
+ */
+inline void thresholdRow(const uint8_t* src, uint8_t* dst, int n, int type, int thresh, uint8_t maxval) {
+    switch (type) {
+        case cv::THRESH_BINARY: thresholdRow<cv::THRESH_BINARY>(src, dst, n, thresh, maxval); break;
+        case cv::THRESH_BINARY_INV: thresholdRow<cv::THRESH_BINARY_INV>(src, dst, n, thresh, maxval); break;
+        case cv::THRESH_TRUNC: thresholdRow<cv::THRESH_TRUNC>(src, dst, n, thresh, maxval); break;
+        case cv::THRESH_TOZERO: thresholdRow<cv::THRESH_TOZERO>(src, dst, n, thresh, maxval); break;
+        case cv::THRESH_TOZERO_INV: thresholdRow<cv::THRESH_TOZERO_INV>(src, dst, n, thresh, maxval); break;
+        default: throw std::invalid_argument("Unsupported threshold type for a row: " + std::to_string(type));
+    }
+}
+
+} // namespace kernels
+
+#endif // POINTWISE_ROWS_H
@@ -0,0 +1,32 @@
+#ifndef KERNELS_SIMD_H
+#define KERNELS_SIMD_H
+
+/**
+ * @brief Compile-time SIMD selection for the hand-vectorized kernels
+ * 
+ * Exactly one of IT_SIMD_AVX2, IT_SIMD_SSE2 or IT_SIMD_NEON is set to 1
+ * depending on the target; all are 0 when only scalar code is available.
+ * SSE2 is the x86-64 baseline, AVX2 is enabled by the ENABLE_AVX2 CMake option.
+ */
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define IT_SIMD_AVX2 1
+    #define IT_SIMD_SSE2 0
+    #define IT_SIMD_NEON 0
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define IT_SIMD_AVX2 0
+    #define IT_SIMD_SSE2 1
+    #define IT_SIMD_NEON 0
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define IT_SIMD_AVX2 0
+    #define IT_SIMD_SSE2 0
+    #define IT_SIMD_NEON 1
+#else
+    #define IT_SIMD_AVX2 0
+    #define IT_SIMD_SSE2 0
+    #define IT_SIMD_NEON 0
+#endif
+
+#endif // KERNELS_SIMD_H
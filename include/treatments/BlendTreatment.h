@@ -0,0 +1,102 @@
+#ifndef BLEND_TREATMENT_H
+#define BLEND_TREATMENT_H
+
+#include "../MergeTreatment.h"
+
+/**
+ * @brief Blends two images
+ *
+ * Formula: output = (1 - alpha) * first + alpha * second
+ * A grayscale input is expanded to the channel count of the other one, which
+ * must then be BGR or BGRA; other inputs must have the same channel count.
+ */
+class BlendTreatment : public MergeTreatment {
+private:
+    double alpha;  // Weight of the second input (0.0-1.0)
+
+    static cv::Mat expandChannels(const cv::Mat& image, int channels) {
+        cv::Mat expanded;
+        cv::cvtColor(image, expanded, channels == 4 ? cv::COLOR_GRAY2BGRA : cv::COLOR_GRAY2BGR);
+        return expanded;
+    }
+
+public:
+    BlendTreatment(double a = 0.5)
+        : alpha(a) {}
+
+    cv::Mat merge(const std::vector<cv::Mat>& inputs) override {
+        cv::Mat first = inputs[0];
+        cv::Mat second = inputs[1];
+        if (first.channels() == 1 && second.channels() > 1) {
+            first = expandChannels(first, second.channels());
+        } else if (second.channels() == 1 && first.channels() > 1) {
+            second = expandChannels(second, first.channels());
+        }
+        if (second.depth() != first.depth()) {
+            second.convertTo(second, first.type());
+        }
+
+        cv::Mat output;
+        cv::addWeighted(first, 1.0 - alpha, second, alpha, 0.0, output);
+        return output;
+    }
+
+    size_t getInputCount() const override {
+        return 2;
+    }
+
+    std::string getName() const override {
+        return "Blend";
+    }
+
+    std::string getDescription() const override {
+        return "Blends two images (output = (1 - alpha) * first + alpha * second)";
+    }
+
+    std::map<std::string, std::string> getParameters() const override {
+        std::map<std::string, std::string> params;
+        params["alpha"] = std::to_string(alpha);
+        return params;
+    }
+
+    std::map<std::string, double> getParameterValues() const override {
+        return {{"alpha", alpha}};
+    }
+
+    bool setParameter(const std::string& paramName, const std::string& value) override {
+        try {
+            if (paramName == "alpha") {
+                double val = std::stod(value);
+                if (val >= 0.0 && val <= 1.0) {
+                    alpha = val;
+                    return true;
+                }
+            }
+        } catch (...) {
+            return false;
+        }
+        return false;
+    }
+
+    std::map<std::string, std::string> getParameterInfo() const override {
+        std::map<std::string, std::string> info;
+        info["alpha"] = "double (0.0-1.0) - Weight of the second input";
+        return info;
+    }
+
+    std::unique_ptr<Treatment> clone() const override {
+        return std::make_unique<BlendTreatment>(alpha);
+    }
+
+    bool validateInputs(const std::vector<cv::Mat>& inputs) const override {
+        if (!MergeTreatment::validateInputs(inputs)) {
+            return false;
+        }
+        int c0 = inputs[0].channels();
+        int c1 = inputs[1].channels();
+        // A gray input is expanded to the color one (BGR or BGRA)
+        return c0 == c1 || (c0 == 1 && (c1 == 3 || c1 == 4)) || (c1 == 1 && (c0 == 3 || c0 == 4));
+    }
+};
+
+#endif // BLEND_TREATMENT_H
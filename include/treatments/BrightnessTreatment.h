@@ -2,6 +2,8 @@
 #define BRIGHTNESS_TREATMENT_H
 
 #include "../Treatment.h"
+#include "../kernels/PointwiseRows.h"
+#include <algorithm>
 #include <sstream>
 
 /**
@@ -10,22 +12,53 @@
  * Formula: output = alpha * input + beta
  * - alpha: contrast control (1.0-3.0 typical)
  * - beta: brightness control (-100 to 100 typical)
+ *
+ * 8-bit images are processed row by row with the vectorized kernel of
+ * kernels/PointwiseRows.h; its lookup table is built by prepare().
  */
 class BrightnessTreatment : public Treatment {
 private:
     double alpha;  // Contrast multiplier
     double beta;   // Brightness offset
 
+    kernels::ByteLut lut;    // alpha * v + beta for every byte value
+    bool lutReady = false;
+
 public:
     BrightnessTreatment(double a = 1.0, double b = 0.0)
         : alpha(a), beta(b) {}
 
+    ImageFormat prepare(const cv::Size& inputSize, int inputType) override {
+        if (!lutReady && CV_MAT_DEPTH(inputType) == CV_8U) {
+            lut = kernels::brightnessLut(alpha, beta);
+            lutReady = true;
+        }
+        return {inputSize, inputType};
+    }
+
     cv::Mat process(const cv::Mat& input) override {
         cv::Mat output;
-        input.convertTo(output, -1, alpha, beta);
+        processInto(input, output);
         return output;
     }
 
+    void processInto(const cv::Mat& input, cv::Mat& output) override {
+        if (input.depth() != CV_8U) {
+            input.convertTo(output, -1, alpha, beta);
+            return;
+        }
+
+        prepare(input.size(), input.type());
+        output.create(input.size(), input.type());
+        const int n = input.cols * input.channels();
+        int nstripes = std::max(1, std::min(cv::getNumThreads() * 4, input.rows / 64));
+        cv::parallel_for_(cv::Range(0, input.rows), [&](const cv::Range& range) {
+            for (int y = range.start; y < range.end; ++y) {
+                kernels::brightnessRow(input.ptr<uint8_t>(y), output.ptr<uint8_t>(y), n, alpha, beta, lut);
+            }
+        }, nstripes);
+    }
+
     std::string getName() const override {
         return "Brightness/Contrast";
     }
@@ -41,13 +74,19 @@ public:
         return params;
     }
 
+    std::map<std::string, double> getParameterValues() const override {
+        return {{"alpha", alpha}, {"beta", beta}};
+    }
+
     bool setParameter(const std::string& paramName, const std::string& value) override {
         try {
             if (paramName == "alpha") {
                 alpha = std::stod(value);
+                lutReady = false;
                 return true;
             } else if (paramName == "beta") {
                 beta = std::stod(value);
+                lutReady = false;
                 return true;
             }
         } catch (...) {
@@ -66,6 +105,22 @@ public:
     std::unique_ptr<Treatment> clone() const override {
         return std::make_unique<BrightnessTreatment>(alpha, beta);
     }
+
+    /**
+     * @brief Get the contrast multiplier
+     * @return alpha
+     */
+    double getAlpha() const {
+        return alpha;
+    }
+
+    /**
+     * @brief Get the brightness offset
+     * @return beta
+     */
+    double getBeta() const {
+        return beta;
+    }
 };
 
 #endif // BRIGHTNESS_TREATMENT_H
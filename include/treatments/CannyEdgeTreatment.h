@@ -2,44 +2,172 @@
 #define CANNY_EDGE_TREATMENT_H
 
 #include "../Treatment.h"
+#include <cstring>
 #include <sstream>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Gradient field of an image, the expensive half of Canny
+ * 
+ * Holds the Sobel derivatives cv::Canny computes internally, so non-maximum
+ * suppression and hysteresis can be rerun with other thresholds.
+ */
+struct CannyGradient {
+    cv::Mat dx;                 // Horizontal derivative (CV_16S)
+    cv::Mat dy;                 // Vertical derivative (CV_16S)
+    double thresholdScale = 1;  // Applied to the thresholds (1/16 for aperture 7, like cv::Canny)
+};
 
 /**
  * @brief Applies Canny edge detection to an image
  * 
  * The Canny edge detector is a multi-stage algorithm for detecting
  * edges in images. It produces a binary image showing the detected edges.
+ * 
+ * It is split in two stages: the gradient field (Sobel derivatives) and
+ * thresholding (non-maximum suppression and hysteresis). With cacheGradient
+ * enabled, the gradient of the last input is kept and reused while the input
+ * is unchanged, so tuning threshold1/threshold2 only reruns the cheap stage.
+ * The cache costs a comparison and a copy of every input, so it is off by
+ * default and meant for previews that rerun the same image, not for streams.
+ * Results are identical to cv::Canny.
  */
 class CannyEdgeTreatment : public Treatment {
 private:
     double threshold1;  // First threshold for the hysteresis procedure
     double threshold2;  // Second threshold for the hysteresis procedure
     int apertureSize;   // Aperture size for the Sobel operator (must be 3, 5, or 7)
+    bool cacheGradient; // Keep the gradient of the last input
+
+    cv::Mat cachedInput;          // Grayscale input the cached gradient belongs to
+    CannyGradient cachedGradient;
+
+    /**
+     * @brief Convert the input to grayscale if needed
+     */
+    static cv::Mat toGray(const cv::Mat& input) {
+        cv::Mat gray;
+        if (input.channels() == 3) {
+            cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
+        } else {
+            gray = input;
+        }
+        return gray;
+    }
+
+    /**
+     * @brief Check whether two images have the same size, type and pixels
+     */
+    static bool sameImage(const cv::Mat& a, const cv::Mat& b) {
+        if (a.size() != b.size() || a.type() != b.type()) {
+            return false;
+        }
+        const size_t rowBytes = a.cols * a.elemSize();
+        for (int y = 0; y < a.rows; ++y) {
+            if (std::memcmp(a.ptr(y), b.ptr(y), rowBytes) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Gradient of a grayscale image, from the cache when possible
+     */
+    const CannyGradient& gradientOf(const cv::Mat& gray) {
+        if (cachedGradient.dx.empty() || !sameImage(gray, cachedInput)) {
+            cachedGradient = computeGradient(gray);
+            cachedInput = gray.clone();
+        }
+        return cachedGradient;
+    }
+
+    void clearCache() {
+        cachedInput.release();
+        cachedGradient = CannyGradient();
+    }
 
 public:
-    CannyEdgeTreatment(double t1 = 50.0, double t2 = 150.0, int aperture = 3)
-        : threshold1(t1), threshold2(t2), apertureSize(aperture) {
+    CannyEdgeTreatment(double t1 = 50.0, double t2 = 150.0, int aperture = 3, bool cache = false)
+        : threshold1(t1), threshold2(t2), apertureSize(aperture), cacheGradient(cache) {
         // Ensure aperture size is valid (3, 5, or 7)
         if (apertureSize != 3 && apertureSize != 5 && apertureSize != 7) {
             apertureSize = 3;
         }
     }
 
+    ImageFormat prepare(const cv::Size& inputSize, int inputType) override {
+        return {inputSize, CV_8UC1};
+    }
+
     cv::Mat process(const cv::Mat& input) override {
         cv::Mat output;
-        cv::Mat gray;
-        
-        // Convert to grayscale if needed
-        if (input.channels() == 3) {
-            cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
-        } else {
-            gray = input;
+        processInto(input, output);
+        return output;
+    }
+
+    void processInto(const cv::Mat& input, cv::Mat& output) override {
+        cv::Mat gray = toGray(input);
+
+        if (cacheGradient) {
+            storeResult(edgesFromGradient(gradientOf(gray), threshold1, threshold2), output);
+            return;
         }
-        
         cv::Canny(gray, output, threshold1, threshold2, apertureSize);
+    }
+
+    /**
+     * @brief Compute the gradient field cv::Canny would use for an image
+     * @param input The input image (grayscale or BGR)
+     * @return Sobel derivatives with replicated borders
+     */
+    CannyGradient computeGradient(const cv::Mat& input) const {
+        cv::Mat gray = toGray(input);
+        CannyGradient gradient;
+        // cv::Canny scales the 7x7 Sobel down to stay within 16 bits
+        double scale = (apertureSize == 7) ? 1.0 / 16.0 : 1.0;
+        cv::Sobel(gray, gradient.dx, CV_16S, 1, 0, apertureSize, scale, 0, cv::BORDER_REPLICATE);
+        cv::Sobel(gray, gradient.dy, CV_16S, 0, 1, apertureSize, scale, 0, cv::BORDER_REPLICATE);
+        gradient.thresholdScale = scale;
+        return gradient;
+    }
+
+    /**
+     * @brief Run non-maximum suppression and hysteresis on a gradient field
+     * @param gradient Gradient from computeGradient()
+     * @param t1 First hysteresis threshold
+     * @param t2 Second hysteresis threshold
+     * @return Binary edge map
+     */
+    cv::Mat edgesFromGradient(const CannyGradient& gradient, double t1, double t2) const {
+        cv::Mat output;
+        cv::Canny(gradient.dx, gradient.dy, output,
+                  t1 * gradient.thresholdScale, t2 * gradient.thresholdScale);
         return output;
     }
 
+    /**
+     * @brief Produce several edge maps of one image at different sensitivities
+     * @param input The input image
+     * @param thresholds (threshold1, threshold2) pairs
+     * @return One edge map per pair, sharing a single gradient computation
+     */
+    std::vector<cv::Mat> processThresholds(const cv::Mat& input,
+                                           const std::vector<std::pair<double, double>>& thresholds) {
+        if (!validateInput(input)) {
+            throw std::invalid_argument("Canny needs a non-empty 1 or 3 channel image");
+        }
+        cv::Mat gray = toGray(input);
+        CannyGradient gradient = cacheGradient ? gradientOf(gray) : computeGradient(gray);
+        std::vector<cv::Mat> edges;
+        edges.reserve(thresholds.size());
+        for (const auto& t : thresholds) {
+            edges.push_back(edgesFromGradient(gradient, t.first, t.second));
+        }
+        return edges;
+    }
+
     std::string getName() const override {
         return "Canny Edge Detection";
     }
@@ -53,9 +181,15 @@ public:
         params["threshold1"] = std::to_string(threshold1);
         params["threshold2"] = std::to_string(threshold2);
         params["apertureSize"] = std::to_string(apertureSize);
+        params["cacheGradient"] = std::to_string(cacheGradient ? 1 : 0);
         return params;
     }
 
+    std::map<std::string, double> getParameterValues() const override {
+        return {{"threshold1", threshold1}, {"threshold2", threshold2}, {"apertureSize", apertureSize},
+                {"cacheGradient", cacheGradient ? 1.0 : 0.0}};
+    }
+
     bool setParameter(const std::string& paramName, const std::string& value) override {
         try {
             if (paramName == "threshold1") {
@@ -67,9 +201,21 @@ public:
             } else if (paramName == "apertureSize") {
                 int val = std::stoi(value);
                 if (val == 3 || val == 5 || val == 7) {
+                    if (val != apertureSize) {
+                        clearCache();
+                    }
                     apertureSize = val;
                     return true;
                 }
+            } else if (paramName == "cacheGradient") {
+                int val = std::stoi(value);
+                if (val == 0 || val == 1) {
+                    cacheGradient = (val == 1);
+                    if (!cacheGradient) {
+                        clearCache();
+                    }
+                    return true;
+                }
             }
         } catch (...) {
             return false;
@@ -82,15 +228,48 @@ public:
         info["threshold1"] = "double - First threshold for hysteresis";
         info["threshold2"] = "double - Second threshold for hysteresis";
         info["apertureSize"] = "int (3, 5, or 7) - Sobel aperture size";
+        info["cacheGradient"] = "int (0 or 1) - Reuse the gradient while the input is unchanged";
         return info;
     }
 
     std::unique_ptr<Treatment> clone() const override {
-        return std::make_unique<CannyEdgeTreatment>(threshold1, threshold2, apertureSize);
+        return std::make_unique<CannyEdgeTreatment>(threshold1, threshold2, apertureSize, cacheGradient);
+    }
+
+    int getBorderRadius() const override {
+        return -1;  // Hysteresis can follow an edge across the whole image
+    }
+
+    FormatTraits getFormatTraits() const override {
+        FormatTraits traits;
+        traits.channels = {1, 3};
+        traits.depths = {CV_8U};
+        traits.lumaOnly = true;
+        return traits;
+    }
+
+    /**
+     * @brief Get the first hysteresis threshold
+     * @return Threshold
+     */
+    double getThreshold1() const {
+        return threshold1;
+    }
+
+    /**
+     * @brief Get the second hysteresis threshold
+     * @return Threshold
+     */
+    double getThreshold2() const {
+        return threshold2;
     }
 
-    bool validateInput(const cv::Mat& input) const override {
-        return !input.empty() && (input.channels() == 1 || input.channels() == 3);
+    /**
+     * @brief Get the Sobel aperture size
+     * @return 3, 5 or 7
+     */
+    int getApertureSize() const {
+        return apertureSize;
     }
 };
 
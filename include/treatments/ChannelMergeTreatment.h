@@ -0,0 +1,75 @@
+#ifndef CHANNEL_MERGE_TREATMENT_H
+#define CHANNEL_MERGE_TREATMENT_H
+
+#include "../MergeTreatment.h"
+
+/**
+ * @brief Builds a multi-channel image from single-channel inputs
+ *
+ * Input i becomes channel i of the output (B, G, R, A order for 3 or 4 inputs).
+ */
+class ChannelMergeTreatment : public MergeTreatment {
+private:
+    int channels;  // Number of inputs / output channels (2-4), fixed at construction
+
+public:
+    /**
+     * @param ch Number of single-channel inputs, clamped to 2-4; it cannot change
+     *           afterwards since a ProcessingGraph wires the inputs when the node is added
+     */
+    ChannelMergeTreatment(int ch = 3)
+        : channels(std::max(2, std::min(ch, 4))) {}
+
+    cv::Mat merge(const std::vector<cv::Mat>& inputs) override {
+        cv::Mat output;
+        cv::merge(inputs, output);
+        return output;
+    }
+
+    size_t getInputCount() const override {
+        return static_cast<size_t>(channels);
+    }
+
+    std::string getName() const override {
+        return "Channel Merge";
+    }
+
+    std::string getDescription() const override {
+        return "Merges single-channel images into the channels of one image";
+    }
+
+    std::map<std::string, std::string> getParameters() const override {
+        std::map<std::string, std::string> params;
+        params["channels"] = std::to_string(channels);
+        return params;
+    }
+
+    bool setParameter(const std::string& paramName, const std::string& value) override {
+        // "channels" is the input count, fixed at construction
+        return false;
+    }
+
+    std::map<std::string, std::string> getParameterInfo() const override {
+        std::map<std::string, std::string> info;
+        info["channels"] = "int (2-4) - Number of single-channel inputs (fixed at construction)";
+        return info;
+    }
+
+    std::unique_ptr<Treatment> clone() const override {
+        return std::make_unique<ChannelMergeTreatment>(channels);
+    }
+
+    bool validateInputs(const std::vector<cv::Mat>& inputs) const override {
+        if (!MergeTreatment::validateInputs(inputs)) {
+            return false;
+        }
+        for (const cv::Mat& input : inputs) {
+            if (input.channels() != 1 || input.depth() != inputs[0].depth()) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif // CHANNEL_MERGE_TREATMENT_H
@@ -2,18 +2,24 @@
 #define DILATION_TREATMENT_H
 
 #include "../Treatment.h"
+#include "../kernels/VanHerkMorphology.h"
 
 /**
  * @brief Applies morphological dilation to an image
  * 
  * Dilation expands the boundaries of foreground objects.
  * It's useful for filling small holes, connecting nearby objects, etc.
+ *
+ * Large elements go through the van Herk/Gil-Werman kernel, whose cost
+ * does not grow with the element area; results are identical.
  */
 class DilationTreatment : public Treatment {
 private:
     int kernelSize;    // Size of the structuring element
     int kernelShape;   // Shape: 0=RECT, 1=CROSS, 2=ELLIPSE
     int iterations;    // Number of times dilation is applied
+    cv::Mat element;               // Built by prepare() for the current parameters
+    kernels::MorphologyPlan plan;  // van Herk decomposition, when that path is preferred
 
 public:
     DilationTreatment(int kSize = 3, int shape = cv::MORPH_RECT, int iter = 1)
@@ -22,16 +28,34 @@ public:
         if (iterations < 1) iterations = 1;
     }
 
+    ImageFormat prepare(const cv::Size& inputSize, int inputType) override {
+        if (element.empty()) {
+            element = cv::getStructuringElement(kernelShape, cv::Size(kernelSize, kernelSize));
+            plan = kernels::preferVanHerk(kernelShape, kernelSize, iterations)
+                 ? kernels::planMorphologyVanHerk(kernelShape, kernelSize, iterations)
+                 : kernels::MorphologyPlan();
+        }
+        return {inputSize, inputType};
+    }
+
     cv::Mat process(const cv::Mat& input) override {
         cv::Mat output;
-        cv::Mat element = cv::getStructuringElement(
-            kernelShape,
-            cv::Size(kernelSize, kernelSize)
-        );
-        cv::dilate(input, output, element, cv::Point(-1, -1), iterations);
+        processInto(input, output);
         return output;
     }
 
+    void processInto(const cv::Mat& input, cv::Mat& output) override {
+        prepare(input.size(), input.type());
+        if (plan.iterations > 0) {
+            cv::Mat result;
+            if (kernels::morphologyVanHerk(input, result, true, plan)) {
+                storeResult(result, output);
+                return;
+            }
+        }
+        cv::dilate(input, output, element, cv::Point(-1, -1), iterations);
+    }
+
     std::string getName() const override {
         return "Dilation";
     }
@@ -54,18 +78,21 @@ public:
                 int val = std::stoi(value);
                 if (val > 0) {
                     kernelSize = val;
+                    element.release();
                     return true;
                 }
             } else if (paramName == "kernelShape") {
                 int val = std::stoi(value);
                 if (val >= 0 && val <= 2) {
                     kernelShape = val;
+                    element.release();
                     return true;
                 }
             } else if (paramName == "iterations") {
                 int val = std::stoi(value);
                 if (val > 0) {
                     iterations = val;
+                    element.release();
                     return true;
                 }
             }
@@ -86,6 +113,15 @@ public:
     std::unique_ptr<Treatment> clone() const override {
         return std::make_unique<DilationTreatment>(kernelSize, kernelShape, iterations);
     }
+
+    std::unique_ptr<Treatment> cloneScaled(double scale) const override {
+        return std::make_unique<DilationTreatment>(scaleKernelSize(kernelSize, scale), kernelShape, iterations);
+    }
+
+    int getBorderRadius() const override {
+        // Each iteration grows the footprint by the element's half-size
+        return (kernelSize / 2) * iterations;
+    }
 };
 
 #endif // DILATION_TREATMENT_H
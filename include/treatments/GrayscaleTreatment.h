@@ -13,19 +13,29 @@ class GrayscaleTreatment : public Treatment {
 public:
     GrayscaleTreatment() = default;
 
+    ImageFormat prepare(const cv::Size& inputSize, int inputType) override {
+        int channels = CV_MAT_CN(inputType);
+        if (channels == 3 || channels == 4) {
+            return {inputSize, CV_MAKETYPE(CV_MAT_DEPTH(inputType), 1)};
+        }
+        return {inputSize, inputType};
+    }
+
     cv::Mat process(const cv::Mat& input) override {
         cv::Mat output;
-        
+        processInto(input, output);
+        return output;
+    }
+
+    void processInto(const cv::Mat& input, cv::Mat& output) override {
         if (input.channels() == 3) {
             cv::cvtColor(input, output, cv::COLOR_BGR2GRAY);
         } else if (input.channels() == 4) {
             cv::cvtColor(input, output, cv::COLOR_BGRA2GRAY);
         } else {
-            // Already grayscale
-            output = input.clone();
+            // Already grayscale, just copy
+            input.copyTo(output);
         }
-        
-        return output;
     }
 
     std::string getName() const override {
@@ -51,6 +61,13 @@ public:
     std::unique_ptr<Treatment> clone() const override {
         return std::make_unique<GrayscaleTreatment>();
     }
+
+    FormatTraits getFormatTraits() const override {
+        FormatTraits traits;
+        traits.channels = {1, 3, 4};
+        traits.lumaOnly = true;
+        return traits;
+    }
 };
 
 #endif // GRAYSCALE_TREATMENT_H
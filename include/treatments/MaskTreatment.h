@@ -0,0 +1,81 @@
+#ifndef MASK_TREATMENT_H
+#define MASK_TREATMENT_H
+
+#include "../MergeTreatment.h"
+
+/**
+ * @brief Keeps the pixels of an image where a mask is set
+ *
+ * Inputs: the image, then the mask. Mask pixels that are non-zero keep the
+ * image pixel, the others become black. A color mask is converted to grayscale.
+ */
+class MaskTreatment : public MergeTreatment {
+private:
+    bool invert;  // Keep the pixels where the mask is zero instead
+
+public:
+    MaskTreatment(bool inv = false)
+        : invert(inv) {}
+
+    cv::Mat merge(const std::vector<cv::Mat>& inputs) override {
+        cv::Mat mask = inputs[1];
+        if (mask.channels() == 3) {
+            cv::cvtColor(mask, mask, cv::COLOR_BGR2GRAY);
+        } else if (mask.channels() == 4) {
+            cv::cvtColor(mask, mask, cv::COLOR_BGRA2GRAY);
+        }
+        cv::Mat keep;
+        cv::compare(mask, 0, keep, invert ? cv::CMP_EQ : cv::CMP_NE);
+
+        cv::Mat output = cv::Mat::zeros(inputs[0].size(), inputs[0].type());
+        inputs[0].copyTo(output, keep);
+        return output;
+    }
+
+    size_t getInputCount() const override {
+        return 2;
+    }
+
+    std::string getName() const override {
+        return "Mask";
+    }
+
+    std::string getDescription() const override {
+        return "Keeps the pixels of the first input where the second input is non-zero";
+    }
+
+    std::map<std::string, std::string> getParameters() const override {
+        std::map<std::string, std::string> params;
+        params["invert"] = invert ? "1" : "0";
+        return params;
+    }
+
+    bool setParameter(const std::string& paramName, const std::string& value) override {
+        try {
+            if (paramName == "invert") {
+                invert = std::stoi(value) != 0;
+                return true;
+            }
+        } catch (...) {
+            return false;
+        }
+        return false;
+    }
+
+    std::map<std::string, std::string> getParameterInfo() const override {
+        std::map<std::string, std::string> info;
+        info["invert"] = "bool (0/1) - Keep the pixels where the mask is zero";
+        return info;
+    }
+
+    std::unique_ptr<Treatment> clone() const override {
+        return std::make_unique<MaskTreatment>(invert);
+    }
+
+    bool validateInputs(const std::vector<cv::Mat>& inputs) const override {
+        return MergeTreatment::validateInputs(inputs) && inputs[1].depth() == CV_8U &&
+               (inputs[1].channels() == 1 || inputs[1].channels() == 3 || inputs[1].channels() == 4);
+    }
+};
+
+#endif // MASK_TREATMENT_H
@@ -2,6 +2,7 @@
 #define MEDIAN_BLUR_TREATMENT_H
 
 #include "../Treatment.h"
+#include "../kernels/HistogramMedian.h"
 #include <sstream>
 
 /**
@@ -9,11 +10,18 @@
  * 
  * Median blur is particularly effective at removing salt-and-pepper noise
  * while preserving edges better than Gaussian blur.
+ * Kernels of 7 and above use a histogram-based filter whose cost does not
+ * grow with the kernel (see kernels/HistogramMedian.h), which also handles
+ * 16-bit images that cv::medianBlur only accepts up to a kernel of 5.
  */
 class MedianBlurTreatment : public Treatment {
 private:
     int kernelSize;  // Must be odd and positive
 
+    // Smallest kernel sent to the histogram filter; OpenCV's sorting
+    // networks are faster for 3 and 5
+    static const int histogramMinKernel = 7;
+
 public:
     MedianBlurTreatment(int kSize = 5) : kernelSize(kSize) {
         // Ensure kernel size is odd and positive
@@ -23,10 +31,18 @@ public:
 
     cv::Mat process(const cv::Mat& input) override {
         cv::Mat output;
-        cv::medianBlur(input, output, kernelSize);
+        processInto(input, output);
         return output;
     }
 
+    void processInto(const cv::Mat& input, cv::Mat& output) override {
+        if (kernelSize >= histogramMinKernel &&
+            kernels::medianBlurHistogram(input, output, kernelSize)) {
+            return;
+        }
+        cv::medianBlur(input, output, kernelSize);
+    }
+
     std::string getName() const override {
         return "Median Blur";
     }
@@ -65,6 +81,23 @@ public:
     std::unique_ptr<Treatment> clone() const override {
         return std::make_unique<MedianBlurTreatment>(kernelSize);
     }
+
+    std::unique_ptr<Treatment> cloneScaled(double scale) const override {
+        return std::make_unique<MedianBlurTreatment>(scaleKernelSize(kernelSize, scale));
+    }
+
+    int getBorderRadius() const override {
+        return kernelSize / 2;
+    }
+
+    bool validateInput(const cv::Mat& input) const override {
+        if (input.empty()) {
+            return false;
+        }
+        // Large kernels are only supported for 8-bit and 16-bit images
+        return kernelSize <= 5 || input.depth() == CV_8U ||
+               kernels::canUseHistogramMedian(input, kernelSize);
+    }
 };
 
 #endif // MEDIAN_BLUR_TREATMENT_H
@@ -2,6 +2,7 @@
 #define MOSAICTREATMENT_H
 
 #include "../Treatment.h"
+#include "../kernels/BlockMosaic.h"
 #include <opencv2/opencv.hpp>
 #include <map>
 #include <sstream>
@@ -10,8 +11,9 @@
  * @class MosaicTreatment
  * @brief Applique un effet mosaïque/pixellisation à l'image
  * 
- * Ce traitement crée un effet de pixellisation en réduisant la résolution
- * de l'image puis en la réagrandissant, créant ainsi des blocs de couleur uniforme.
+ * Ce traitement crée un effet de pixellisation en remplaçant chaque bloc de
+ * blockSize x blockSize pixels (grille partant du coin haut-gauche) par la
+ * moyenne exacte de ses pixels, en une seule passe parallèle.
  */
 class MosaicTreatment : public Treatment {
 private:
@@ -40,21 +42,18 @@ public:
         }
 
         cv::Mat result;
-        
-        // Calculer la nouvelle taille réduite
-        int newWidth = std::max(1, image.cols / blockSize);
-        int newHeight = std::max(1, image.rows / blockSize);
-        
-        // Réduire l'image
-        cv::Mat smallImage;
-        cv::resize(image, smallImage, cv::Size(newWidth, newHeight), 0, 0, cv::INTER_LINEAR);
-        
-        // Réagrandir l'image avec interpolation nearest neighbor pour garder l'effet pixelisé
-        cv::resize(smallImage, result, image.size(), 0, 0, cv::INTER_NEAREST);
-        
+        kernels::mosaicBlockAverage(image, result, blockSize);
         return result;
     }
 
+    /**
+     * @brief Applique l'effet mosaïque directement dans l'image, sans allocation
+     * @param image Image modifiée sur place
+     */
+    void processInPlace(cv::Mat& image) const {
+        kernels::mosaicBlockAverage(image, image, blockSize);
+    }
+
     /**
      * @brief Retourne le nom du traitement
      * @return "Mosaic Effect"
@@ -120,6 +119,33 @@ public:
         return std::make_unique<MosaicTreatment>(blockSize);
     }
 
+    /**
+     * @brief Clone le traitement pour une image réduite
+     * @param scale Taille de l'image réduite par rapport à l'image entière
+     * @return Copie avec des blocs réduits dans la même proportion (min: 1)
+     */
+    std::unique_ptr<Treatment> cloneScaled(double scale) const override {
+        return std::make_unique<MosaicTreatment>(std::max(1, static_cast<int>(std::lround(blockSize * scale))));
+    }
+
+    /**
+     * @brief Rayon de voisinage nécessaire
+     * @return -1 : la grille de blocs est ancrée sur l'origine de l'image entière
+     */
+    int getBorderRadius() const override {
+        return -1;
+    }
+
+    /**
+     * @brief Formats acceptés
+     * @return Tous ; la moyenne par bloc est linéaire et indépendante par canal
+     */
+    FormatTraits getFormatTraits() const override {
+        FormatTraits traits;
+        traits.linear = true;
+        return traits;
+    }
+
     /**
      * @brief Définit la taille des blocs de mosaïque
      * @param size Nouvelle taille des blocs (min: 1)
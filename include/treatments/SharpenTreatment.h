@@ -12,29 +12,38 @@
 class SharpenTreatment : public Treatment {
 private:
     double strength;  // Sharpening strength (0.0 to 1.0+)
+    cv::Mat kernel;   // Built by prepare() for the current strength
 
 public:
     SharpenTreatment(double s = 1.0) : strength(s) {}
 
+    ImageFormat prepare(const cv::Size& inputSize, int inputType) override {
+        if (kernel.empty()) {
+            // Basic sharpening kernel:
+            //  0  -1   0
+            // -1   5  -1
+            //  0  -1   0
+            // We scale it based on strength
+            kernel = (cv::Mat_<float>(3, 3) << 
+                0, -1 * strength, 0,
+                -1 * strength, 1 + 4 * strength, -1 * strength,
+                0, -1 * strength, 0
+            );
+        }
+        return {inputSize, inputType};
+    }
+
     cv::Mat process(const cv::Mat& input) override {
         cv::Mat output;
-        
-        // Create sharpening kernel
-        // Basic sharpening kernel:
-        //  0  -1   0
-        // -1   5  -1
-        //  0  -1   0
-        // We scale it based on strength
-        cv::Mat kernel = (cv::Mat_<float>(3, 3) << 
-            0, -1 * strength, 0,
-            -1 * strength, 1 + 4 * strength, -1 * strength,
-            0, -1 * strength, 0
-        );
-        
-        cv::filter2D(input, output, -1, kernel);
+        processInto(input, output);
         return output;
     }
 
+    void processInto(const cv::Mat& input, cv::Mat& output) override {
+        prepare(input.size(), input.type());
+        cv::filter2D(input, output, -1, kernel);
+    }
+
     std::string getName() const override {
         return "Sharpen";
     }
@@ -49,12 +58,17 @@ public:
         return params;
     }
 
+    std::map<std::string, double> getParameterValues() const override {
+        return {{"strength", strength}};
+    }
+
     bool setParameter(const std::string& paramName, const std::string& value) override {
         try {
             if (paramName == "strength") {
                 double val = std::stod(value);
                 if (val >= 0.0) {
                     strength = val;
+                    kernel.release();
                     return true;
                 }
             }
@@ -73,6 +87,10 @@ public:
     std::unique_ptr<Treatment> clone() const override {
         return std::make_unique<SharpenTreatment>(strength);
     }
+
+    int getBorderRadius() const override {
+        return 1;  // 3x3 kernel
+    }
 };
 
 #endif // SHARPEN_TREATMENT_H
@@ -20,8 +20,20 @@ public:
     ThresholdTreatment(double thresh = 127.0, double maxVal = 255.0, int type = cv::THRESH_BINARY)
         : thresholdValue(thresh), maxValue(maxVal), thresholdType(type) {}
 
+    ImageFormat prepare(const cv::Size& inputSize, int inputType) override {
+        if (CV_MAT_CN(inputType) == 3) {
+            return {inputSize, CV_MAKETYPE(CV_MAT_DEPTH(inputType), 1)};
+        }
+        return {inputSize, inputType};
+    }
+
     cv::Mat process(const cv::Mat& input) override {
         cv::Mat output;
+        processInto(input, output);
+        return output;
+    }
+
+    void processInto(const cv::Mat& input, cv::Mat& output) override {
         cv::Mat gray;
         
         // Convert to grayscale if needed
@@ -32,7 +44,6 @@ public:
         }
         
         cv::threshold(gray, output, thresholdValue, maxValue, thresholdType);
-        return output;
     }
 
     std::string getName() const override {
@@ -51,6 +62,10 @@ public:
         return params;
     }
 
+    std::map<std::string, double> getParameterValues() const override {
+        return {{"thresholdValue", thresholdValue}, {"maxValue", maxValue}, {"thresholdType", thresholdType}};
+    }
+
     bool setParameter(const std::string& paramName, const std::string& value) override {
         try {
             if (paramName == "thresholdValue") {
@@ -84,8 +99,35 @@ public:
         return std::make_unique<ThresholdTreatment>(thresholdValue, maxValue, thresholdType);
     }
 
-    bool validateInput(const cv::Mat& input) const override {
-        return !input.empty() && (input.channels() == 1 || input.channels() == 3);
+    FormatTraits getFormatTraits() const override {
+        FormatTraits traits;
+        traits.channels = {1, 3};
+        traits.lumaOnly = true;
+        return traits;
+    }
+
+    /**
+     * @brief Get the threshold value
+     * @return Threshold
+     */
+    double getThresholdValue() const {
+        return thresholdValue;
+    }
+
+    /**
+     * @brief Get the value given to pixels selected by the binary modes
+     * @return Maximum value
+     */
+    double getMaxValue() const {
+        return maxValue;
+    }
+
+    /**
+     * @brief Get the type of thresholding
+     * @return cv::ThresholdTypes value (0-4)
+     */
+    int getThresholdType() const {
+        return thresholdType;
     }
 };
 
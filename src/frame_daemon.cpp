@@ -0,0 +1,82 @@
+#include <iostream>
+#include <iomanip>
+#include <csignal>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include "SharedFrameTransport.h"
+
+// Daemon de traitement: execute la chaine de chaque client sur les images
+// qu'il depose en memoire partagee (voir SharedFrameTransport.h).
+//
+//   frame_daemon [nom du segment de controle] [periode du rapport en s]
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onSignal(int) {
+    stopRequested = 1;
+}
+
+// Helper function to print the statistics of every client
+void printClientStats(const shm_transport::FrameDaemon& daemon) {
+    std::vector<shm_transport::ClientStats> clients = daemon.getClientStats();
+    std::cout << "\n[INFO] " << daemon.getClientCount() << " client(s) connecte(s)\n";
+    for (const shm_transport::ClientStats& client : clients) {
+        std::cout << "  " << std::left << std::setw(24) << client.session << std::right
+                  << " pid " << std::setw(7) << client.pid
+                  << (client.connected ? "  connecte  " : "  parti     ")
+                  << std::setw(8) << client.frames << " images, "
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(7) << client.framesPerSecond() << " images/s, latence "
+                  << std::setprecision(2) << client.meanLatencyMs << " ms (max " << client.maxLatencyMs
+                  << "), chaine " << client.meanProcessMs << " ms";
+        if (client.failed > 0) {
+            std::cout << ", " << client.failed << " echec(s)";
+        }
+        std::cout << "\n    " << client.spec << "\n";
+        std::cout.unsetf(std::ios::fixed);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string name = argc > 1 ? argv[1] : shm_transport::DEFAULT_DAEMON_NAME;
+    int reportSeconds = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    try {
+        shm_transport::FrameDaemon daemon(name);
+        std::cout << "[OK] Daemon de traitement en attente de clients sur " << name << "\n";
+        std::cout << "Traitements disponibles:";
+        for (const std::string& treatment : ChainSpec::getTreatmentNames()) {
+            std::cout << " [" << treatment << "]";
+        }
+        std::cout << "\nCtrl+C pour arreter\n";
+
+        auto lastReport = std::chrono::steady_clock::now();
+        while (!stopRequested) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (std::chrono::steady_clock::now() - lastReport >= std::chrono::seconds(reportSeconds)) {
+                if (daemon.getClientCount() > 0) {
+                    printClientStats(daemon);
+                }
+                lastReport = std::chrono::steady_clock::now();
+            }
+        }
+        printClientStats(daemon);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERREUR] " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "\n[OK] Daemon arrete\n";
+    return 0;
+}
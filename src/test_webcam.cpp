@@ -8,6 +8,18 @@
 #include "ImageSource.h"
 #include "Treatment.h"
 #include "TreatmentChain.h"
+#include "StaticChain.h"
+#include "FormatPlanner.h"
+#include "FramePool.h"
+#include "FrameFile.h"
+#include "FrameRecording.h"
+#include "SyntheticImageSource.h"
+#include "VideoIO.h"
+#include "FrameParallelExecutor.h"
+#include "AsyncImageWriter.h"
+#include "ImagePyramid.h"
+#include "ChainSpec.h"
+#include "SharedFrameTransport.h"
 
 // Include all treatment implementations
 #include "treatments/GaussianBlurTreatment.h"
@@ -33,28 +45,152 @@ cv::Mat resizeForDisplay(const cv::Mat& img, int maxWidth = 1280, int maxHeight
         return img;
     }
     
-    // Calculate scaling factor to fit within max dimensions while maintaining aspect ratio
-    double scale = std::min(static_cast<double>(maxWidth) / width, 
-                           static_cast<double>(maxHeight) / height);
-    
-    int newWidth = static_cast<int>(width * scale);
-    int newHeight = static_cast<int>(height * scale);
-    
-    cv::Mat resized;
-    cv::resize(img, resized, cv::Size(newWidth, newHeight), 0, 0, cv::INTER_AREA);
-    return resized;
+    // Halve through the image's pyramid (its cached levels if one is attached), then resize by at most 2x
+    std::shared_ptr<ImagePyramid> pyramid = ImagePyramid::find(img);
+    if (!pyramid) {
+        pyramid = std::make_shared<ImagePyramid>(img);
+    }
+    return pyramid->fitTo(cv::Size(maxWidth, maxHeight));
+}
+
+// Helper function: encoding settings of the save menu choices
+EncodeOptions encodeOptionsFor(int choice) {
+    EncodeOptions options;
+    switch (choice) {
+        case 2:
+            options.jpegQuality = 80;
+            break;
+        case 3:
+            options.jpegOptimize = true;
+            break;
+        case 4:
+            options.encoding = ImageEncoding::Png;
+            options.pngCompression = 1;
+            break;
+        case 5:
+            options.encoding = ImageEncoding::Png;
+            options.pngCompression = 9;
+            break;
+        case 6:
+            options.encoding = ImageEncoding::Raw;
+            break;
+        default:
+            break;
+    }
+    return options;
+}
+
+// Helper function to report the files written by an AsyncImageWriter
+void printWriterStats(AsyncImageWriter& writer, const std::string& outputFile, const std::string& outputFolder) {
+    WriterStats stats = writer.getStats();
+    if (stats.failed > 0) {
+        for (const std::string& error : writer.takeErrors()) {
+            std::cout << "[ERREUR] " << error << "\n";
+        }
+        return;
+    }
+    std::cout << "[OK] Resultat sauvegarde dans: " << outputFile << "\n";
+    std::cout << "Dossier de sortie: " << outputFolder << "/\n";
+    std::cout << "  " << stats.bytesWritten / 1024 << " Ko, encodage " << stats.encodeMs << " ms ("
+              << stats.megapixelsPerSecond() << " Mpixels/s), ecriture " << stats.writeMs << " ms\n";
+}
+
+// Helper function to lay thumbnails side by side on one 8-bit color image
+cv::Mat thumbnailStrip(const std::vector<cv::Mat>& thumbnails) {
+    int width = 0;
+    int height = 0;
+    for (const cv::Mat& thumbnail : thumbnails) {
+        width += thumbnail.cols;
+        height = std::max(height, thumbnail.rows);
+    }
+    cv::Mat strip(height, width, CV_8UC3, cv::Scalar::all(0));
+    int x = 0;
+    for (const cv::Mat& thumbnail : thumbnails) {
+        cv::Mat bytes = thumbnail;
+        if (bytes.depth() != CV_8U) {
+            thumbnail.convertTo(bytes, CV_8U);
+        }
+        cv::Mat color = bytes;
+        if (bytes.channels() == 1) {
+            cv::cvtColor(bytes, color, cv::COLOR_GRAY2BGR);
+        } else if (bytes.channels() == 4) {
+            cv::cvtColor(bytes, color, cv::COLOR_BGRA2BGR);
+        }
+        color.copyTo(strip(cv::Rect(x, 0, color.cols, color.rows)));
+        x += color.cols;
+    }
+    return strip;
+}
+
+// Helper function to show the original and every intermediate result of a chain,
+// each in its window and side by side as thumbnails. Every step gets a shared
+// pyramid (ImagePyramid::attach), so its window and its thumbnail come from the
+// same cached levels; step 0 is the original frame itself when it is given, so
+// the levels its producer already attached are reused.
+void showIntermediates(const TreatmentChain& chain, const cv::Mat& original = cv::Mat()) {
+    std::cout << "\nAffichage de toutes les étapes:\n";
+
+    std::vector<std::shared_ptr<ImagePyramid>> pyramids;  // Keep the levels shared until the end
+    std::vector<cv::Mat> thumbnails;
+    for (size_t i = 0; i <= chain.getTreatmentCount(); i++) {
+        cv::Mat intermediate = (i == 0 && !original.empty()) ? original : chain.getIntermediateResult(i);
+
+        if (intermediate.empty()) {
+            std::cout << "  [WARNING] Etape " << i << " est vide!\n";
+            continue;
+        }
+
+        std::string windowName = "Etape " + std::to_string(i);
+        std::string description;
+
+        if (i == 0) {
+            windowName += " - Original";
+            description = "Original";
+        } else {
+            std::string treatmentName = chain.getTreatment(i - 1)->getName();
+            windowName += " - " + treatmentName;
+            description = treatmentName;
+        }
+
+        pyramids.push_back(ImagePyramid::attach(intermediate));
+        cv::imshow(windowName, resizeForDisplay(intermediate));
+        int channels = intermediate.channels();
+        if (channels == 1 || channels == 3 || channels == 4) {
+            thumbnails.push_back(pyramids.back()->fitTo(cv::Size(320, 180)));
+        }
+
+        std::cout << "  [OK] Etape " << i << ": " << description;
+        std::cout << " (" << intermediate.cols << "x" << intermediate.rows;
+        std::cout << ", " << intermediate.channels() << " canal(aux))\n";
+    }
+    if (!thumbnails.empty()) {
+        cv::imshow("Vignettes des etapes", thumbnailStrip(thumbnails));
+    }
+
+    std::cout << "\n[INFO] " << (chain.getTreatmentCount() + 1) << " fenetre(s) affichee(s)";
+    std::cout << " (Original + " << chain.getTreatmentCount() << " traitement(s))\n";
 }
 
 void testWebcam();
 void testTreatmentChain();
 void testImageFromFile();
 void testTreatmentFromFile();
+void benchmarkStaticChain();
+void testBandStreaming();
+void recordWebcam();
+void benchmarkReplay();
+void benchmarkSynthetic();
+void testVideoFile();
+void testFrameDaemon();
 
 int main() {
     std::cout << "\n==============================================================\n";
     std::cout << "        SYSTEME DE TRAITEMENT D'IMAGES - MENU DE TEST\n";
     std::cout << "==============================================================\n";
     
+    // Les tampons d'images sont réutilisés d'une image à l'autre
+    FramePool::global().install();
+    
     int choice;
     
     while (true) {
@@ -65,6 +201,13 @@ int main() {
         std::cout << "2. Tester la webcam avec traitement\n";
         std::cout << "3. Charger une image depuis un fichier\n";
         std::cout << "4. Traiter une image depuis un fichier\n";
+        std::cout << "5. Comparer StaticChain et TreatmentChain (benchmark)\n";
+        std::cout << "6. Traiter une image geante par bandes (PGM/PPM)\n";
+        std::cout << "7. Enregistrer la webcam (pour rejouer sans camera)\n";
+        std::cout << "8. Rejouer un enregistrement (benchmark)\n";
+        std::cout << "9. Source synthetique haute cadence (benchmark)\n";
+        std::cout << "10. Traiter une video (decodage, traitement et encodage en parallele)\n";
+        std::cout << "11. Client du daemon de traitement (memoire partagee, benchmark)\n";
         std::cout << "0. Quitter\n";
         std::cout << "\nVotre choix: ";
         
@@ -83,6 +226,27 @@ int main() {
             case 4:
                 testTreatmentFromFile();
                 break;
+            case 5:
+                benchmarkStaticChain();
+                break;
+            case 6:
+                testBandStreaming();
+                break;
+            case 7:
+                recordWebcam();
+                break;
+            case 8:
+                benchmarkReplay();
+                break;
+            case 9:
+                benchmarkSynthetic();
+                break;
+            case 10:
+                testVideoFile();
+                break;
+            case 11:
+                testFrameDaemon();
+                break;
             case 0:
                 std::cout << "\nAu revoir!\n";
                 return 0;
@@ -169,6 +333,9 @@ void testTreatmentChain() {
     
     std::cout << "[OK] Image capturee: " << frame.cols << "x" << frame.rows << std::endl;
     
+    // Pyramide partagee par l'affichage et la vignette de l'image capturee
+    std::shared_ptr<ImagePyramid> pyramid = ImagePyramid::attach(frame);
+    
     // Créer une chaîne de traitements prédéfinie
     TreatmentChain chain;
     
@@ -188,18 +355,7 @@ void testTreatmentChain() {
     cv::Mat result = chain.processChain(frame);
     
     // Afficher les résultats intermédiaires
-    std::cout << "\n--- Affichage des résultats intermédiaires ---\n";
-    for (size_t i = 0; i <= chain.getTreatmentCount(); i++) {
-        cv::Mat intermediate = chain.getIntermediateResult(i);
-        std::string windowName = "Étape " + std::to_string(i);
-        if (i == 0) {
-            windowName += " - Original";
-        } else {
-            windowName += " - " + chain.getTreatment(i - 1)->getName();
-        }
-        cv::imshow(windowName, resizeForDisplay(intermediate));
-        std::cout << "  " << windowName << " (" << intermediate.cols << "x" << intermediate.rows << ")\n";
-    }
+    showIntermediates(chain, frame);
     
     std::cout << "\nAppuyez sur une touche pour fermer...\n";
     cv::waitKey(0);
@@ -208,13 +364,9 @@ void testTreatmentChain() {
     // Créer le dossier "image" s'il n'existe pas
     std::string outputFolder = "image";
     
-    #ifdef _WIN32
-        std::string createDirCmd = "if not exist \"" + outputFolder + "\" mkdir \"" + outputFolder + "\"";
-        system(createDirCmd.c_str());
-    #else
-        std::string createDirCmd = "mkdir -p " + outputFolder;
-        system(createDirCmd.c_str());
-    #endif
+    if (!AsyncImageWriter::createDirectories(outputFolder)) {
+        std::cerr << "[ERREUR] Impossible de creer le dossier " << outputFolder << "\n";
+    }
     
     // Demander si on veut sauvegarder
     std::cout << "\nVoulez-vous sauvegarder le résultat? (o/n): ";
@@ -228,12 +380,10 @@ void testTreatmentChain() {
         ss << outputFolder << "/webcam_result_" << timestamp << ".jpg";
         std::string filename = ss.str();
         
-        if (cv::imwrite(filename, result)) {
-            std::cout << "[OK] Resultat sauvegarde dans: " << filename << "\n";
-            std::cout << "Dossier de sortie: " << outputFolder << "/\n";
-        } else {
-            std::cout << "[ERREUR] Erreur lors de la sauvegarde!\n";
-        }
+        AsyncImageWriter writer(1);
+        writer.write(filename, std::move(result));  // Not used afterwards: no copy
+        writer.flush();
+        printWriterStats(writer, filename, outputFolder);
     }
     
     std::cout << "[OK] Test termine!\n";
@@ -249,8 +399,11 @@ void testImageFromFile() {
     std::cin.ignore();
     std::getline(std::cin, filepath);
     
+    // L'image n'est qu'affichee: elle est decodee directement a la taille de l'ecran
     FileImageSource source(filepath);
+    source.setTargetSizeHint(cv::Size(1280, 720));
     
+    auto loadStart = std::chrono::steady_clock::now();
     if (!source.isAvailable()) {
         std::cerr << "[ERREUR] Impossible de charger l'image!\n";
         std::cerr << "Verifiez:\n";
@@ -267,7 +420,11 @@ void testImageFromFile() {
         return;
     }
     
-    std::cout << "[OK] Image chargee: " << image.cols << "x" << image.rows << std::endl;
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    
+    cv::Size fullSize = source.getFullSize();
+    std::cout << "[OK] Image chargee: " << fullSize.width << "x" << fullSize.height
+              << " (decodee en " << image.cols << "x" << image.rows << ", " << loadMs << " ms)" << std::endl;
     std::cout << "  Source: " << source.getDescription() << std::endl;
     std::cout << "  Type: " << (image.channels() == 1 ? "Grayscale" : "Color") << std::endl;
     
@@ -289,24 +446,33 @@ void testTreatmentFromFile() {
     std::cin.ignore();
     std::getline(std::cin, filepath);
     
+    // Apercu: l'image est decodee a la taille de l'ecran et la chaine y tourne avec
+    // des parametres reduits d'autant; la pleine resolution n'est calculee qu'a la sauvegarde
     FileImageSource source(filepath);
+    source.setTargetSizeHint(cv::Size(1280, 720));
     
     if (!source.isAvailable()) {
         std::cerr << "[ERREUR] Impossible de charger l'image!\n";
         return;
     }
     
-    cv::Mat image = source.getImage();
+    cv::Mat proxy = source.getImage();
     
-    if (image.empty()) {
+    if (proxy.empty()) {
         std::cerr << "[ERREUR] Image vide!\n";
         return;
     }
     
-    std::cout << "[OK] Image chargee: " << image.cols << "x" << image.rows << std::endl;
+    // Pyramide partagee de l'apercu: son affichage et sa vignette reutilisent les memes niveaux
+    std::shared_ptr<ImagePyramid> proxyPyramid = ImagePyramid::attach(proxy);
+    
+    cv::Size fullSize = source.getFullSize();
+    double proxyScale = static_cast<double>(proxy.cols) / fullSize.width;
+    std::cout << "[OK] Image chargee: " << fullSize.width << "x" << fullSize.height
+              << " (apercu en " << proxy.cols << "x" << proxy.rows << ")" << std::endl;
     
     // Afficher l'image originale
-    cv::imshow("Original", resizeForDisplay(image));
+    cv::imshow("Original", resizeForDisplay(proxy));
     std::cout << "Image originale affichée. Appuyez sur une touche pour continuer...\n";
     cv::waitKey(0);
     cv::destroyAllWindows();
@@ -411,102 +577,627 @@ void testTreatmentFromFile() {
     std::cout << "           TRAITEMENT DE L'IMAGE\n";
     std::cout << "==========================================\n";
     
+    // Une seule conversion en niveaux de gris; l'avancer devant les filtres
+    // lineaires est plus rapide mais peut changer le resultat d'un niveau
+    std::cout << "\nConvertir en niveaux de gris avant les filtres lineaires (plus rapide, resultat a 1 niveau pres)? (o/n): ";
+    char hoist;
+    std::cin >> hoist;
+    try {
+        FormatPlanner planner;
+        planner.setHoistConversion(hoist == 'o' || hoist == 'O');
+        FormatPlan plan = planner.plan(chain, fullSize, proxy.type());
+        for (const std::string& change : plan.changes) {
+            std::cout << "[PLAN] " << change << "\n";
+        }
+        chain = std::move(plan.chain);
+    } catch (const std::exception& e) {
+        std::cout << "[ERREUR] Chaine incompatible avec l'image: " << e.what() << "\n";
+        return;
+    }
+    
     std::cout << "\nChaîne finale:\n";
     auto finalNames = chain.getTreatmentNames();
     for (size_t i = 0; i < finalNames.size(); i++) {
         std::cout << "  " << (i + 1) << ". " << finalNames[i] << "\n";
     }
     
-    std::cout << "\nApplication de " << chain.getTreatmentCount() << " traitement(s)...\n";
+    // Apercu sur l'image reduite, recalcule a chaque modification de parametre.
+    // Canny y garde son gradient: changer ses seuils ne refait que l'hysteresis.
+    TreatmentChain preview = chain.makeProxy(proxyScale);
+    for (size_t i = 0; i < preview.getTreatmentCount(); i++) {
+        preview.getTreatment(i)->setParameter("cacheGradient", "1");
+    }
+    while (true) {
+        auto previewStart = std::chrono::steady_clock::now();
+        try {
+            if (preview.processChain(proxy).empty()) {
+                std::cout << "[ERREUR] Le resultat est vide!\n";
+                return;
+            }
+        } catch (const std::exception& e) {
+            std::cout << "[ERREUR] Erreur lors du traitement: " << e.what() << "\n";
+            return;
+        }
+        double previewMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - previewStart).count();
+        
+        std::cout << "\n[APERCU] " << proxy.cols << "x" << proxy.rows << " calcule en " << previewMs << " ms\n";
+        showIntermediates(preview, proxy);
+        std::cout << "\nAppuyez sur une touche pour fermer les fenêtres...\n";
+        cv::waitKey(0);
+        cv::destroyAllWindows();
+        
+        std::cout << "\nModifier un parametre? (o/n): ";
+        char modify;
+        std::cin >> modify;
+        if (modify != 'o' && modify != 'O') {
+            break;
+        }
+        
+        std::cout << "Numero du traitement (1-" << chain.getTreatmentCount() << "): ";
+        size_t index;
+        std::cin >> index;
+        if (index < 1 || index > chain.getTreatmentCount()) {
+            std::cout << "[ERREUR] Numero invalide!\n";
+            continue;
+        }
+        
+        Treatment* treatment = chain.getTreatment(index - 1);
+        auto values = treatment->getParameters();
+        for (const auto& info : treatment->getParameterInfo()) {
+            std::cout << "  " << info.first << " = " << values[info.first] << "  (" << info.second << ")\n";
+        }
+        std::cout << "Nom du parametre: ";
+        std::string name;
+        std::cin >> name;
+        std::cout << "Nouvelle valeur: ";
+        std::string value;
+        std::cin >> value;
+        
+        if (treatment->setParameter(name, value)) {
+            // Les parametres spatiaux sont remis a l'echelle de l'apercu;
+            // les autres sont changes sur place, sans perdre le cache de l'etape
+            Treatment* previewed = preview.getTreatment(index - 1);
+            previewed->setParameter(name, value);
+            std::unique_ptr<Treatment> scaled = treatment->cloneScaled(proxyScale);
+            scaled->setParameter("cacheGradient", "1");
+            if (scaled->getParameters() != previewed->getParameters()) {
+                preview.removeTreatment(index - 1);
+                preview.insertTreatment(index - 1, std::move(scaled));
+            }
+            std::cout << "[OK] " << name << " = " << value << "\n";
+        } else {
+            std::cout << "[ERREUR] Parametre ou valeur invalide!\n";
+        }
+    }
     
-    cv::Mat result;
-    try {
-        result = chain.processChain(image);
+    // Créer le dossier "image" s'il n'existe pas
+    std::string outputFolder = "image";
+    
+    if (!AsyncImageWriter::createDirectories(outputFolder)) {
+        std::cerr << "[ERREUR] Impossible de creer le dossier " << outputFolder << "\n";
+    }
+    
+    // Demander si on veut sauvegarder
+    std::cout << "\nVoulez-vous sauvegarder le résultat final? (o/n): ";
+    char save;
+    std::cin >> save;
+    
+    if (save == 'o' || save == 'O') {
+        // Pleine resolution, avec les parametres d'origine
+        std::cout << "\nApplication de " << chain.getTreatmentCount() << " traitement(s) en pleine resolution ("
+                  << fullSize.width << "x" << fullSize.height << ")...\n";
+        source.setTargetSizeHint(cv::Size());
+        cv::Mat image = source.getImage();
         
-        if (result.empty()) {
-            std::cout << "[ERREUR] Le resultat est vide!\n";
+        cv::Mat result;
+        try {
+            auto fullStart = std::chrono::steady_clock::now();
+            result = chain.processChain(image);
+            
+            if (result.empty()) {
+                std::cout << "[ERREUR] Le resultat est vide!\n";
+                return;
+            }
+            
+            std::cout << "[OK] Traitement termine en "
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - fullStart).count()
+                      << " ms\n";
+            std::cout << "  Image resultante: " << result.cols << "x" << result.rows << "\n";
+        } catch (const std::exception& e) {
+            std::cout << "[ERREUR] Erreur lors du traitement: " << e.what() << "\n";
             return;
         }
         
-        std::cout << "[OK] Traitement termine!\n";
-        std::cout << "  Image resultante: " << result.cols << "x" << result.rows << "\n";
+        std::cout << "\nFormat:\n";
+        std::cout << "1. JPEG (qualite 95)\n";
+        std::cout << "2. JPEG rapide (qualite 80)\n";
+        std::cout << "3. JPEG optimise (qualite 95, plus petit, plus lent)\n";
+        std::cout << "4. PNG rapide (compression 1)\n";
+        std::cout << "5. PNG compact (compression 9)\n";
+        std::cout << "6. Brut (.frames, sans compression)\n";
+        std::cout << "Votre choix: ";
+        int format;
+        std::cin >> format;
+        EncodeOptions options = encodeOptionsFor(format);
+        
+        std::cout << "Sauvegarder aussi les etapes intermediaires (.frames)? (o/n): ";
+        char saveSteps;
+        std::cin >> saveSteps;
+        
+        // Générer un nom de fichier avec timestamp
+        auto now = std::chrono::system_clock::now();
+        auto timestamp = std::chrono::system_clock::to_time_t(now);
+        std::stringstream ss;
+        ss << outputFolder << "/result_" << timestamp << options.extension();
+        std::string outputFile = ss.str();
+        
+        // L'encodage se fait sur les threads d'écriture pendant la suite
+        AsyncImageWriter writer;
+        writer.write(outputFile, std::move(result), options);  // Not used afterwards: no copy
+
+        // Etapes intermediaires en trames brutes: relues sans decodage (FrameFileImageSource)
+        if (saveSteps == 'o' || saveSteps == 'O') {
+            std::stringstream framesName;
+            framesName << outputFolder << "/etapes_" << timestamp << ".frames";
+            try {
+                FrameFileWriter stepsWriter(framesName.str());
+                for (size_t i = 0; i <= chain.getTreatmentCount(); i++) {
+                    cv::Mat intermediate = chain.getIntermediateResult(i);
+                    if (!intermediate.empty()) {
+                        stepsWriter.write(intermediate);
+                    }
+                }
+                stepsWriter.close();
+                std::cout << "[OK] " << stepsWriter.getFrameCount() << " etape(s) sauvegardee(s) dans: "
+                          << framesName.str() << "\n";
+            } catch (const std::exception& e) {
+                std::cout << "[ERREUR] " << e.what() << "\n";
+            }
+        }
+        
+        writer.flush();
+        printWriterStats(writer, outputFile, outputFolder);
+    }
+    
+    std::cout << "\n[OK] Test termine!\n";
+}
+
+void benchmarkStaticChain() {
+    std::cout << "\n==========================================\n";
+    std::cout << "   BENCHMARK: STATICCHAIN / TREATMENTCHAIN\n";
+    std::cout << "==========================================\n";
+    
+    std::cout << "\nEntrez le chemin du fichier image: ";
+    std::string filepath;
+    std::cin.ignore();
+    std::getline(std::cin, filepath);
+    
+    FileImageSource source(filepath);
+    
+    if (!source.isAvailable()) {
+        std::cerr << "[ERREUR] Impossible de charger l'image!\n";
+        return;
+    }
+    
+    cv::Mat image = source.getImage();
+    std::cout << "[OK] Image chargee: " << image.cols << "x" << image.rows << std::endl;
+    
+    // Même préréglage: types et paramètres fixés à la compilation d'un côté, chaîne dynamique de l'autre
+    StaticChain<GrayscaleTreatment, GaussianBlurTreatment, FixedBrightnessTreatment<150, -20>, FixedThresholdTreatment<127>> fixedChain;
+    TreatmentChain dynamicChain = fixedChain.toTreatmentChain();
+    dynamicChain.setRecordIntermediates(false);
+    
+    const int runs = 50;
+    auto timePerFrame = [&](auto&& processFrame) {
+        processFrame();  // Préchauffage
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; i++) {
+            processFrame();
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / runs;
+    };
+    
+    cv::Mat staticResult, dynamicResult;
+    try {
+        double staticMs = timePerFrame([&]() { staticResult = fixedChain.process(image); });
+        double dynamicMs = timePerFrame([&]() { dynamicResult = dynamicChain.processChain(image); });
+        
+        std::cout << "\nChaine: Grayscale -> Gaussian Blur (5) -> Brightness/Contrast (1.5, -20) -> Threshold (127)\n";
+        std::cout << "  TreatmentChain: " << dynamicMs << " ms/image\n";
+        std::cout << "  StaticChain:    " << staticMs << " ms/image";
+        std::cout << " (x" << dynamicMs / staticMs << ")\n";
+        std::cout << "  Resultats identiques: "
+                  << (cv::norm(staticResult, dynamicResult, cv::NORM_INF) == 0 ? "oui" : "NON") << "\n";
+        
+        FramePoolStats pool = FramePool::global().getStats();
+        std::cout << "\nPool d'images: " << pool.hitRate() * 100 << "% de tampons reutilises, "
+                  << pool.systemAllocations << " allocations systeme, "
+                  << pool.bytesHeld / (1024 * 1024) << " Mo en reserve, pic "
+                  << pool.highWaterMark / (1024 * 1024) << " Mo\n";
     } catch (const std::exception& e) {
         std::cout << "[ERREUR] Erreur lors du traitement: " << e.what() << "\n";
         return;
     }
     
-    // Afficher tous les résultats intermédiaires
+    std::cout << "\n[OK] Test termine!\n";
+}
+
+void testBandStreaming() {
     std::cout << "\n==========================================\n";
-    std::cout << "      RESULTATS INTERMEDIAIRES\n";
+    std::cout << "   TEST: TRAITEMENT PAR BANDES (HORS MEMOIRE)\n";
     std::cout << "==========================================\n";
     
-    std::cout << "\nAffichage de toutes les étapes:\n";
+    std::cout << "\nEntrez le chemin de l'image (PGM/PPM binaire): ";
+    std::string inputPath;
+    std::cin.ignore();
+    std::getline(std::cin, inputPath);
     
-    for (size_t i = 0; i <= chain.getTreatmentCount(); i++) {
-        cv::Mat intermediate = chain.getIntermediateResult(i);
+    std::cout << "Entrez le chemin du fichier de sortie (.pgm/.ppm): ";
+    std::string outputPath;
+    std::getline(std::cin, outputPath);
+    
+    // Traitements de taille constante et à voisinage borné
+    TreatmentChain chain;
+    chain.addTreatment(std::make_unique<GaussianBlurTreatment>(5, 1.0, 1.0));
+    chain.addTreatment(std::make_unique<SharpenTreatment>());
+    
+    try {
+        PnmBandReader reader(inputPath);
+        PnmBandWriter writer(outputPath, reader.getMaxValue());
+        std::cout << "[OK] Image: " << reader.getSize().width << "x" << reader.getSize().height << "\n";
+        std::cout << "Chaine: Gaussian Blur (5) -> Sharpen, bandes de 256 lignes\n";
         
-        if (intermediate.empty()) {
-            std::cout << "  [WARNING] Etape " << i << " est vide!\n";
-            continue;
-        }
+        auto start = std::chrono::steady_clock::now();
+        chain.processBands(reader, writer, 256);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
         
-        std::string windowName = "Etape " + std::to_string(i);
-        std::string description;
+        std::cout << "[OK] Image ecrite: " << outputPath << " en " << elapsed.count() << " s\n";
+        std::cout << "  Memoire de travail maximale: "
+                  << chain.getMemoryUsage().peak / (1024 * 1024) << " Mo\n";
+    } catch (const std::exception& e) {
+        std::cout << "[ERREUR] " << e.what() << "\n";
+        return;
+    }
+    
+    std::cout << "\n[OK] Test termine!\n";
+}
+
+void recordWebcam() {
+    std::cout << "\n==========================================\n";
+    std::cout << "   ENREGISTREMENT: WEBCAM -> TRAMES BRUTES\n";
+    std::cout << "==========================================\n";
+    
+    std::cout << "\nQuel device ID utiliser pour la webcam? (généralement 0 ou 1): ";
+    int deviceId;
+    std::cin >> deviceId;
+    
+    std::cout << "Nombre d'images a enregistrer: ";
+    int frameCount;
+    std::cin >> frameCount;
+    
+    std::cout << "Entrez le chemin de l'enregistrement (.frames): ";
+    std::string outputPath;
+    std::cin.ignore();
+    std::getline(std::cin, outputPath);
+    
+    WebcamImageSource webcam(deviceId);
+    
+    if (!webcam.isAvailable()) {
+        std::cerr << "[ERREUR] Webcam non disponible!\n";
+        return;
+    }
+    
+    try {
+        RecordingImageSource recorder(webcam, outputPath);
+        std::cout << "[OK] " << recorder.getDescription() << "\n";
+        std::cout << "Enregistrement en cours (Echap pour arreter)...\n";
         
-        if (i == 0) {
-            windowName += " - Original";
-            description = "Original";
-        } else {
-            std::string treatmentName = chain.getTreatment(i - 1)->getName();
-            windowName += " - " + treatmentName;
-            description = treatmentName;
+        while (static_cast<int>(recorder.getFrameCount()) < frameCount) {
+            cv::Mat frame = recorder.getImage();
+            if (frame.empty()) {
+                std::cout << "[WARNING] Image vide, enregistrement arrete\n";
+                break;
+            }
+            cv::imshow("Enregistrement", resizeForDisplay(frame));
+            if (cv::waitKey(1) == 27) {
+                break;
+            }
         }
+        cv::destroyAllWindows();
+        recorder.close();
+        std::cout << "[OK] " << recorder.getFrameCount() << " image(s) enregistree(s) dans: " << outputPath << "\n";
+    } catch (const std::exception& e) {
+        std::cout << "[ERREUR] " << e.what() << "\n";
+        return;
+    }
+    
+    std::cout << "\n[OK] Test termine!\n";
+}
+
+void benchmarkReplay() {
+    std::cout << "\n==========================================\n";
+    std::cout << "   BENCHMARK: REJEU D'UN ENREGISTREMENT\n";
+    std::cout << "==========================================\n";
+    
+    std::cout << "\nEntrez le chemin de l'enregistrement (.frames): ";
+    std::string inputPath;
+    std::cin.ignore();
+    std::getline(std::cin, inputPath);
+    
+    // Même chaîne que le test webcam avec traitement
+    TreatmentChain chain;
+    chain.addTreatment(std::make_unique<GrayscaleTreatment>());
+    chain.addTreatment(std::make_unique<GaussianBlurTreatment>(5, 1.0, 1.0));
+    chain.addTreatment(std::make_unique<CannyEdgeTreatment>(50, 150, 3));
+    chain.setRecordIntermediates(false);
+    
+    try {
+        ReplayImageSource replay(inputPath);
+        if (!replay.isAvailable()) {
+            std::cerr << "[ERREUR] Enregistrement vide!\n";
+            return;
+        }
+        std::cout << "[OK] " << replay.getDescription() << ", " << replay.getDuration() << " s\n";
+        std::cout << "Chaine: Grayscale -> Gaussian Blur (5) -> Canny (50, 150)\n";
         
-        cv::imshow(windowName, resizeForDisplay(intermediate));
+        // Débit: les images sont servies sans attente
+        auto start = std::chrono::steady_clock::now();
+        size_t processed = 0;
+        for (cv::Mat frame = replay.getImage(); !frame.empty(); frame = replay.getImage()) {
+            chain.processChain(frame);
+            processed++;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "\nSans cadence: " << processed << " images en " << elapsed.count() << " s ("
+                  << processed / elapsed.count() << " images/s)\n";
         
-        std::cout << "  [OK] Etape " << i << ": " << description;
-        std::cout << " (" << intermediate.cols << "x" << intermediate.rows;
-        std::cout << ", " << intermediate.channels() << " canal(aux))\n";
+        // Temps réel: cadence d'origine, les images manquées sont sautées comme avec la camera
+        replay.rewind();
+        replay.setPacing(ReplayPacing::RealTime);
+        replay.setDropLateFrames(true);
+        double worstMs = 0.0;
+        processed = 0;
+        for (cv::Mat frame = replay.getImage(); !frame.empty(); frame = replay.getImage()) {
+            auto frameStart = std::chrono::steady_clock::now();
+            chain.processChain(frame);
+            std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - frameStart;
+            worstMs = std::max(worstMs, latency.count());
+            processed++;
+        }
+        std::cout << "Temps reel:   " << processed << " images traitees, " << replay.getDroppedFrames()
+                  << " sautee(s), latence maximale " << worstMs << " ms\n";
+    } catch (const std::exception& e) {
+        std::cout << "[ERREUR] " << e.what() << "\n";
+        return;
     }
     
-    std::cout << "\n[INFO] " << (chain.getTreatmentCount() + 1) << " fenetre(s) affichee(s)";
-    std::cout << " (Original + " << chain.getTreatmentCount() << " traitement(s))\n";
+    std::cout << "\n[OK] Test termine!\n";
+}
+
+void benchmarkSynthetic() {
+    std::cout << "\n==========================================\n";
+    std::cout << "   BENCHMARK: SOURCE SYNTHETIQUE\n";
+    std::cout << "==========================================\n";
     
-    std::cout << "\nAppuyez sur une touche pour fermer les fenêtres...\n";
-    cv::waitKey(0);
-    cv::destroyAllWindows();
+    std::cout << "\nResolution:\n";
+    std::cout << "1. 1920x1080\n";
+    std::cout << "2. 3840x2160 (4K)\n";
+    std::cout << "3. 7680x4320 (8K)\n";
+    std::cout << "Votre choix: ";
+    int resolution;
+    std::cin >> resolution;
+    cv::Size size = resolution == 3 ? cv::Size(7680, 4320)
+                  : resolution == 2 ? cv::Size(3840, 2160)
+                  : cv::Size(1920, 1080);
+    
+    std::cout << "\nContenu:\n";
+    std::cout << "1. Bruit\n";
+    std::cout << "2. Degrades\n";
+    std::cout << "3. Formes en mouvement\n";
+    std::cout << "4. Scene statique (petits changements)\n";
+    std::cout << "Votre choix: ";
+    int contentChoice;
+    std::cin >> contentChoice;
+    SyntheticContent content = contentChoice == 1 ? SyntheticContent::Noise
+                             : contentChoice == 2 ? SyntheticContent::Gradient
+                             : contentChoice == 4 ? SyntheticContent::StaticScene
+                             : SyntheticContent::MovingShapes;
+    
+    // Même chaîne que le test webcam avec traitement
+    TreatmentChain chain;
+    chain.addTreatment(std::make_unique<GrayscaleTreatment>());
+    chain.addTreatment(std::make_unique<GaussianBlurTreatment>(5, 1.0, 1.0));
+    chain.addTreatment(std::make_unique<CannyEdgeTreatment>(50, 150, 3));
+    chain.setRecordIntermediates(false);
+    
+    try {
+        SyntheticImageSource source(size, CV_8UC3, content);
+        std::cout << "[OK] " << source.getDescription() << "\n";
+        std::cout << "Chaine: Grayscale -> Gaussian Blur (5) -> Canny (50, 150)\n";
+        
+        const int frames = 200;
+        double sourceMs = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++) {
+            auto frameStart = std::chrono::steady_clock::now();
+            cv::Mat frame = source.getImage();
+            sourceMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+            chain.processChain(frame);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        
+        std::cout << "\n" << frames << " images en " << elapsed.count() << " s ("
+                  << frames / elapsed.count() << " images/s)\n";
+        std::cout << "  Source: " << sourceMs / frames << " ms/image\n";
+        std::cout << "  Chaine: " << (elapsed.count() * 1000.0 - sourceMs) / frames << " ms/image\n";
+    } catch (const std::exception& e) {
+        std::cout << "[ERREUR] " << e.what() << "\n";
+        return;
+    }
+    
+    std::cout << "\n[OK] Test termine!\n";
+}
+
+void testVideoFile() {
+    std::cout << "\n==========================================\n";
+    std::cout << "   TEST: TRAITEMENT D'UNE VIDEO\n";
+    std::cout << "==========================================\n";
     
     // Créer le dossier "image" s'il n'existe pas
     std::string outputFolder = "image";
     
-    #ifdef _WIN32
-        std::string createDirCmd = "if not exist \"" + outputFolder + "\" mkdir \"" + outputFolder + "\"";
-        system(createDirCmd.c_str());
-    #else
-        std::string createDirCmd = "mkdir -p " + outputFolder;
-        system(createDirCmd.c_str());
-    #endif
+    if (!AsyncImageWriter::createDirectories(outputFolder)) {
+        std::cerr << "[ERREUR] Impossible de creer le dossier " << outputFolder << "\n";
+    }
     
-    // Demander si on veut sauvegarder
-    std::cout << "\nVoulez-vous sauvegarder le résultat final? (o/n): ";
-    char save;
-    std::cin >> save;
+    std::cout << "\nEntrez le chemin de la video (vide pour generer un clip de test): ";
+    std::string inputPath;
+    std::cin.ignore();
+    std::getline(std::cin, inputPath);
     
-    if (save == 'o' || save == 'O') {
-        // Générer un nom de fichier avec timestamp
-        auto now = std::chrono::system_clock::now();
-        auto timestamp = std::chrono::system_clock::to_time_t(now);
-        std::stringstream ss;
-        ss << outputFolder << "/result_" << timestamp << ".jpg";
-        std::string outputFile = ss.str();
+    try {
+        if (inputPath.empty()) {
+            // Clip de test: 5 s de formes en mouvement, 1280x720 a 30 images/s
+            inputPath = outputFolder + "/clip_test.avi";
+            SyntheticImageSource synthetic(cv::Size(1280, 720), CV_8UC3, SyntheticContent::MovingShapes);
+            VideoFileSink clip(inputPath, 30.0);
+            for (int i = 0; i < 150; i++) {
+                clip.write(synthetic.getImage());
+            }
+            clip.close();
+            std::cout << "[OK] Clip de test genere: " << inputPath << "\n";
+        }
         
-        if (cv::imwrite(outputFile, result)) {
-            std::cout << "[OK] Resultat sauvegarde dans: " << outputFile << "\n";
-            std::cout << "Dossier de sortie: " << outputFolder << "/\n";
-        } else {
-            std::cout << "[ERREUR] Erreur lors de la sauvegarde!\n";
+        VideoFileImageSource source(inputPath);
+        if (!source.isAvailable()) {
+            std::cerr << "[ERREUR] Impossible d'ouvrir la video!\n";
+            return;
+        }
+        std::cout << "[OK] " << source.getDescription() << "\n";
+        
+        TreatmentChain chain;
+        chain.addTreatment(std::make_unique<GaussianBlurTreatment>(5, 1.0, 1.0));
+        chain.addTreatment(std::make_unique<CannyEdgeTreatment>(50, 150, 3));
+        chain.setRecordIntermediates(false);
+        std::cout << "Chaine: Gaussian Blur (5) -> Canny (50, 150)\n";
+        
+        auto timestamp = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::string outputPath = outputFolder + "/video_result_" + std::to_string(timestamp) + ".avi";
+        VideoFileSink sink(outputPath, source.getFps() > 0.0 ? source.getFps() : 30.0);
+        
+        VideoPipelineStats stats = VideoPipeline::run(source, chain, sink);
+        
+        std::cout << "\n[OK] Video ecrite: " << outputPath << "\n";
+        std::cout << "  " << stats.frames << " images en " << stats.seconds << " s ("
+                  << stats.fps() << " images/s de bout en bout)\n";
+        if (stats.frames > 0) {
+            std::cout << "  Traitement: " << stats.processMs / stats.frames << " ms/image\n";
+            std::cout << "  Attente du decodage: " << stats.decodeWaitMs / stats.frames << " ms/image\n";
+            std::cout << "  Attente de l'encodage: " << stats.encodeWaitMs / stats.frames << " ms/image\n";
+        }
+        if (sink.getFramesDuplicated() > 0) {
+            std::cout << "  " << sink.getFramesDuplicated() << " image(s) repetee(s) pour conserver la cadence\n";
         }
+        
+        // Même vidéo, une image par coeur: les résultats sont réordonnés avant l'encodage
+        VideoFileImageSource parallelSource(inputPath);
+        std::string parallelPath = outputFolder + "/video_result_" + std::to_string(timestamp) + "_parallele.avi";
+        VideoFileSink parallelSink(parallelPath, source.getFps() > 0.0 ? source.getFps() : 30.0);
+        VideoPipelineStats parallel = FrameParallelExecutor::run(parallelSource, chain, parallelSink);
+        
+        std::cout << "\n[OK] Video ecrite: " << parallelPath << "\n";
+        std::cout << "  " << parallel.frames << " images en " << parallel.seconds << " s ("
+                  << parallel.fps() << " images/s avec " << std::max(1u, std::thread::hardware_concurrency())
+                  << " workers, x" << (stats.seconds > 0.0 && parallel.seconds > 0.0 ? stats.seconds / parallel.seconds : 0.0)
+                  << ")\n";
+    } catch (const std::exception& e) {
+        std::cout << "[ERREUR] " << e.what() << "\n";
+        return;
+    }
+    
+    std::cout << "\n[OK] Test termine!\n";
+}
+
+void testFrameDaemon() {
+    std::cout << "\n==========================================\n";
+    std::cout << "   CLIENT DU DAEMON DE TRAITEMENT\n";
+    std::cout << "==========================================\n";
+    
+#if IT_SHM_TRANSPORT
+    // Même chaîne par défaut que le benchmark de la source synthétique
+    TreatmentChain defaultChain;
+    defaultChain.addTreatment(std::make_unique<GrayscaleTreatment>());
+    defaultChain.addTreatment(std::make_unique<GaussianBlurTreatment>(5, 1.0, 1.0));
+    defaultChain.addTreatment(std::make_unique<CannyEdgeTreatment>(50, 150, 3));
+    
+    std::cout << "\nLancez d'abord le daemon: frame_daemon\n";
+    std::cout << "Spec de la chaine (Entree = Grayscale | Gaussian Blur | Canny Edge Detection):\n";
+    std::cout << "Exemple: Median Blur(kernelSize=5) | Mosaic Effect(blockSize=16)\n> ";
+    std::string spec;
+    std::cin.ignore();
+    std::getline(std::cin, spec);
+    if (spec.find_first_not_of(" \t") == std::string::npos) {
+        spec = ChainSpec::toString(defaultChain);
+    }
+    
+    const cv::Size size(1920, 1080);
+    const int frames = 300;
+    const uint32_t slotCount = 4;  // Puissance de deux
+    const uint32_t inFlight = slotCount - 1;
+    
+    try {
+        shm_transport::SharedFrameClient client(spec, static_cast<size_t>(size.area()) * 3, slotCount);
+        std::cout << "[OK] Chaine acceptee par le daemon: " << spec << "\n";
+        
+        SyntheticImageSource source(size, CV_8UC3, SyntheticContent::MovingShapes);
+        double worstMs = 0.0, totalMs = 0.0, processMs = 0.0;
+        int received = 0, failed = 0;
+        std::string lastError;
+        
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames || client.getInFlight() > 0; ) {
+            if (i < frames && client.getInFlight() < inFlight) {
+                // Image générée directement dans le segment partagé, traitée sur place par le daemon
+                cv::Mat slot = client.acquire(size, CV_8UC3);
+                source.renderInto(slot);
+                client.submit(i);
+                i++;
+                continue;
+            }
+            shm_transport::SharedFrame result;
+            client.receive(result);
+            if (result.failed) {
+                failed++;
+                lastError = result.error;
+            }
+            worstMs = std::max(worstMs, result.latencyMs);
+            totalMs += result.latencyMs;
+            processMs += result.processMs;
+            received++;
+            client.release();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        
+        std::cout << "\n" << received << " images en " << elapsed.count() << " s ("
+                  << received / elapsed.count() << " images/s, " << inFlight << " en vol)\n";
+        std::cout << "  Latence:  " << totalMs / received << " ms/image (max " << worstMs << " ms)\n";
+        std::cout << "  Chaine:   " << processMs / received << " ms/image dans le daemon\n";
+        if (failed > 0) {
+            std::cout << "  [ERREUR] " << failed << " image(s) en echec: " << lastError << "\n";
+        }
+        
+        shm_transport::ClientStats stats = client.getStats();
+        std::cout << "  Vu par le daemon: " << stats.frames << " images, " << stats.framesPerSecond()
+                  << " images/s, latence " << stats.meanLatencyMs << " ms (max " << stats.maxLatencyMs << " ms)\n";
+    } catch (const std::exception& e) {
+        std::cout << "[ERREUR] " << e.what() << "\n";
+        return;
     }
     
     std::cout << "\n[OK] Test termine!\n";
+#else
+    std::cout << "[ERREUR] Le transport en memoire partagee demande un systeme POSIX (Linux, macOS)\n";
+#endif
 }